@@ -0,0 +1,22 @@
+var common = require('../common.js');
+
+var bench = common.createBenchmark(main, {
+  len: [64, 1024, 16 * 1024],
+  n: [1e5]
+});
+
+function main(conf) {
+  var len = conf.len | 0;
+  var n = conf.n | 0;
+  var buf = Buffer(len);
+
+  for (var i = 0; i < buf.length; i++)
+    buf[i] = i & 0xff;
+
+  bench.start();
+
+  for (var i = 0; i < n; i += 1)
+    Buffer(buf.toString('hex'), 'hex');
+
+  bench.end(n);
+}
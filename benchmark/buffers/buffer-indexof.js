@@ -0,0 +1,20 @@
+var common = require('../common.js');
+
+var bench = common.createBenchmark(main, {
+  size: [1024, 64 * 1024, 1024 * 1024],
+  needle: ['buffer', 'string'],
+  n: [1e4]
+});
+
+function main(conf) {
+  var size = conf.size | 0;
+  var n = conf.n | 0;
+  var haystack = new Buffer(size).fill('x');
+  haystack.write('ab', size - 2);
+  var needle = conf.needle === 'buffer' ? new Buffer('ab') : 'ab';
+
+  bench.start();
+  for (var i = 0; i < n; i++)
+    haystack.indexOf(needle);
+  bench.end(n);
+}
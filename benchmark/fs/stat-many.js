@@ -0,0 +1,65 @@
+// Stats per second, over the files in lib/: one fs.stat() per file, or one
+// fs.statMany() per batch of files.
+var common = require('../common.js');
+var fs = require('fs');
+var path = require('path');
+
+var bench = common.createBenchmark(main, {
+  api: ['stat', 'statMany'],
+  dur: [5]
+});
+
+var dir = path.resolve(__dirname, '../../lib');
+var paths = fs.readdirSync(dir).map(function(name) {
+  return path.join(dir, name);
+});
+
+function main(conf) {
+  var dur = +conf.dur;
+  var stats = 0;
+  var go = true;
+
+  setTimeout(function() {
+    go = false;
+  }, dur * 1000);
+
+  bench.start();
+  if (conf.api === 'stat')
+    statEach();
+  else
+    statMany();
+
+  function done() {
+    if (go)
+      return false;
+    bench.end(stats);
+    return true;
+  }
+
+  function statEach() {
+    var pending = paths.length;
+    paths.forEach(function(p) {
+      fs.stat(p, function(err, st) {
+        if (err)
+          throw err;
+        stats++;
+        if (--pending === 0 && !done())
+          statEach();
+      });
+    });
+  }
+
+  function statMany() {
+    fs.statMany(paths, function(err, results) {
+      if (err)
+        throw err;
+      for (var i = 0; i < results.length; i++) {
+        if (results.error(i))
+          throw results.error(i);
+      }
+      stats += results.length;
+      if (!done())
+        statMany();
+    });
+  }
+}
@@ -0,0 +1,76 @@
+// Startup time of a node that loads a good part of lib/, without and with
+// the on-disk code cache (--code-cache-dir). 'warm' fills the cache first,
+// the way the runs of a fuzzing campaign after the first one see it.
+var common = require('../common.js');
+var spawn = require('child_process').spawn;
+var spawnSync = require('child_process').spawnSync;
+var fs = require('fs');
+var path = require('path');
+
+var tmpDirectory = path.join(__dirname, '..', 'tmp');
+var cacheDirectory = path.join(tmpDirectory, 'nodejs-benchmark-code-cache');
+
+var script = [
+  'child_process', 'cluster', 'dgram', 'dns', 'http', 'net', 'readline',
+  'repl', 'stream', 'url', 'util', 'zlib'
+].map(function(name) {
+  return 'require("' + name + '");';
+}).join('');
+
+var bench = common.createBenchmark(main, {
+  cache: ['none', 'warm'],
+  dur: [1]
+});
+
+function main(conf) {
+  var args = ['-e', script];
+
+  if (conf.cache === 'warm') {
+    rmrf(cacheDirectory);
+    try { fs.mkdirSync(tmpDirectory); } catch (e) {}
+    fs.mkdirSync(cacheDirectory);
+    args.unshift('--code-cache-dir=' + cacheDirectory);
+    var warmup = spawnSync(process.execPath, args);
+    if (warmup.status !== 0)
+      throw new Error('Error during node startup');
+  }
+
+  var dur = +conf.dur;
+  var go = true;
+  var starts = 0;
+
+  setTimeout(function() {
+    go = false;
+  }, dur * 1000);
+
+  bench.start();
+  start();
+
+  function start() {
+    var node = spawn(process.execPath, args);
+    node.on('exit', function(exitCode) {
+      if (exitCode !== 0) {
+        throw new Error('Error during node startup');
+      }
+      starts++;
+
+      if (go) {
+        start();
+      } else {
+        rmrf(cacheDirectory);
+        bench.end(starts);
+      }
+    });
+  }
+}
+
+function rmrf(location) {
+  try {
+    fs.readdirSync(location).forEach(function(thing) {
+      fs.unlinkSync(path.join(location, thing));
+    });
+    fs.rmdirSync(location);
+  } catch (err) {
+    // Ignore error
+  }
+}
@@ -0,0 +1,101 @@
+// Runs of "node -e 0" per second: spawned from scratch, or forked from a
+// fork server that has already bootstrapped (NODE_FORK_SERVER_POINT=bootstrap).
+// Linux only for the fork server. Speaks the protocol described in
+// deps/uv/src/unix/fork-server.c, on a little-endian host.
+var common = require('../common.js');
+var spawn = require('child_process').spawn;
+
+var bench = common.createBenchmark(main, {
+  mode: ['spawn', 'fork-server'],
+  dur: [1]
+});
+
+function main(conf) {
+  var dur = +conf.dur;
+  var go = true;
+
+  setTimeout(function() {
+    go = false;
+  }, dur * 1000);
+
+  if (conf.mode === 'spawn')
+    spawnLoop(function() { return go; });
+  else
+    forkServerLoop(function() { return go; });
+}
+
+function spawnLoop(go) {
+  var env = Object.assign({}, process.env, { UV_SILENT: '1' });
+  var starts = 0;
+
+  bench.start();
+  start();
+
+  function start() {
+    var node = spawn(process.execPath, ['-e', '0'], { env: env });
+    node.on('exit', function(exitCode) {
+      if (exitCode !== 0) {
+        throw new Error('Error during node startup');
+      }
+      starts++;
+
+      if (go())
+        start();
+      else
+        bench.end(starts);
+    });
+  }
+}
+
+function forkServerLoop(go) {
+  var env = Object.assign({}, process.env, {
+    UV_SILENT: '1',
+    UV_FORK_SERVER_FD: '3',
+    NODE_FORK_SERVER_POINT: 'bootstrap'
+  });
+  var server = spawn(process.execPath, ['-e', '0'], {
+    env: env,
+    stdio: ['ignore', 'ignore', 'inherit', 'pipe', 'pipe']
+  });
+  var control = server.stdio[3];
+  var status = server.stdio[4];
+  var pending = new Buffer(0);
+  var ready = false;
+  var starts = 0;
+
+  status.on('data', function(data) {
+    pending = Buffer.concat([pending, data]);
+
+    if (!ready) {
+      // int32 0 once the server is up.
+      if (pending.length < 4)
+        return;
+      pending = pending.slice(4);
+      ready = true;
+      bench.start();
+      request();
+      return;
+    }
+
+    // int32 pid, int32 status, uint64 hash per run.
+    if (pending.length < 16)
+      return;
+    if (pending.readInt32LE(4) !== 0)
+      throw new Error('Error during node startup');
+    pending = pending.slice(16);
+    starts++;
+
+    if (go()) {
+      request();
+    } else {
+      control.end();
+      bench.end(starts);
+    }
+  });
+
+  function request() {
+    var seed = new Buffer(4);
+    seed.writeUInt32LE(starts + 1, 0);
+    control.write(seed);
+  }
+}
@@ -0,0 +1,97 @@
+#!/bin/sh
+
+# Run the benchmarks under each scheduler, with fixed seeds, and print the
+# results as CSV on stdout:
+#
+#   scheduler,seed,benchmark,status,key,value
+#
+# Every benchmark gets a wall_ms row. The sched_* benchmarks
+# (test/benchmark-scheduler.c) add a row per key=value they print, e.g.
+# ns_per_op. status is "ok" or "fail".
+#
+# Usage: ./benchmark-matrix.sh [benchmark...]
+#
+# Build run-benchmarks first (./gyp_uv.py -f make && make -C out).
+# Environment:
+#   RUN_BENCHMARKS  Path to run-benchmarks. Default out/Debug/run-benchmarks.
+#   SCHEDULERS      Default "VANILLA FUZZING_TIME TP_FREEDOM".
+#   SEEDS           Values for UV_SCHEDULER_SEED. Default "1 2 3".
+#   The scheduler parameters below can be overridden as usual, e.g.
+#   UV_SCHEDULER_MAX_DELAY=1000 ./benchmark-matrix.sh sched_yield
+
+RUN_BENCHMARKS=${RUN_BENCHMARKS:-out/Debug/run-benchmarks}
+SCHEDULERS=${SCHEDULERS:-"VANILLA FUZZING_TIME TP_FREEDOM"}
+SEEDS=${SEEDS:-"1 2 3"}
+
+# Left out by default: fs_stat and million_timers outlast the runner's timeout
+# in a Debug build, and the async benchmarks expect async handles to keep the
+# loop alive, which they don't here. Name them to run them anyway.
+BENCHMARKS=${*:-"
+sched_yield
+sched_cb_dispatch
+sched_work_latency
+loop_count
+ping_pongs
+tcp_write_batch
+tcp4_pound_100
+pipe_pound_100
+udp_pummel_1v1
+getaddrinfo
+spawn
+thread_create
+"}
+
+FUZZING_TIME_ENV="
+UV_SCHEDULER_MIN_DELAY=${UV_SCHEDULER_MIN_DELAY:-0}
+UV_SCHEDULER_MAX_DELAY=${UV_SCHEDULER_MAX_DELAY:-100}
+UV_SCHEDULER_DELAY_PERC=${UV_SCHEDULER_DELAY_PERC:-1}
+"
+
+TP_FREEDOM_ENV="
+UV_THREADPOOL_SIZE=1
+UV_SCHEDULER_TP_DEG_FREEDOM=${UV_SCHEDULER_TP_DEG_FREEDOM:-5}
+UV_SCHEDULER_TP_MAX_DELAY=${UV_SCHEDULER_TP_MAX_DELAY:-100}
+UV_SCHEDULER_TP_EPOLL_THRESHOLD=${UV_SCHEDULER_TP_EPOLL_THRESHOLD:-100}
+UV_SCHEDULER_IOPOLL_DEG_FREEDOM=${UV_SCHEDULER_IOPOLL_DEG_FREEDOM:--1}
+UV_SCHEDULER_IOPOLL_DEFER_PERC=${UV_SCHEDULER_IOPOLL_DEFER_PERC:-10}
+UV_SCHEDULER_RUN_CLOSING_DEFER_PERC=${UV_SCHEDULER_RUN_CLOSING_DEFER_PERC:-10}
+"
+
+if [ ! -x "$RUN_BENCHMARKS" ]; then
+  echo "$0: $RUN_BENCHMARKS not found, build it first" >&2
+  exit 1
+fi
+
+now_ms() {
+  echo $(($(date +%s%N) / 1000000))
+}
+
+echo "scheduler,seed,benchmark,status,key,value"
+
+for scheduler in $SCHEDULERS; do
+  case $scheduler in
+    VANILLA)      scheduler_env= ;;
+    FUZZING_TIME) scheduler_env=$FUZZING_TIME_ENV ;;
+    TP_FREEDOM)   scheduler_env=$TP_FREEDOM_ENV ;;
+    *)            echo "$0: unsupported scheduler $scheduler" >&2; exit 1 ;;
+  esac
+
+  for seed in $SEEDS; do
+    for benchmark in $BENCHMARKS; do
+      start=$(now_ms)
+      output=$(env UV_SILENT=1 UV_PRINT_SUMMARY=0 \
+                   UV_SCHEDULER_TYPE=$scheduler UV_SCHEDULER_SEED=$seed \
+                   $scheduler_env "$RUN_BENCHMARKS" "$benchmark" 2>&1)
+      if [ $? -eq 0 ]; then status=ok; else status=fail; fi
+      end=$(now_ms)
+
+      prefix="$scheduler,$seed,$benchmark,$status"
+      echo "$prefix,wall_ms,$((end - start))"
+
+      # The line "<benchmark>: scheduler=... key=value ..." of a sched_* benchmark.
+      echo "$output" | grep "^$benchmark: scheduler=" | head -n 1 |
+        tr ' ' '\n' | grep '=' | grep -v '^scheduler=' |
+        sed "s/^\([^=]*\)=\(.*\)$/$prefix,\1,\2/"
+    done
+  done
+done
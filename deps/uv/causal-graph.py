@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+
+# Print a causal log (UV_CAUSAL_FILE, see src/causal.h) as a tree per thread:
+#
+#   <us> <tid> CB <cb type> <context> <provider>#<async id>
+#   <us> <tid>   PHASE <phase> #<async id>
+#   <us> <tid> DECISION <schedule point> <decision>
+#
+# A CB is attributed to the last uv_causal_tag of its handle or req.
+# Names of CB types and schedule points come from this tree's headers, and
+# of providers and phases from Node's (--node-src) if they are there.
+#
+# Usage: ./causal-graph.py [--node-src DIR] [--no-decisions] FILE
+
+import optparse
+import os
+import re
+import struct
+import sys
+
+HEADER = struct.Struct('=8sIi')
+RECORD = struct.Struct('=QQQQHHI')
+MAGIC = b'UVCAUSL1'
+
+(TAG, CB_BEGIN, CB_END, DECISION, PHASE_BEGIN, PHASE_END) = range(1, 7)
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def read(path):
+  with open(path) as f:
+    return f.read()
+
+
+def c_enum(path, name):
+  """The names of enum |name| in |path|, by value. Aliases are skipped."""
+  try:
+    text = read(path)
+  except IOError:
+    return {}
+  m = re.search(r'enum\s+%s\s*\{(.*?)\}' % name, text, re.S)
+  if m is None:
+    return {}
+  body = re.sub(r'/\*.*?\*/', '', m.group(1), flags=re.S)
+  names = {}
+  value = 0
+  for item in body.split(','):
+    m = re.match(r'\s*(\w+)\s*(?:=\s*(\w+))?\s*$', item)
+    if m is None:
+      continue
+    if m.group(2) is not None:
+      if not m.group(2).isdigit():
+        continue  # FOO_MIN = FOO
+      value = int(m.group(2))
+    names[value] = m.group(1)
+    value += 1
+  return names
+
+
+def node_list(path, macro):
+  """The V(NAME) entries of |macro| in |path|, by position."""
+  try:
+    text = read(path)
+  except IOError:
+    return {}
+  m = re.search(r'#define %s\(V\)((?:.*\\\n)*.*)' % macro, text)
+  if m is None:
+    return {}
+  return dict(enumerate(re.findall(r'V\((\w+)\)', m.group(1))))
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog [options] FILE')
+  parser.add_option('--node-src', default=os.path.join(HERE, '..', '..', 'src'),
+                    help='Node\'s src/, for provider and phase names')
+  parser.add_option('--no-decisions', action='store_true',
+                    help='leave out the scheduler\'s decisions')
+  options, args = parser.parse_args()
+  if len(args) != 1:
+    parser.error('expected one FILE')
+
+  cb_types = c_enum(os.path.join(HERE, 'src', 'unified-callback-enums.h'),
+                    'callback_type')
+  points = c_enum(os.path.join(HERE, 'src', 'scheduler.h'),
+                  'schedule_point_e')
+  providers = node_list(os.path.join(options.node_src, 'async-wrap.h'),
+                        'NODE_ASYNC_PROVIDER_TYPES')
+  phases = node_list(os.path.join(options.node_src, 'node_internals.h'),
+                     'NODE_FUZZ_PHASES')
+
+  with open(args[0], 'rb') as f:
+    data = f.read()
+  if len(data) < HEADER.size:
+    sys.exit('%s: too short' % args[0])
+  magic, record_size, pid = HEADER.unpack_from(data, 0)
+  if magic != MAGIC or record_size != RECORD.size:
+    sys.exit('%s: not a causal log of this version' % args[0])
+
+  tags = {}    # context -> (provider, async id)
+  depth = {}   # tid -> nesting
+  tids = {}    # tid -> small number, in order of appearance
+  out = sys.stdout
+  out.write('# pid %d\n' % pid)
+
+  offset = HEADER.size
+  while offset + RECORD.size <= len(data):
+    ts, tid, context, id, kind, type, _ = RECORD.unpack_from(data, offset)
+    offset += RECORD.size
+
+    if kind == TAG:
+      tags[context] = (type, id)
+      continue
+
+    t = tids.setdefault(tid, len(tids))
+    d = depth.get(tid, 0)
+    if kind in (CB_END, PHASE_END):
+      depth[tid] = max(d - 1, 0)
+      continue
+
+    prefix = '%12.3f %2d %s' % (ts / 1000.0, t, '  ' * d)
+    if kind == CB_BEGIN:
+      depth[tid] = d + 1
+      line = 'CB %s 0x%x' % (cb_types.get(type, type), context)
+      if context in tags:
+        provider, async_id = tags[context]
+        line += ' %s#%d' % (providers.get(provider, provider), async_id)
+    elif kind == PHASE_BEGIN:
+      depth[tid] = d + 1
+      line = 'PHASE %s' % phases.get(type, type)
+      if id != 0:
+        line += ' #%d' % id
+    elif kind == DECISION:
+      if options.no_decisions:
+        continue
+      line = 'DECISION %s 0x%x' % (points.get(type, type), id)
+    else:
+      line = 'kind %d?' % kind
+    out.write(prefix + line + '\n')
+
+  if offset != len(data):
+    out.write('# truncated record at the end\n')
+
+
+if __name__ == '__main__':
+  main()
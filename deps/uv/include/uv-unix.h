@@ -237,6 +237,8 @@ typedef struct {
   uv__io_t signal_io_watcher;                                                 \
   uv_signal_t child_watcher;                                                  \
   int emfile_fd;                                                              \
+  /* Created on first use. See scheduler_loop_enter in src/scheduler.h. */    \
+  void* scheduler_state;                                                      \
   UV_PLATFORM_LOOP_FIELDS                                                     \
 
 #define UV_REQ_TYPE_PRIVATE /* empty */
@@ -284,6 +284,40 @@ UV_EXTERN void uv_mark_main_uv_run_begin(void);
 UV_EXTERN void uv_mark_main_uv_run_end(void);
 UV_EXTERN void uv_mark_exit_begin(void);
 UV_EXTERN void uv_mark_exit_end(void);
+/* Logging for the embedder, in log class LOG_NODE (UV_LOG_NODE_VERBOSITY).
+ * uv_log_enabled is cheap; test it before building costly arguments.
+ * Messages logged before initialize_fuzzy_libuv are dropped, so call it first.
+ * uv_log_verbosity is the highest verbosity that is printed, or -1 if none.
+ * It does not change after initialize_fuzzy_libuv, so the embedder may
+ * cache it. */
+UV_EXTERN int uv_log_enabled(int verbosity);
+UV_EXTERN int uv_log_verbosity(void);
+UV_EXTERN void uv_log(int verbosity, const char* format, ...);
+/* A slice called NAME, in category "node", in the CB timeline (UV_TRACE_FILE).
+ * Cheap when we are not tracing. If uv_trace_enabled returns 0 after
+ * initialize_fuzzy_libuv, these never record anything. */
+UV_EXTERN int uv_trace_enabled(void);
+UV_EXTERN void uv_trace_begin(const char* name);
+UV_EXTERN void uv_trace_end(const char* name);
+/* Records in the causal log (UV_CAUSAL_FILE, see src/causal.h).
+ * uv_causal_tag says CONTEXT, a handle or req, belongs to the embedder's
+ * resource ASYNC_ID of type PROVIDER; call it when the resource is created.
+ * A phase is a span of embedder work, e.g. draining a queue; PHASE and ID
+ * are the embedder's to define. Cheap when we are not logging. As for
+ * uv_trace_enabled, if uv_causal_enabled returns 0 after
+ * initialize_fuzzy_libuv, these never record anything. */
+UV_EXTERN int uv_causal_enabled(void);
+UV_EXTERN void uv_causal_tag(const void* context,
+                             int provider,
+                             uint64_t async_id);
+UV_EXTERN void uv_causal_phase_begin(int phase, uint64_t id);
+UV_EXTERN void uv_causal_phase_end(int phase, uint64_t id);
+/* If UV_FORK_SERVER_FD is set, turn this process into a fork server and
+ * return 0 in each forked child. Otherwise a no-op. Call it from outside
+ * any callback, before the threadpool has work in flight. The server
+ * itself returns only if it fails to start; later failures are reported
+ * to the driver and the server exits. */
+UV_EXTERN int uv_fork_server(uv_loop_t* loop);
 UV_EXTERN int uv_run(uv_loop_t*, uv_run_mode mode);
 UV_EXTERN void uv_stop(uv_loop_t*);
 
@@ -988,6 +1022,12 @@ UV_EXTERN int uv_queue_work(uv_loop_t* loop,
                             uv_work_cb work_cb,
                             uv_after_work_cb after_work_cb);
 
+/* An embedder with a small work item (SIZE, e.g. bytes of input) can ask
+ * whether to run it on the loop thread now instead of through uv_queue_work.
+ * Returns non-zero to run it inline. The scheduler decides, so fuzzing runs
+ * still send some of it to the threadpool. Call it on the loop thread. */
+UV_EXTERN int uv_work_should_inline(uv_loop_t* loop, size_t size);
+
 UV_EXTERN int uv_cancel(uv_req_t* req);
 
 
@@ -1105,7 +1145,8 @@ typedef enum {
   UV_FS_SYMLINK,
   UV_FS_READLINK,
   UV_FS_CHOWN,
-  UV_FS_FCHOWN
+  UV_FS_FCHOWN,
+  UV_FS_READFILE
 } uv_fs_type;
 
 /* uv_fs_t is a subclass of uv_req_t. */
@@ -1293,6 +1334,13 @@ UV_EXTERN int uv_fs_fchown(uv_loop_t* loop,
                            uv_uid_t uid,
                            uv_gid_t gid,
                            uv_fs_cb cb);
+UV_EXTERN int uv_fs_readfile(uv_loop_t* loop,
+                             uv_fs_t* req,
+                             const char* path,
+                             int flags,
+                             int mode,
+                             size_t max_size,
+                             uv_fs_cb cb);
 
 
 enum uv_fs_event {
@@ -0,0 +1,118 @@
+#include "causal.h"
+
+#include "uv.h"
+#include "runtime.h"
+#include "logfile.h"
+
+#include <stdio.h>
+#include <stdlib.h> /* atexit */
+#include <string.h> /* memset, memcpy */
+#include <assert.h>
+
+/* Private declarations. */
+
+static logfile_t causal;
+
+static int initialized = 0;
+
+/* Private helpers. */
+static void causal__open_cb (logfile_t *logfile);
+static void causal__close (void);
+
+/* Public API implementation. */
+
+void causal_init (void)
+{
+  const char *file = NULL;
+
+  if (initialized)
+    return;
+  initialized = 1;
+
+  file = runtime_causal_file();
+  logfile_init(&causal, file, "wb", causal__open_cb, NULL);
+  if (file != NULL)
+    assert(atexit(causal__close) == 0);
+}
+
+int causal_enabled (void)
+{
+  return causal.enabled;
+}
+
+void causal_record (enum causal_kind kind, unsigned type, const void *context, uint64_t id)
+{
+  struct causal_record record;
+
+  if (!causal.enabled)
+    return;
+
+  record.ts = logfile_now(&causal);
+  record.tid = (uint64_t) uv_thread_self();
+  record.context = (uint64_t) (uintptr_t) context;
+  record.id = id;
+  record.kind = (uint16_t) kind;
+  record.type = (uint16_t) type;
+  record.reserved = 0;
+
+  uv_mutex_lock(&causal.mutex);
+  if (causal.enabled)
+  {
+    fwrite(&record, sizeof record, 1, causal.fileP);
+    /* A reader can tell a truncated file by its size; there is no room for a note. */
+    if (logfile_account(&causal, sizeof record))
+      causal.enabled = 0;
+  }
+  uv_mutex_unlock(&causal.mutex);
+}
+
+void causal_before_fork (void)
+{
+  logfile_before_fork(&causal);
+}
+
+void causal_after_fork (int is_child)
+{
+  logfile_after_fork(&causal, is_child);
+}
+
+/* Embedder API, declared in uv.h. */
+
+int uv_causal_enabled (void)
+{
+  return causal_enabled();
+}
+
+void uv_causal_tag (const void *context, int provider, uint64_t async_id)
+{
+  causal_record(CAUSAL_TAG, (unsigned) provider, context, async_id);
+}
+
+void uv_causal_phase_begin (int phase, uint64_t id)
+{
+  causal_record(CAUSAL_PHASE_BEGIN, (unsigned) phase, NULL, id);
+}
+
+void uv_causal_phase_end (int phase, uint64_t id)
+{
+  causal_record(CAUSAL_PHASE_END, (unsigned) phase, NULL, id);
+}
+
+/* Private helpers. */
+
+static void causal__open_cb (logfile_t *logfile)
+{
+  struct causal_header header;
+
+  memset(&header, 0, sizeof header);
+  memcpy(header.magic, CAUSAL_MAGIC, sizeof header.magic);
+  header.record_size = sizeof(struct causal_record);
+  header.pid = logfile->pid;
+  fwrite(&header, sizeof header, 1, logfile->fileP);
+  logfile_account(logfile, sizeof header);
+}
+
+static void causal__close (void)
+{
+  logfile_close(&causal);
+}
@@ -0,0 +1,70 @@
+#ifndef UV_SRC_CAUSAL_H_
+#define UV_SRC_CAUSAL_H_
+
+#include <stdint.h>
+
+/* This module streams a binary log of causality to the file named by UV_CAUSAL_FILE:
+ * which embedder resource each CB belongs to, which embedder phases (e.g. Node's nextTick
+ * and microtask queues) ran in which CB, and which decisions the scheduler made in between.
+ *
+ * The embedder tags each handle or req with its resource (uv_causal_tag) when it creates it.
+ * The CB records carry only the handle or req; a reader joins a CB to the last tag of its
+ * context that precedes it. Pointers are reused, so later tags win.
+ *
+ * File format: a struct causal_header, then struct causal_records, in host byte order.
+ * Records are appended as they happen, so they are in time order within a thread but
+ *   only roughly across threads.
+ *
+ * Bounds: as for the trace file (src/trace.h). The buffer is UV_TRACE_BUFFER_KB and
+ *   logging stops at UV_TRACE_MAX_MB.
+ * Overhead: each record is a fixed-size write into the buffer under a mutex. Nothing is formatted.
+ *   With UV_CAUSAL_FILE unset, each hook costs one test of a flag.
+ */
+
+#define CAUSAL_MAGIC "UVCAUSL1"
+
+struct causal_header
+{
+  char magic[8];         /* CAUSAL_MAGIC, not NUL-terminated. */
+  uint32_t record_size;  /* sizeof(struct causal_record). */
+  int32_t pid;
+};
+
+enum causal_kind
+{
+  CAUSAL_TAG = 1,  /* context was created by the embedder. type is its provider, id its async id. */
+  CAUSAL_CB_BEGIN, /* A CB of type (enum callback_type) on context begins. */
+  CAUSAL_CB_END,   /* ...and ends. */
+  CAUSAL_DECISION, /* The scheduler decided id at schedule point type. */
+  CAUSAL_PHASE_BEGIN, /* The embedder's phase type begins. id is embedder-defined. */
+  CAUSAL_PHASE_END    /* ...and ends. */
+};
+
+struct causal_record
+{
+  uint64_t ts;      /* ns since the file was opened, CLOCK_MONOTONIC. */
+  uint64_t tid;     /* uv_thread_self(). */
+  uint64_t context; /* The handle or req, or 0. */
+  uint64_t id;
+  uint16_t kind;    /* enum causal_kind. */
+  uint16_t type;
+  uint32_t reserved;
+};
+
+/* Initialize the causal module. Call after runtime_init.
+ * Call once. Not thread safe. */
+void causal_init (void);
+
+/* Returns non-zero if we are logging. */
+int causal_enabled (void);
+
+/* Append a record of KIND for the calling thread.
+ * Thread safe. */
+void causal_record (enum causal_kind kind, unsigned type, const void *context, uint64_t id);
+
+/* Call in the parent just before fork(), then causal_after_fork in both processes.
+ * The child logs to "<UV_CAUSAL_FILE>.<pid>". */
+void causal_before_fork (void);
+void causal_after_fork (int is_child);
+
+#endif  /* UV_SRC_CAUSAL_H_ */
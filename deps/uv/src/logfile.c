@@ -0,0 +1,134 @@
+#include "logfile.h"
+
+#include "uv.h"
+#include "uv-common.h" /* uv__malloc/uv__free */
+#include "runtime.h"
+
+#include <stdio.h>
+#include <string.h> /* strncpy, strlen */
+#include <assert.h>
+#include <time.h> /* clock_gettime */
+#include <sys/types.h>
+#include <unistd.h> /* getpid */
+
+/* Private helpers. */
+static void logfile__open (logfile_t *logfile);
+
+/* Public API implementation. */
+
+void logfile_init (logfile_t *logfile, const char *file, const char *mode, logfile_open_cb open_cb, logfile_close_cb close_cb)
+{
+  assert(logfile != NULL);
+  assert(mode != NULL);
+
+  memset(logfile, 0, sizeof *logfile);
+  logfile->enabled = 0;
+  if (file == NULL)
+    return;
+
+  assert(uv_mutex_init(&logfile->mutex) == 0);
+  strncpy(logfile->file, file, sizeof logfile->file - 1);
+  logfile->file[sizeof logfile->file - 1] = '\0';
+  logfile->mode = mode;
+  logfile->open_cb = open_cb;
+  logfile->close_cb = close_cb;
+
+  logfile->buf_size = 1024 * (size_t) runtime_trace_buffer_kb();
+  logfile->buf = NULL;
+  if (0 < logfile->buf_size)
+  {
+    logfile->buf = (char *) uv__malloc(logfile->buf_size);
+    assert(logfile->buf != NULL);
+  }
+  logfile->max_bytes = 1024 * 1024 * (long unsigned) runtime_trace_max_mb();
+
+  logfile__open(logfile);
+}
+
+int logfile_account (logfile_t *logfile, long len)
+{
+  if (0 < len)
+    logfile->bytes_written += len;
+  return (logfile->max_bytes <= logfile->bytes_written);
+}
+
+uint64_t logfile_now (logfile_t *logfile)
+{
+  struct timespec now;
+
+  assert(clock_gettime(CLOCK_MONOTONIC, &now) == 0);
+  return (uint64_t) (now.tv_sec - logfile->start.tv_sec) * 1000000000 + now.tv_nsec - logfile->start.tv_nsec;
+}
+
+void logfile_close (logfile_t *logfile)
+{
+  if (logfile->fileP == NULL)
+    return;
+
+  uv_mutex_lock(&logfile->mutex);
+  logfile->enabled = 0;
+  if (logfile->close_cb != NULL)
+    logfile->close_cb(logfile);
+  fclose(logfile->fileP);
+  logfile->fileP = NULL;
+  uv_mutex_unlock(&logfile->mutex);
+}
+
+void logfile_before_fork (logfile_t *logfile)
+{
+  if (logfile->file[0] == '\0')
+    return;
+
+  uv_mutex_lock(&logfile->mutex);
+  if (logfile->fileP != NULL)
+    fflush(logfile->fileP);
+}
+
+void logfile_after_fork (logfile_t *logfile, int is_child)
+{
+  size_t len;
+
+  if (logfile->file[0] == '\0')
+    return;
+
+  /* We took the mutex before forking, so no other thread held it. */
+  uv_mutex_unlock(&logfile->mutex);
+  if (!is_child || logfile->fileP == NULL)
+    return;
+
+  /* We flushed before forking, so closing our copy writes nothing. */
+  if (fclose(logfile->fileP))
+    assert(!"logfile_after_fork: could not close the inherited log file");
+  logfile->fileP = NULL;
+  logfile->enabled = 0;
+
+  len = strlen(logfile->file);
+  snprintf(logfile->file + len, sizeof logfile->file - len, ".%i", getpid());
+  logfile__open(logfile);
+}
+
+/* Private helpers. */
+
+static void logfile__open (logfile_t *logfile)
+{
+  logfile->fileP = fopen(logfile->file, logfile->mode);
+  if (logfile->fileP == NULL)
+  {
+    fprintf(stderr, "logfile__open: could not open %s, not logging to it\n", logfile->file);
+    logfile->enabled = 0;
+    return;
+  }
+
+  if (logfile->buf != NULL)
+    setvbuf(logfile->fileP, logfile->buf, _IOFBF, logfile->buf_size);
+  else
+    setvbuf(logfile->fileP, NULL, _IONBF, 0);
+
+  logfile->pid = getpid();
+  assert(clock_gettime(CLOCK_MONOTONIC, &logfile->start) == 0);
+  logfile->bytes_written = 0;
+
+  if (logfile->open_cb != NULL)
+    logfile->open_cb(logfile);
+  logfile->enabled = 1;
+}
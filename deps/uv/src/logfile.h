@@ -0,0 +1,71 @@
+#ifndef UV_SRC_LOGFILE_H_
+#define UV_SRC_LOGFILE_H_
+
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/* A buffered log file, shared by the trace (src/trace.h) and causal (src/causal.h) modules.
+ *
+ * Buffering and the size cap come from UV_TRACE_BUFFER_KB and UV_TRACE_MAX_MB.
+ * The owner formats its own records: it takes the mutex, tests enabled, writes to fileP,
+ *   and calls logfile_account.
+ * In a fork server child, the log goes to "<file>.<pid>".
+ */
+
+typedef struct logfile_s logfile_t;
+
+/* Called with the file freshly opened, before it is enabled. Writes the file's header. */
+typedef void (*logfile_open_cb) (logfile_t *logfile);
+/* Called with the mutex held, just before the file is closed at exit. Writes the file's footer. */
+typedef void (*logfile_close_cb) (logfile_t *logfile);
+
+struct logfile_s
+{
+  /* Tested without the mutex. A stale value costs at most one record. */
+  int enabled;
+
+  char file[1024]; /* Empty if not configured. */
+  const char *mode; /* For fopen. */
+  FILE *fileP;
+  char *buf; /* Used with setvbuf. NULL if unbuffered. */
+  size_t buf_size;
+
+  long unsigned bytes_written; /* Protected by mutex. */
+  long unsigned max_bytes;
+
+  int pid;
+  struct timespec start; /* CLOCK_MONOTONIC. Timestamps are relative to this. */
+
+  logfile_open_cb open_cb;
+  logfile_close_cb close_cb;
+
+  uv_mutex_t mutex;
+};
+
+/* Open FILE with fopen MODE. If FILE is NULL, LOGFILE stays disabled.
+ * The owner closes it at exit with logfile_close.
+ * Not thread safe. */
+void logfile_init (logfile_t *logfile, const char *file, const char *mode, logfile_open_cb open_cb, logfile_close_cb close_cb);
+
+/* Account for a record of LEN bytes. Caller holds the mutex.
+ * Returns non-zero if LOGFILE just reached its cap. The caller may write a last note and
+ *   must then clear enabled. */
+int logfile_account (logfile_t *logfile, long len);
+
+/* Nanoseconds since LOGFILE was opened. */
+uint64_t logfile_now (logfile_t *logfile);
+
+/* Call at exit. */
+void logfile_close (logfile_t *logfile);
+
+/* Call in the parent just before fork(). Takes the mutex and flushes the file, so the child
+ *   inherits neither a held mutex nor buffered records.
+ * Then call logfile_after_fork in both processes. */
+void logfile_before_fork (logfile_t *logfile);
+/* IS_CHILD: The child reopens the log as "<file>.<pid>". */
+void logfile_after_fork (logfile_t *logfile, int is_child);
+
+#endif  /* UV_SRC_LOGFILE_H_ */
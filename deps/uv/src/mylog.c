@@ -29,7 +29,8 @@ char *log_class_strings[LOG_CLASS_MAX - LOG_CLASS_MIN] = {
   "LOG_UV_STREAM",
   "LOG_UV_IO",
   "LOG_UV_ASYNC",
-  "LOG_STATISTICS"
+  "LOG_STATISTICS",
+  "LOG_NODE"
 };
 
 int verbosity_levels[LOG_CLASS_MAX] = {
@@ -44,6 +45,7 @@ int verbosity_levels[LOG_CLASS_MAX] = {
   0,
   0,
   0,
+  0,
   0
 };
 
@@ -99,6 +101,11 @@ static char * mylog_gen_prefix (enum log_class log_class, int verbosity, char *b
   return buf;
 }
 
+void mylog_after_fork (void)
+{
+  my_pid = getpid();
+}
+
 static void mylog_persistent_print (FILE *stream, char *str)
 {
   int amt_printed = 0, amt_remaining = 0;
@@ -169,10 +176,8 @@ void mylog_set_all_verbosity (int verbosity)
 }
 
 static char log_buf[2048]; /* Only access under log_lock. */
-void mylog (enum log_class log_class, int verbosity, const char *format, ...)
+static void mylog_v (enum log_class log_class, int verbosity, const char *format, va_list args)
 {
-  va_list args;
-
   if (runtime_should_be_silent())
     return;
 
@@ -188,9 +193,7 @@ void mylog (enum log_class log_class, int verbosity, const char *format, ...)
   mylog_gen_prefix(log_class, verbosity, log_buf, sizeof log_buf);
 
   /* Prep user's message. */
-  va_start(args, format);
   vsnprintf(log_buf + strlen(log_buf), sizeof(log_buf) - strlen(log_buf), format, args);
-  va_end(args);
   assert(log_buf[strlen(log_buf)-1] == '\n');
 
   mylog_persistent_print(output_stream, log_buf);
@@ -198,6 +201,15 @@ void mylog (enum log_class log_class, int verbosity, const char *format, ...)
   uv_mutex_unlock(&log_lock);
 }
 
+void mylog (enum log_class log_class, int verbosity, const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  mylog_v(log_class, verbosity, format, args);
+  va_end(args);
+}
+
 /* Print buf as LEN char's. */
 void mylog_buf (enum log_class log_class, int verbosity, char *buf, int len)
 {
@@ -233,6 +245,33 @@ void mylog_buf (enum log_class log_class, int verbosity, char *buf, int len)
   uv_mutex_unlock(&log_lock);
 }
 
+/* Embedder API, declared in uv.h. */
+
+int uv_log_enabled (int verbosity)
+{
+  /* Not initialized if we are silent. */
+  return log_initialized() && verbosity <= verbosity_levels[LOG_NODE];
+}
+
+int uv_log_verbosity (void)
+{
+  if (!log_initialized())
+    return -1;
+  return verbosity_levels[LOG_NODE];
+}
+
+void uv_log (int verbosity, const char *format, ...)
+{
+  va_list args;
+
+  if (!uv_log_enabled(verbosity))
+    return;
+
+  va_start(args, format);
+  mylog_v(LOG_NODE, verbosity, format, args);
+  va_end(args);
+}
+
 /* Unit testing. */
 
 /* For competing logger threads. */
@@ -24,6 +24,7 @@ enum log_class
   LOG_UV_IO,
   LOG_UV_ASYNC,
   LOG_STATISTICS,
+  LOG_NODE, /* The embedder, through uv_log. */
   LOG_CLASS_MAX
 };
 
@@ -44,6 +45,9 @@ void mylog (enum log_class, int verbosity, const char *format, ...);
 /* Print buf as LEN char's. */
 void mylog_buf (enum log_class, int verbosity, char *buf, int len);
 
+/* Call in the child after fork() so the log prefix shows the new pid. */
+void mylog_after_fork (void);
+
 void mylog_UT (void);
 
 #endif /* UV_MYLOG_H */
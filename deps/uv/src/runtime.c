@@ -7,14 +7,30 @@ struct
 {
   int silent;
   int print_summary;
+  int accept_batch_size;
+  const char *schedule_bitmap_shm;
+  const char *schedule_fingerprint_file;
+  const char *trace_file;
+  const char *causal_file;
+  int trace_buffer_kb;
+  int trace_max_mb;
+  int node_log_verbosity;
+  int have_scheduler_seed;
+  unsigned scheduler_seed;
 } runtime_parms;
 
+#define RUNTIME_ACCEPT_BATCH_SIZE_MAX 64
+
 static int runtime_initialized = 0;
 
 void runtime_init (void)
 {
   int silent_default = 0;
   int print_summary_default = 1;
+  int accept_batch_size_default = 1;
+  int trace_buffer_kb_default = 64;
+  int trace_max_mb_default = 256;
+  int node_log_verbosity_default = 0;
 
   {
     /* By default, don't be silent. 
@@ -49,6 +65,69 @@ void runtime_init (void)
     }
   }
 
+  {
+    char *acceptBatchSizeP = getenv("UV_ACCEPT_BATCH_SIZE");
+    if (acceptBatchSizeP == NULL)
+      runtime_parms.accept_batch_size = accept_batch_size_default;
+    else
+    {
+      runtime_parms.accept_batch_size = atoi(acceptBatchSizeP);
+      if (runtime_parms.accept_batch_size < 1)
+        runtime_parms.accept_batch_size = 1;
+      else if (RUNTIME_ACCEPT_BATCH_SIZE_MAX < runtime_parms.accept_batch_size)
+        runtime_parms.accept_batch_size = RUNTIME_ACCEPT_BATCH_SIZE_MAX;
+    }
+  }
+
+  /* NULL if unset. */
+  runtime_parms.schedule_bitmap_shm = getenv("UV_SCHEDULE_BITMAP_SHM");
+  runtime_parms.schedule_fingerprint_file = getenv("UV_SCHEDULE_FINGERPRINT_FILE");
+  runtime_parms.trace_file = getenv("UV_TRACE_FILE");
+  runtime_parms.causal_file = getenv("UV_CAUSAL_FILE");
+
+  {
+    char *traceBufferKbP = getenv("UV_TRACE_BUFFER_KB");
+    if (traceBufferKbP == NULL)
+      runtime_parms.trace_buffer_kb = trace_buffer_kb_default;
+    else
+    {
+      runtime_parms.trace_buffer_kb = atoi(traceBufferKbP);
+      if (runtime_parms.trace_buffer_kb < 0)
+        runtime_parms.trace_buffer_kb = 0;
+    }
+  }
+
+  {
+    char *traceMaxMbP = getenv("UV_TRACE_MAX_MB");
+    if (traceMaxMbP == NULL)
+      runtime_parms.trace_max_mb = trace_max_mb_default;
+    else
+    {
+      runtime_parms.trace_max_mb = atoi(traceMaxMbP);
+      if (runtime_parms.trace_max_mb < 1)
+        runtime_parms.trace_max_mb = 1;
+    }
+  }
+
+  {
+    char *nodeLogVerbosityP = getenv("UV_LOG_NODE_VERBOSITY");
+    if (nodeLogVerbosityP == NULL)
+      runtime_parms.node_log_verbosity = node_log_verbosity_default;
+    else
+      runtime_parms.node_log_verbosity = atoi(nodeLogVerbosityP);
+  }
+
+  {
+    char *schedulerSeedP = getenv("UV_SCHEDULER_SEED");
+    if (schedulerSeedP == NULL)
+      runtime_parms.have_scheduler_seed = 0;
+    else
+    {
+      runtime_parms.have_scheduler_seed = 1;
+      runtime_parms.scheduler_seed = (unsigned) strtoul(schedulerSeedP, NULL, 10);
+    }
+  }
+
   runtime_initialized = 1;
 }
 
@@ -63,3 +142,60 @@ int runtime_should_print_summary (void)
   assert(runtime_initialized);
   return runtime_parms.print_summary;
 }
+
+int runtime_accept_batch_size (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.accept_batch_size;
+}
+
+const char * runtime_schedule_bitmap_shm (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.schedule_bitmap_shm;
+}
+
+const char * runtime_schedule_fingerprint_file (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.schedule_fingerprint_file;
+}
+
+const char * runtime_trace_file (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.trace_file;
+}
+
+const char * runtime_causal_file (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.causal_file;
+}
+
+int runtime_trace_buffer_kb (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.trace_buffer_kb;
+}
+
+int runtime_trace_max_mb (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.trace_max_mb;
+}
+
+int runtime_node_log_verbosity (void)
+{
+  assert(runtime_initialized);
+  return runtime_parms.node_log_verbosity;
+}
+
+int runtime_scheduler_seed (unsigned *seed)
+{
+  assert(runtime_initialized);
+  assert(seed != NULL);
+  if (runtime_parms.have_scheduler_seed)
+    *seed = runtime_parms.scheduler_seed;
+  return runtime_parms.have_scheduler_seed;
+}
@@ -15,4 +15,33 @@ int runtime_should_be_silent (void);
 /* Returns non-zero if we should print summary information, otherwise 0. */
 int runtime_should_print_summary (void);
 
+/* Maximum number of connections a listening stream accepts per wakeup.
+ * 1 means one connection per UV_CONNECTION_CB, the traditional behavior. */
+int runtime_accept_batch_size (void);
+
+/* Name of the POSIX shared-memory object holding the schedule coverage bitmap, or NULL. */
+const char * runtime_schedule_bitmap_shm (void);
+
+/* File to which the schedule fingerprint is appended at exit, or NULL. */
+const char * runtime_schedule_fingerprint_file (void);
+
+/* File to which the CB timeline is streamed, or NULL. See src/trace.h. */
+const char * runtime_trace_file (void);
+
+/* File to which the causal log is written, or NULL. See src/causal.h. */
+const char * runtime_causal_file (void);
+
+/* Size of the trace file's buffer, in KB. 0 means unbuffered. */
+int runtime_trace_buffer_kb (void);
+
+/* Once the trace file reaches this many MB, tracing stops. */
+int runtime_trace_max_mb (void);
+
+/* Verbosity of log class LOG_NODE, which the embedder logs to through uv_log. */
+int runtime_node_log_verbosity (void);
+
+/* Returns non-zero if UV_SCHEDULER_SEED was given, and stores it in *SEED.
+ * Otherwise the scheduler seeds its RNG from the clock. */
+int runtime_scheduler_seed (unsigned *seed);
+
 #endif  /* UV_SRC_RUNTIME_H_ */
@@ -18,11 +18,22 @@
   #include "scheduler_CBTree.h"
 #endif /* ENABLE_SCHEDULER_CBTREE */
 
+#if defined(ENABLE_SCHEDULER_PCT)
+  #include "scheduler_PCT.h"
+#endif /* ENABLE_SCHEDULER_PCT */
+
+#if defined(ENABLE_SCHEDULER_SYSTEMATIC)
+  #include "scheduler_Systematic.h"
+#endif /* ENABLE_SCHEDULER_SYSTEMATIC */
+
 #include "map.h"
 #include "mylog.h"
 #include "timespec_funcs.h"
 #include "synchronization.h"
 #include "runtime.h"
+#include "trace.h"
+#include "causal.h"
+#include "uv-probes.h"
 
 #include "unix/internal.h"
 
@@ -31,6 +42,9 @@
 #include <assert.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h> /* O_RDWR */
+#include <sys/mman.h> /* shm_open, mmap */
+#include <sys/stat.h> /* fstat */
 
 /* Functions for scheduler typedefs. */
 
@@ -39,7 +53,9 @@ char *scheduler_type_strings[SCHEDULER_TYPE_MAX - SCHEDULER_TYPE_MIN + 1] =
     "VANILLA",
     "CBTREE",
     "FUZZING_TIME",
-    "TP_FREEDOM"
+    "TP_FREEDOM",
+    "PCT",
+    "SYSTEMATIC"
   };
 
 const char * scheduler_type_to_string (scheduler_type_t type)
@@ -94,6 +110,12 @@ char *schedule_point_strings[SCHEDULE_POINT_MAX - SCHEDULE_POINT_MIN + 1] =
 
     "LOOPER_RUN_CLOSING",
 
+    "LOOPER_ACCEPT",
+
+    "LOOPER_RUN_INLINE",
+
+    "LOOPER_SOURCE_CLOSED",
+
     /* TP */
     "TP_WANTS_WORK",
 
@@ -130,6 +152,9 @@ static int SPD_TP_BEFORE_PUT_DONE_MAGIC = 59175099;
 static int SPD_TP_AFTER_PUT_DONE_MAGIC = 99281732;
 static int SPD_LOOPER_GETTING_DONE_MAGIC = 10229334;
 static int SPD_LOOPER_RUN_CLOSING_MAGIC = 64976312;
+static int SPD_LOOPER_ACCEPT_MAGIC = 31758204;
+static int SPD_LOOPER_RUN_INLINE_MAGIC = 52870913;
+static int SPD_LOOPER_SOURCE_CLOSED_MAGIC = 73120586;
 static int SPD_TIMER_READY_MAGIC = 64315287;
 static int SPD_TIMER_RUN_MAGIC = 87874545;
 static int SPD_TIMER_NEXT_TIMEOUT_MAGIC = 85563324;
@@ -298,6 +323,51 @@ int spd_looper_run_closing_is_valid (spd_looper_run_closing_t *spd_looper_run_cl
           spd_looper_run_closing->magic == SPD_LOOPER_RUN_CLOSING_MAGIC);
 }
 
+void spd_looper_accept_init (spd_looper_accept_t *spd_looper_accept)
+{
+  assert(spd_looper_accept != NULL);
+  memset(spd_looper_accept, 0, sizeof *spd_looper_accept);
+  spd_looper_accept->magic = SPD_LOOPER_ACCEPT_MAGIC;
+}
+
+int spd_looper_accept_is_valid (spd_looper_accept_t *spd_looper_accept)
+{
+  return (spd_looper_accept != NULL &&
+          spd_looper_accept->magic == SPD_LOOPER_ACCEPT_MAGIC &&
+          spd_looper_accept->shuffleable_items.item_size == sizeof(int) &&
+          spd_looper_accept->shuffleable_items.items != NULL);
+}
+
+void spd_looper_run_inline_init (spd_looper_run_inline_t *spd_looper_run_inline)
+{
+  assert(spd_looper_run_inline != NULL);
+  memset(spd_looper_run_inline, 0, sizeof *spd_looper_run_inline);
+  spd_looper_run_inline->magic = SPD_LOOPER_RUN_INLINE_MAGIC;
+  spd_looper_run_inline->run_inline = 1;
+}
+
+int spd_looper_run_inline_is_valid (spd_looper_run_inline_t *spd_looper_run_inline)
+{
+  return (spd_looper_run_inline != NULL &&
+          spd_looper_run_inline->magic == SPD_LOOPER_RUN_INLINE_MAGIC);
+}
+
+void spd_looper_source_closed_init (spd_looper_source_closed_t *spd_looper_source_closed)
+{
+  assert(spd_looper_source_closed != NULL);
+  memset(spd_looper_source_closed, 0, sizeof *spd_looper_source_closed);
+  spd_looper_source_closed->magic = SPD_LOOPER_SOURCE_CLOSED_MAGIC;
+  spd_looper_source_closed->fd = -1;
+  spd_looper_source_closed->timer = NULL;
+}
+
+int spd_looper_source_closed_is_valid (spd_looper_source_closed_t *spd_looper_source_closed)
+{
+  return (spd_looper_source_closed != NULL &&
+          spd_looper_source_closed->magic == SPD_LOOPER_SOURCE_CLOSED_MAGIC &&
+          (spd_looper_source_closed->fd != -1 || spd_looper_source_closed->timer != NULL));
+}
+
 void spd_timer_ready_init (spd_timer_ready_t *spd_timer_ready)
 {
   assert(spd_timer_ready != NULL);
@@ -361,6 +431,9 @@ int schedule_point_looks_valid (schedule_point_t point, void *pointDetails)
   spd_after_put_done_t *spd_after_put_done = NULL;
   spd_getting_done_t *spd_getting_done = NULL;
   spd_looper_run_closing_t *spd_looper_run_closing = NULL;
+  spd_looper_accept_t *spd_looper_accept = NULL;
+  spd_looper_run_inline_t *spd_looper_run_inline = NULL;
+  spd_looper_source_closed_t *spd_looper_source_closed = NULL;
   spd_timer_ready_t *spd_timer_ready = NULL;
   spd_timer_run_t *spd_timer_run = NULL;
   spd_timer_next_timeout_t *spd_timer_next_timeout = NULL;
@@ -420,6 +493,18 @@ int schedule_point_looks_valid (schedule_point_t point, void *pointDetails)
       spd_looper_run_closing = (spd_looper_run_closing_t *) pointDetails;
       is_valid = spd_looper_run_closing_is_valid(spd_looper_run_closing);
       break;
+    case SCHEDULE_POINT_LOOPER_ACCEPT:
+      spd_looper_accept = (spd_looper_accept_t *) pointDetails;
+      is_valid = spd_looper_accept_is_valid(spd_looper_accept);
+      break;
+    case SCHEDULE_POINT_LOOPER_RUN_INLINE:
+      spd_looper_run_inline = (spd_looper_run_inline_t *) pointDetails;
+      is_valid = spd_looper_run_inline_is_valid(spd_looper_run_inline);
+      break;
+    case SCHEDULE_POINT_LOOPER_SOURCE_CLOSED:
+      spd_looper_source_closed = (spd_looper_source_closed_t *) pointDetails;
+      is_valid = spd_looper_source_closed_is_valid(spd_looper_source_closed);
+      break;
     case SCHEDULE_POINT_TIMER_READY:
       spd_timer_ready = (spd_timer_ready_t *) pointDetails;
       is_valid = spd_timer_ready_is_valid(spd_timer_ready);
@@ -447,6 +532,40 @@ static int SCHEDULER_MAGIC = 8675309; /* Jenny. */
 
 static int scheduler_initialized = 0;
 static int scheduler_closed = 0;
+
+/* 64-bit FNV-1a, spelled out for C89. */
+#define SCHEDULER_FNV_OFFSET_BASIS (((uint64_t) 0xcbf29ce4 << 32) | 0x84222325)
+#define SCHEDULER_FNV_PRIME (((uint64_t) 1 << 40) | 0x1b3)
+/* No %llx in C89. */
+#define SCHEDULER_HASH_HI(h) ((unsigned long) ((h) >> 32))
+#define SCHEDULER_HASH_LO(h) ((unsigned long) ((h) & 0xffffffff))
+#define SCHEDULER_FNV_FOLD(h, v) do { (h) ^= (uint64_t) (v); (h) *= SCHEDULER_FNV_PRIME; } while (0)
+
+/* Deeper CB stacks share the parent of the deepest tracked level. */
+#define SCHEDULER_CB_STACK_MAX 32
+
+static int SCHEDULER_LOOP_STATE_MAGIC = 31415926;
+
+/* Per-loop state. Each uv_loop_t has one; threads bound to no loop share scheduler.unbound.
+ * See scheduler_loop_enter. */
+struct scheduler_loop_state_s
+{
+  int magic;
+
+  /* Serializes the CBs of the loop, including the TP work done on its behalf.
+   * Control using scheduler__[un]lock. */
+  reentrant_mutex_t *mutex;
+  uv_thread_t current_cb_thread;
+  uv_thread_t looper_thread; /* The thread running the loop, if any. */
+  int in_epoll; /* Looper is between LOOPER_BEFORE_EPOLL and LOOPER_AFTER_EPOLL. Looper only. */
+
+  /* Schedule coverage. See scheduler_schedule_hash. */
+  uint64_t pending_decisions; /* Looper decisions since its last CB. Looper only. */
+  enum callback_type cb_type_stack[SCHEDULER_CB_STACK_MAX]; /* Indexed by depth-1. Protected by mutex. */
+  enum callback_type prev_top_level_cb_type; /* Protected by mutex. */
+};
+typedef struct scheduler_loop_state_s scheduler_loop_state_t;
+
 struct
 {
   int magic;
@@ -464,18 +583,38 @@ struct
   size_t schedule_cbType_buf_size;
 
   /* Things we can track ourselves (not handled by a schedulerImpl_t). */
-  long unsigned int n_executed; /* Protected by mutex. */
+  long unsigned int n_executed; /* Protected by global_mutex. */
+  uint64_t schedule_hash; /* FNV-1a over the executed edges. Protected by global_mutex. */
   struct map *tidToType;
-  uv_thread_t current_cb_thread;
 
-  /* Synchronization. */
-  reentrant_mutex_t *mutex; /* Control using scheduler__[un]lock. */
+  /* Schedule coverage. See scheduler_schedule_hash. */
+  unsigned char *coverage_map; /* SCHEDULER_COVERAGE_MAP_SIZE bytes, maybe shared. Protected by global_mutex. */
+  int coverage_map_is_shared;
+  long unsigned n_new_edges; /* Edges whose counter was 0 when we hit them. Protected by global_mutex. */
+
+  /* Loops. See scheduler_loop_enter. */
+  uv_key_t current_loop; /* The loop the calling thread is bound to, or NULL. */
+  scheduler_loop_state_t unbound; /* For threads bound to no loop. */
+  unsigned n_running_loopers; /* Protected by global_mutex. */
+  unsigned n_loopers_in_epoll; /* Protected by global_mutex. */
+  struct timespec last_epoll_start; /* When a looper last entered epoll. Protected by global_mutex. */
+
+  /* CB serialization policy, indexed by callback_type. See scheduler_set_cb_serialized. */
+  unsigned char cb_serialized[CALLBACK_TYPE_MAX];
+
+  /* Synchronization. Never held while running a CB, and never acquired while holding an impl's lock. */
+  uv_mutex_t global_mutex;
 
   /* Implementation-dependent. */
   schedulerImpl_t impl;
 } scheduler;
 
 
+/* The TP's work CBs are pure C and never enter JS, so by default they run alongside the looper's CBs. */
+static enum callback_type scheduler__default_unserialized_cbs[] = {
+  UV__WORK_WORK, UV_WORK_CB, UV_FS_WORK_CB, UV_GETADDRINFO_WORK_CB, UV_GETNAMEINFO_WORK_CB
+};
+
 /***********************
  * Private scheduler API declarations.
  ***********************/
@@ -483,11 +622,30 @@ struct
 /* Returns non-zero if scheduler is initialized and magic is OK. */
 static int scheduler__looks_valid (void);
 
-/* Returns the depth of scheduler.mutex. */
-static int scheduler__lock_depth (void);
+/* Returns the state of the loop the calling thread is bound to. */
+static scheduler_loop_state_t * scheduler__current_state (void);
+/* Returns the state of LOOP, creating it if need be. */
+static scheduler_loop_state_t * scheduler__loop_state (uv_loop_t *loop);
+static void scheduler__loop_state_init (scheduler_loop_state_t *state);
+
+/* Returns the depth of STATE's mutex. */
+static int scheduler__lock_depth (scheduler_loop_state_t *state);
 
 /* Runs atexit. Cleans up, ensures the schedule file is closed, etc. */
 static void scheduler__cleanup (void);
+static void scheduler__coverage_init (void);
+/* Returns a digest of the decision made at POINT, or 0 for the default choice or a point we can't observe. */
+static uint64_t scheduler__decision (schedule_point_t point, void *schedule_point_details);
+static void scheduler__coverage_record_decision (scheduler_loop_state_t *state, schedule_point_t point, uint64_t decision);
+/* Fire the USDT probes for the outcome of POINT. See src/uv-probes.h. */
+static void scheduler__fire_probes (schedule_point_t point, void *schedule_point_details);
+#if defined(HAVE_DTRACE)
+/* Returns the number of items in SHUFFLEABLE_ITEMS that the scheduler deferred. */
+static unsigned scheduler__n_deferred (shuffleable_items_t *shuffleable_items);
+#endif
+static void scheduler__coverage_record_cb (scheduler_loop_state_t *state, enum callback_type cb_type);
+/* Track whether every running looper is blocked in epoll. See scheduler_loopers_in_epoll. */
+static void scheduler__epoll_census (scheduler_loop_state_t *state, int entering);
 
 /***********************
  * Public scheduler API definitions.
@@ -496,14 +654,19 @@ static void scheduler__cleanup (void);
 void scheduler_init (scheduler_type_t type, scheduler_mode_t mode, char *schedule_file, void *args)
 {
   struct timespec now;
-  long now_us = 0;
+  unsigned seed = 0;
+  size_t i;
 
   assert(!scheduler_initialized);
 
-  assert(clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0);
-  now_us = timespec_us(&now);
-  mylog(LOG_SCHEDULER, 1, "scheduler_init: seeding RNG with %lu\n", now_us);
-  srand(now_us);
+  /* A fixed seed makes runs comparable, e.g. in benchmark-matrix.sh. */
+  if (!runtime_scheduler_seed(&seed))
+  {
+    assert(clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0);
+    seed = (unsigned) timespec_us(&now);
+  }
+  mylog(LOG_SCHEDULER, 1, "scheduler_init: seeding RNG with %u\n", seed);
+  srand(seed);
 
   /* Shared amongst all scheduler implementations. */
   scheduler.magic = SCHEDULER_MAGIC;
@@ -526,10 +689,18 @@ void scheduler_init (scheduler_type_t type, scheduler_mode_t mode, char *schedul
   scheduler.n_executed = 0;
   scheduler.tidToType = map_create();
   assert(scheduler.tidToType != NULL);
-  scheduler.current_cb_thread = NO_CURRENT_CB_THREAD;
+  scheduler__coverage_init();
 
-  scheduler.mutex = reentrant_mutex_create();
-  assert(scheduler.mutex != NULL);
+  assert(uv_mutex_init(&scheduler.global_mutex) == 0);
+  assert(uv_key_create(&scheduler.current_loop) == 0);
+  scheduler__loop_state_init(&scheduler.unbound);
+  scheduler.n_running_loopers = 0;
+  scheduler.n_loopers_in_epoll = 0;
+
+  for (i = CALLBACK_TYPE_MIN; i < CALLBACK_TYPE_MAX; i++)
+    scheduler.cb_serialized[i] = 1;
+  for (i = 0; i < sizeof scheduler__default_unserialized_cbs / sizeof scheduler__default_unserialized_cbs[0]; i++)
+    scheduler.cb_serialized[scheduler__default_unserialized_cbs[i]] = 0;
 
   /* Specifics based on the scheduler type. */
   switch (scheduler.type)
@@ -553,6 +724,16 @@ void scheduler_init (scheduler_type_t type, scheduler_mode_t mode, char *schedul
 #if defined(ENABLE_SCHEDULER_TP_FREEDOM)
       scheduler_tp_freedom_init(mode, args, &scheduler.impl);
       break;
+#endif
+    case SCHEDULER_TYPE_PCT:
+#if defined(ENABLE_SCHEDULER_PCT)
+      scheduler_pct_init(mode, args, &scheduler.impl);
+      break;
+#endif
+    case SCHEDULER_TYPE_SYSTEMATIC:
+#if defined(ENABLE_SCHEDULER_SYSTEMATIC)
+      scheduler_systematic_init(mode, args, &scheduler.impl);
+      break;
 #endif
     default:
       assert(!"How did we get here?");
@@ -577,9 +758,91 @@ void scheduler_register_thread (thread_type_t type)
   assert(scheduler__looks_valid());
 
   map_insert(scheduler.tidToType, (int) uv_thread_self(), (void *) type);
+  trace_thread_name(thread_type_to_string(type));
   return;
 }
 
+uv_loop_t * scheduler_loop_enter (uv_loop_t *loop)
+{
+  scheduler_loop_state_t *state = NULL;
+  uv_loop_t *prev = NULL;
+  int found = 0;
+
+  assert(scheduler__looks_valid());
+  assert(loop != NULL);
+
+  /* Loops may run on threads other than the one that initialized us. */
+  map_lookup(scheduler.tidToType, (int) uv_thread_self(), &found);
+  if (!found)
+    scheduler_register_thread(THREAD_TYPE_LOOPER);
+
+  prev = (uv_loop_t *) uv_key_get(&scheduler.current_loop);
+  uv_key_set(&scheduler.current_loop, loop);
+
+  state = scheduler__loop_state(loop);
+  state->looper_thread = uv_thread_self();
+
+  uv_mutex_lock(&scheduler.global_mutex);
+  scheduler.n_running_loopers++;
+  uv_mutex_unlock(&scheduler.global_mutex);
+
+  return prev;
+}
+
+void scheduler_loop_leave (uv_loop_t *prev)
+{
+  scheduler_loop_state_t *state = NULL;
+
+  assert(scheduler__looks_valid());
+
+  state = scheduler__current_state();
+  assert(!state->in_epoll);
+  state->looper_thread = NO_CURRENT_CB_THREAD;
+
+  uv_mutex_lock(&scheduler.global_mutex);
+  assert(0 < scheduler.n_running_loopers);
+  scheduler.n_running_loopers--;
+  uv_mutex_unlock(&scheduler.global_mutex);
+
+  uv_key_set(&scheduler.current_loop, prev);
+}
+
+void scheduler_loop_bind (uv_loop_t *loop)
+{
+  assert(scheduler__looks_valid());
+  uv_key_set(&scheduler.current_loop, loop);
+}
+
+void scheduler_loop_close (uv_loop_t *loop)
+{
+  scheduler_loop_state_t *state = (scheduler_loop_state_t *) loop->scheduler_state;
+
+  /* Never ran, never did TP work. */
+  if (state == NULL)
+    return;
+
+  assert(state->magic == SCHEDULER_LOOP_STATE_MAGIC);
+  assert(state->current_cb_thread == NO_CURRENT_CB_THREAD);
+  reentrant_mutex_destroy(state->mutex);
+  uv__free(state);
+  loop->scheduler_state = NULL;
+}
+
+int scheduler_loopers_in_epoll (struct timespec *since)
+{
+  int all_in_epoll = 0;
+
+  assert(scheduler__looks_valid());
+  assert(since != NULL);
+
+  uv_mutex_lock(&scheduler.global_mutex);
+  all_in_epoll = (0 < scheduler.n_running_loopers && scheduler.n_loopers_in_epoll == scheduler.n_running_loopers);
+  *since = scheduler.last_epoll_start;
+  uv_mutex_unlock(&scheduler.global_mutex);
+
+  return all_in_epoll;
+}
+
 void scheduler_register_lcbn (lcbn_t *lcbn)
 {
   assert(scheduler__looks_valid());
@@ -598,48 +861,106 @@ enum callback_type scheduler_next_lcbn_type (void)
 
 void scheduler_thread_yield (schedule_point_t point, void *schedule_point_details)
 {
+  scheduler_loop_state_t *state = NULL;
+  int serialized = 0;
+  uint64_t decision = 0;
+
   assert(scheduler__looks_valid());
+  state = scheduler__current_state();
+  UV_SCHEDULE_POINT_ENTRY((int) point);
+
+  if (point == SCHEDULE_POINT_BEFORE_EXEC_CB)
+    serialized = scheduler_cb_is_serialized(((spd_before_exec_cb_t *) schedule_point_details)->cb_type);
+  else if (point == SCHEDULE_POINT_AFTER_EXEC_CB)
+    serialized = scheduler_cb_is_serialized(((spd_after_exec_cb_t *) schedule_point_details)->cb_type);
 
   if (point == SCHEDULE_POINT_AFTER_EXEC_CB)
   {
     char *cbTypeStr = callback_type_to_string(((spd_after_exec_cb_t *) schedule_point_details)->cb_type);
-    scheduler.n_executed++; /* We hold scheduler__lock. */
+    if (serialized && scheduler__lock_depth(state) == 1)
+      state->prev_top_level_cb_type = ((spd_after_exec_cb_t *) schedule_point_details)->cb_type; /* We hold state->mutex. */
     mylog(LOG_SCHEDULER, 1, "scheduler_thread_yield: Just executed CB of type %s\n", cbTypeStr);
 
+    uv_mutex_lock(&scheduler.global_mutex);
+    scheduler.n_executed++;
     if (!scheduler_closed)
     {
       assert(fwrite(cbTypeStr, strlen(cbTypeStr), 1, scheduler.schedule_fileP) == 1);
       assert(fwrite("\n", 1, 1, scheduler.schedule_fileP) == 1);
     }
+    uv_mutex_unlock(&scheduler.global_mutex);
   }
 
   scheduler.impl.thread_yield(point, schedule_point_details);
+  scheduler__fire_probes(point, schedule_point_details);
 
-  /* Ensure mutex during CB execution. */
+  /* Ensure mutex during execution of serialized CBs.
+   * Unserialized CBs take no part in the CB stack, so they are not part of the fingerprint either. */
   switch (point)
   {
     case SCHEDULE_POINT_BEFORE_EXEC_CB:
-      scheduler__lock();
-      scheduler.current_cb_thread = uv_thread_self();
+      if (!serialized)
+        break;
+      reentrant_mutex_lock(state->mutex);
+      state->current_cb_thread = uv_thread_self();
+      scheduler__coverage_record_cb(state, ((spd_before_exec_cb_t *) schedule_point_details)->cb_type);
       break;
     case SCHEDULE_POINT_AFTER_EXEC_CB:
-      assert(scheduler_current_cb_thread() == uv_thread_self());
+      if (!serialized)
+        break;
+      assert(state->current_cb_thread == uv_thread_self());
       /* If we're executing the bottom-most CB in a stack, there's no current CB thread. */
-      if (scheduler__lock_depth() == 1)
-        scheduler.current_cb_thread = NO_CURRENT_CB_THREAD;
-      scheduler__unlock();
+      if (scheduler__lock_depth(state) == 1)
+        state->current_cb_thread = NO_CURRENT_CB_THREAD;
+      reentrant_mutex_unlock(state->mutex);
+      break;
+    case SCHEDULE_POINT_LOOPER_BEFORE_EPOLL:
+      scheduler__epoll_census(state, 1);
+      trace_begin("epoll", "uv_run", NULL);
+      break;
+    case SCHEDULE_POINT_LOOPER_AFTER_EPOLL:
+      trace_end("epoll", "uv_run");
+      scheduler__epoll_census(state, 0);
       break;
     default:
-      /* Nothing to do. */
+      decision = scheduler__decision(point, schedule_point_details);
+      if (decision != 0)
+      {
+        trace_instant(schedule_point_to_string(point), "scheduler", (unsigned long) decision);
+        causal_record(CAUSAL_DECISION, point, NULL, decision);
+      }
+      scheduler__coverage_record_decision(state, point, decision);
       break;
   }
 
+  UV_SCHEDULE_POINT_RETURN((int) point, (unsigned long) decision);
   return;
 }
 
 uv_thread_t scheduler_current_cb_thread (void)
 {
-  return scheduler.current_cb_thread;
+  return scheduler__current_state()->current_cb_thread;
+}
+
+void scheduler_set_cb_serialized (enum callback_type cb_type, int serialized)
+{
+  assert(scheduler__looks_valid());
+  assert(UV_ALLOC_CB <= cb_type && cb_type <= UV__WORK_DONE);
+  /* Changing the policy while a CB is running would unbalance the lock. */
+  assert(scheduler_current_cb_thread() == NO_CURRENT_CB_THREAD);
+
+  mylog(LOG_SCHEDULER, 1, "scheduler_set_cb_serialized: %s serialized %i\n", callback_type_to_string(cb_type), serialized);
+  scheduler.cb_serialized[cb_type] = (serialized != 0);
+}
+
+int scheduler_cb_is_serialized (enum callback_type cb_type)
+{
+  assert(scheduler__looks_valid());
+
+  /* Unknown types (e.g. CALLBACK_TYPE_ANY) are conservatively serialized. */
+  if (cb_type < CALLBACK_TYPE_MIN || CALLBACK_TYPE_MAX <= cb_type)
+    return 1;
+  return scheduler.cb_serialized[cb_type];
 }
 
 void scheduler_emit (void)
@@ -679,12 +1000,60 @@ long unsigned int scheduler_n_executed (void)
   return scheduler.n_executed;
 }
 
+int scheduler_is_initialized (void)
+{
+  return scheduler_initialized;
+}
+
 scheduler_mode_t scheduler_get_scheduler_mode (void)
 {
   assert(scheduler__looks_valid());
   return scheduler.mode;
 }
 
+uint64_t scheduler_schedule_hash (void)
+{
+  assert(scheduler__looks_valid());
+  return scheduler.schedule_hash;
+}
+
+void scheduler_after_fork (unsigned seed)
+{
+  thread_type_t type;
+  size_t len;
+
+  assert(scheduler__looks_valid());
+  assert(scheduler_current_cb_thread() == NO_CURRENT_CB_THREAD);
+
+  mylog(LOG_SCHEDULER, 1, "scheduler_after_fork: seeding RNG with %u\n", seed);
+
+  /* Only our loop, if any, is still running. */
+  scheduler.n_running_loopers = (uv_key_get(&scheduler.current_loop) != NULL);
+  scheduler.n_loopers_in_epoll = 0;
+  srand(seed);
+
+  /* Only the calling thread survived. New threads may reuse the ids of the old ones. */
+  type = scheduler__get_thread_type();
+  map_destroy(scheduler.tidToType);
+  scheduler.tidToType = map_create();
+  assert(scheduler.tidToType != NULL);
+  map_insert(scheduler.tidToType, (int) uv_thread_self(), (void *) type);
+  trace_thread_name(thread_type_to_string(type));
+
+  /* The parent flushed before forking, so closing our copy writes nothing. */
+  if (!scheduler_closed)
+  {
+    if (fclose(scheduler.schedule_fileP))
+      assert(!"scheduler_after_fork: could not close the inherited schedule file");
+    len = strlen(scheduler.schedule_file);
+    snprintf(scheduler.schedule_file + len, sizeof scheduler.schedule_file - len, ".%i", getpid());
+
+    scheduler.schedule_fileP = fopen(scheduler.schedule_file, "w");
+    assert(scheduler.schedule_fileP != NULL);
+    setvbuf(scheduler.schedule_fileP, scheduler.schedule_cbType_buf, _IOFBF, scheduler.schedule_cbType_buf_size);
+  }
+}
+
 /***********************
  * "Protected" scheduler API definitions.
  ***********************/
@@ -692,13 +1061,13 @@ scheduler_mode_t scheduler_get_scheduler_mode (void)
 void scheduler__lock (void)
 {
   assert(scheduler__looks_valid());
-  reentrant_mutex_lock(scheduler.mutex);
+  reentrant_mutex_lock(scheduler__current_state()->mutex);
 }
 
 void scheduler__unlock (void)
 {
   assert(scheduler__looks_valid());
-  reentrant_mutex_unlock(scheduler.mutex);
+  reentrant_mutex_unlock(scheduler__current_state()->mutex);
 }
 
 thread_type_t scheduler__get_thread_type (void)
@@ -724,10 +1093,53 @@ static int scheduler__looks_valid (void)
           scheduler.magic == SCHEDULER_MAGIC);
 }
 
-static int scheduler__lock_depth (void)
+static scheduler_loop_state_t * scheduler__current_state (void)
 {
-  assert(scheduler__looks_valid());
-  return reentrant_mutex_depth(scheduler.mutex);
+  uv_loop_t *loop = (uv_loop_t *) uv_key_get(&scheduler.current_loop);
+
+  if (loop == NULL)
+    return &scheduler.unbound;
+  return scheduler__loop_state(loop);
+}
+
+static scheduler_loop_state_t * scheduler__loop_state (uv_loop_t *loop)
+{
+  scheduler_loop_state_t *state = (scheduler_loop_state_t *) loop->scheduler_state;
+
+  if (state != NULL)
+    return state;
+
+  /* The looper and the TP might get here at the same time. */
+  uv_mutex_lock(&scheduler.global_mutex);
+  if (loop->scheduler_state == NULL)
+  {
+    state = (scheduler_loop_state_t *) uv__malloc(sizeof *state);
+    assert(state != NULL);
+    scheduler__loop_state_init(state);
+    loop->scheduler_state = state;
+  }
+  state = (scheduler_loop_state_t *) loop->scheduler_state;
+  uv_mutex_unlock(&scheduler.global_mutex);
+
+  return state;
+}
+
+static void scheduler__loop_state_init (scheduler_loop_state_t *state)
+{
+  memset(state, 0, sizeof *state);
+  state->magic = SCHEDULER_LOOP_STATE_MAGIC;
+  state->mutex = reentrant_mutex_create();
+  assert(state->mutex != NULL);
+  state->current_cb_thread = NO_CURRENT_CB_THREAD;
+  state->looper_thread = NO_CURRENT_CB_THREAD;
+  state->in_epoll = 0;
+  state->pending_decisions = 0;
+  state->prev_top_level_cb_type = CALLBACK_TYPE_ANY; /* No CB yet. */
+}
+
+static int scheduler__lock_depth (scheduler_loop_state_t *state)
+{
+  return reentrant_mutex_depth(state->mutex);
 }
 
 static void scheduler__cleanup (void)
@@ -739,6 +1151,20 @@ static void scheduler__cleanup (void)
   if (runtime_should_print_summary())
     fprintf(stderr, "See %s for CB type schedule\n", scheduler.schedule_file);
 
+  if (runtime_should_print_summary())
+    fprintf(stderr, "Schedule fingerprint %08lx%08lx (%lu new edges)\n", SCHEDULER_HASH_HI(scheduler.schedule_hash), SCHEDULER_HASH_LO(scheduler.schedule_hash), scheduler.n_new_edges);
+
+  if (runtime_schedule_fingerprint_file() != NULL)
+  {
+    /* One line per run. Duplicate schedules have duplicate lines. */
+    FILE *fingerprintP = fopen(runtime_schedule_fingerprint_file(), "a");
+    if (fingerprintP != NULL)
+    {
+      fprintf(fingerprintP, "%08lx%08lx %lu %lu\n", SCHEDULER_HASH_HI(scheduler.schedule_hash), SCHEDULER_HASH_LO(scheduler.schedule_hash), scheduler.n_executed, scheduler.n_new_edges);
+      fclose(fingerprintP);
+    }
+  }
+
   assert(fclose(scheduler.schedule_fileP) == 0);
   uv__free(scheduler.schedule_cbType_buf);
 
@@ -746,3 +1172,221 @@ static void scheduler__cleanup (void)
   scheduler.schedule_cbType_buf = NULL;
   scheduler_closed = 1;
 }
+
+/* Map the coverage bitmap: the shared-memory object named by UV_SCHEDULE_BITMAP_SHM, or private memory. */
+static void scheduler__coverage_init (void)
+{
+  const char *shm_name = runtime_schedule_bitmap_shm();
+  struct stat stat_buf;
+  void *map = MAP_FAILED;
+  int fd;
+
+  scheduler.schedule_hash = SCHEDULER_FNV_OFFSET_BASIS;
+  scheduler.n_new_edges = 0;
+
+  if (shm_name != NULL)
+  {
+    /* The driver may create (and clear) the object itself. If it didn't, make a fresh one. */
+    fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600);
+    if (fd != -1)
+    {
+      if (fstat(fd, &stat_buf) == 0 &&
+          (stat_buf.st_size == SCHEDULER_COVERAGE_MAP_SIZE || ftruncate(fd, SCHEDULER_COVERAGE_MAP_SIZE) == 0))
+        map = mmap(NULL, SCHEDULER_COVERAGE_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      uv__close(fd);
+    }
+
+    if (map == MAP_FAILED)
+      mylog(LOG_SCHEDULER, 1, "scheduler__coverage_init: could not map %s, using a private bitmap\n", shm_name);
+  }
+
+  if (map != MAP_FAILED)
+  {
+    scheduler.coverage_map = (unsigned char *) map;
+    scheduler.coverage_map_is_shared = 1;
+  }
+  else
+  {
+    scheduler.coverage_map = (unsigned char *) uv__calloc(1, SCHEDULER_COVERAGE_MAP_SIZE);
+    assert(scheduler.coverage_map != NULL);
+    scheduler.coverage_map_is_shared = 0;
+  }
+}
+
+/* Fold the looper's choice at POINT into pending_decisions.
+ * Only departures from the default (deferrals, a non-FIFO pick) count. How often we
+ * polled, or how many events one epoll_wait returned, is timing, not schedule.
+ * TP threads' choices are not tracked here. They show up in the order of the CBs they lead to. */
+static uint64_t scheduler__decision (schedule_point_t point, void *schedule_point_details)
+{
+  shuffleable_items_t *shuffleable_items = NULL;
+  uint64_t decision = 0;
+  unsigned i;
+
+  switch (point)
+  {
+    case SCHEDULE_POINT_TP_GETTING_WORK:
+      decision = ((spd_getting_work_t *) schedule_point_details)->index;
+      break;
+    case SCHEDULE_POINT_LOOPER_IOPOLL_BEFORE_HANDLING_EVENTS:
+      shuffleable_items = &((spd_iopoll_before_handling_events_t *) schedule_point_details)->shuffleable_items;
+      break;
+    case SCHEDULE_POINT_TIMER_RUN:
+      shuffleable_items = &((spd_timer_run_t *) schedule_point_details)->shuffleable_items;
+      break;
+    case SCHEDULE_POINT_LOOPER_GETTING_DONE:
+      decision = ((spd_getting_done_t *) schedule_point_details)->index;
+      break;
+    case SCHEDULE_POINT_LOOPER_RUN_CLOSING:
+      decision = ((spd_looper_run_closing_t *) schedule_point_details)->defer;
+      break;
+    case SCHEDULE_POINT_LOOPER_RUN_INLINE:
+      /* Inline is the default; sending the work to the TP is the departure. */
+      decision = !((spd_looper_run_inline_t *) schedule_point_details)->run_inline;
+      break;
+    default:
+      /* Not a decision we can observe. */
+      return 0;
+  }
+
+  /* Which items were deferred. */
+  if (shuffleable_items != NULL)
+  {
+    for (i = 0; i < shuffleable_items->nitems; i++)
+      if (!shuffleable_items->thoughts[i])
+      {
+        if (decision == 0)
+          decision = SCHEDULER_FNV_OFFSET_BASIS;
+        SCHEDULER_FNV_FOLD(decision, i);
+      }
+  }
+
+  return decision;
+}
+
+static void scheduler__coverage_record_decision (scheduler_loop_state_t *state, schedule_point_t point, uint64_t decision)
+{
+  if (decision == 0 || uv_thread_self() != state->looper_thread)
+    return;
+
+  SCHEDULER_FNV_FOLD(state->pending_decisions, point);
+  SCHEDULER_FNV_FOLD(state->pending_decisions, decision);
+}
+
+static void scheduler__fire_probes (schedule_point_t point, void *schedule_point_details)
+{
+#if defined(HAVE_DTRACE)
+  spd_timer_ready_t *spd_timer_ready = NULL;
+  int due, skew;
+
+  switch (point)
+  {
+    case SCHEDULE_POINT_TP_GOT_WORK:
+      UV_TP_GET(((spd_got_work_t *) schedule_point_details)->work_item, ((spd_got_work_t *) schedule_point_details)->work_item_num);
+      break;
+    case SCHEDULE_POINT_TP_BEFORE_PUT_DONE:
+      UV_TP_PUT(((spd_before_put_done_t *) schedule_point_details)->work_item);
+      break;
+    case SCHEDULE_POINT_LOOPER_IOPOLL_BEFORE_HANDLING_EVENTS:
+      if (UV_EPOLL_EVENTS_ENABLED())
+      {
+        shuffleable_items_t *shuffleable_items = &((spd_iopoll_before_handling_events_t *) schedule_point_details)->shuffleable_items;
+        UV_EPOLL_EVENTS(shuffleable_items->nitems, scheduler__n_deferred(shuffleable_items));
+      }
+      break;
+    case SCHEDULE_POINT_TIMER_READY:
+      if (UV_TIMER_READY_ENABLED())
+      {
+        spd_timer_ready = (spd_timer_ready_t *) schedule_point_details;
+        due = (spd_timer_ready->timer->timeout <= spd_timer_ready->now);
+        skew = 0;
+        if (spd_timer_ready->ready && !due)
+          skew = 1;
+        else if (!spd_timer_ready->ready && due)
+          skew = -1;
+        UV_TIMER_READY(spd_timer_ready->timer, spd_timer_ready->ready, skew);
+      }
+      break;
+    case SCHEDULE_POINT_TIMER_RUN:
+      if (UV_TIMER_RUN_ENABLED())
+      {
+        shuffleable_items_t *shuffleable_items = &((spd_timer_run_t *) schedule_point_details)->shuffleable_items;
+        UV_TIMER_RUN(shuffleable_items->nitems, scheduler__n_deferred(shuffleable_items));
+      }
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
+#if defined(HAVE_DTRACE)
+static unsigned scheduler__n_deferred (shuffleable_items_t *shuffleable_items)
+{
+  unsigned i, n_deferred = 0;
+
+  for (i = 0; i < shuffleable_items->nitems; i++)
+    if (!shuffleable_items->thoughts[i])
+      n_deferred++;
+  return n_deferred;
+}
+#endif
+
+/* We are about to execute a CB of type CB_TYPE, and hold STATE's mutex. Record its edge.
+ * The edge is the loop's own; with several loops, their edges interleave in the fingerprint. */
+static void scheduler__coverage_record_cb (scheduler_loop_state_t *state, enum callback_type cb_type)
+{
+  int depth = scheduler__lock_depth(state);
+  enum callback_type parent;
+  uint64_t edge = SCHEDULER_FNV_OFFSET_BASIS;
+  unsigned char *counter;
+
+  if (depth == 1)
+    parent = state->prev_top_level_cb_type;
+  else if (depth <= SCHEDULER_CB_STACK_MAX)
+    parent = state->cb_type_stack[depth - 2];
+  else
+    parent = state->cb_type_stack[SCHEDULER_CB_STACK_MAX - 1];
+  if (depth <= SCHEDULER_CB_STACK_MAX)
+    state->cb_type_stack[depth - 1] = cb_type;
+
+  SCHEDULER_FNV_FOLD(edge, cb_type);
+  SCHEDULER_FNV_FOLD(edge, parent);
+  if (uv_thread_self() == state->looper_thread)
+  {
+    SCHEDULER_FNV_FOLD(edge, state->pending_decisions);
+    state->pending_decisions = 0;
+  }
+
+  uv_mutex_lock(&scheduler.global_mutex);
+  SCHEDULER_FNV_FOLD(scheduler.schedule_hash, edge);
+
+  /* Like AFL's hit counters, these may wrap. */
+  counter = &scheduler.coverage_map[(edge ^ (edge >> 32)) & (SCHEDULER_COVERAGE_MAP_SIZE - 1)];
+  if (*counter == 0)
+    scheduler.n_new_edges++;
+  (*counter)++;
+  uv_mutex_unlock(&scheduler.global_mutex);
+}
+
+static void scheduler__epoll_census (scheduler_loop_state_t *state, int entering)
+{
+  /* Only a running looper counts. */
+  if (uv_thread_self() != state->looper_thread)
+    return;
+  assert(state->in_epoll == !entering);
+  state->in_epoll = entering;
+
+  uv_mutex_lock(&scheduler.global_mutex);
+  if (entering)
+  {
+    scheduler.n_loopers_in_epoll++;
+    assert(clock_gettime(CLOCK_MONOTONIC_RAW, &scheduler.last_epoll_start) == 0);
+  }
+  else
+  {
+    assert(0 < scheduler.n_loopers_in_epoll);
+    scheduler.n_loopers_in_epoll--;
+  }
+  uv_mutex_unlock(&scheduler.global_mutex);
+}
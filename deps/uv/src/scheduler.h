@@ -102,8 +102,10 @@ enum scheduler_type_e
   SCHEDULER_TYPE_CBTREE,
   SCHEDULER_TYPE_FUZZING_TIME,
   SCHEDULER_TYPE_TP_FREEDOM,
+  SCHEDULER_TYPE_PCT,
+  SCHEDULER_TYPE_SYSTEMATIC,
 
-  SCHEDULER_TYPE_MAX = SCHEDULER_TYPE_TP_FREEDOM
+  SCHEDULER_TYPE_MAX = SCHEDULER_TYPE_SYSTEMATIC
 };
 typedef enum scheduler_type_e scheduler_type_t;
 const char * scheduler_type_to_string (scheduler_type_t type);
@@ -153,6 +155,12 @@ enum schedule_point_e
 
   SCHEDULE_POINT_LOOPER_RUN_CLOSING, /* LOOPER: In uv__run_closing_handles, deciding whether to continue or stop. */
 
+  SCHEDULE_POINT_LOOPER_ACCEPT, /* LOOPER: uv__server_io, after accepting a batch of new connections. */
+
+  SCHEDULE_POINT_LOOPER_RUN_INLINE, /* LOOPER: uv_work_should_inline, the embedder offers to run a small work item on the looper instead of the TP. */
+
+  SCHEDULE_POINT_LOOPER_SOURCE_CLOSED, /* LOOPER: uv__io_close or uv__timer_close. No decision; schedulers that track event sources drop this one. */
+
   /* Timer schedule points (also run by LOOPER). */
   SCHEDULE_POINT_TIMER_READY, /* Timer: I'm in uv__ready_timers considering a pending timer. */
   SCHEDULE_POINT_TIMER_RUN, /* Timer: I'm in uv__run_timers considering the set of ready timers. */
@@ -313,6 +321,49 @@ void spd_looper_run_closing_init (spd_looper_run_closing_t *spd_looper_run_closi
 /* Returns non-zero if valid. */
 int spd_looper_run_closing_is_valid (spd_looper_run_closing_t *spd_looper_run_closing);
 
+struct spd_looper_accept_s
+{
+  int magic;
+
+  /* nitems:   INPUT         The number of accepted connections.
+   * items:    INPUT/OUTPUT  Array of accepted fds (int's). Scheduler may shuffle them.
+   *                         Each gets its own UV_CONNECTION_CB, in the final order of items.
+   * thoughts: Unused.
+   */
+  shuffleable_items_t shuffleable_items;
+};
+typedef struct spd_looper_accept_s spd_looper_accept_t;
+
+void spd_looper_accept_init (spd_looper_accept_t *spd_looper_accept);
+/* Returns non-zero if valid. */
+int spd_looper_accept_is_valid (spd_looper_accept_t *spd_looper_accept);
+
+struct spd_looper_run_inline_s
+{
+  int magic;
+
+  size_t size; /* INPUT: The embedder's measure of the work, e.g. bytes of input. */
+  int run_inline; /* OUTPUT: 1 to run the work on the looper, 0 to queue it to the TP as usual. */
+};
+typedef struct spd_looper_run_inline_s spd_looper_run_inline_t;
+
+void spd_looper_run_inline_init (spd_looper_run_inline_t *spd_looper_run_inline);
+/* Returns non-zero if valid. */
+int spd_looper_run_inline_is_valid (spd_looper_run_inline_t *spd_looper_run_inline);
+
+struct spd_looper_source_closed_s
+{
+  int magic;
+
+  int fd;            /* INPUT: The fd whose watcher is closing, or -1. Its number may be reused right away. */
+  uv_timer_t *timer; /* INPUT: The timer being closed, or NULL. */
+};
+typedef struct spd_looper_source_closed_s spd_looper_source_closed_t;
+
+void spd_looper_source_closed_init (spd_looper_source_closed_t *spd_looper_source_closed);
+/* Returns non-zero if valid. */
+int spd_looper_source_closed_is_valid (spd_looper_source_closed_t *spd_looper_source_closed);
+
 struct spd_timer_ready_s
 {
   int magic;
@@ -373,12 +424,44 @@ int schedule_point_looks_valid (schedule_point_t point, void *pointDetails);
  */
 void scheduler_init (scheduler_type_t type, scheduler_mode_t mode, char *schedule_file, void *args);
 
+/* Returns non-zero once scheduler_init has run.
+ * For paths that only yield if a loop has already brought the scheduler up. */
+int scheduler_is_initialized (void);
+
 /* Register the calling thread under the specified type. 
  * Each thread should call this while it is initializing. 
  * Once set, a thread's type should not change.
  */
 void scheduler_register_thread (thread_type_t type);
 
+/* Loops.
+ * Each loop has its own scheduler state, including the lock that serializes its CBs.
+ * CBs of independent loops (say, a worker's loop on another thread) may run in parallel.
+ * Each CB is charged to the loop the calling thread is bound to. A thread bound
+ * to no loop shares one process-wide state with the other unbound threads.
+ *
+ * The implementation's state (scheduler.impl) is still shared by all loops.
+ */
+
+/* The calling thread is about to run LOOP (uv_run).
+ * Registers the thread as a THREAD_TYPE_LOOPER if it is new to us, and binds it to LOOP.
+ * Returns the previous binding, for scheduler_loop_leave. */
+uv_loop_t * scheduler_loop_enter (uv_loop_t *loop);
+/* The calling thread is done running its loop. Restore binding PREV. */
+void scheduler_loop_leave (uv_loop_t *prev);
+
+/* Bind the calling thread to LOOP, or to no loop if NULL.
+ * The TP binds itself to a work item's loop while it works on it. */
+void scheduler_loop_bind (uv_loop_t *loop);
+
+/* LOOP is closing. Release its scheduler state. */
+void scheduler_loop_close (uv_loop_t *loop);
+
+/* Returns non-zero if every loop being run is blocked in epoll, in which case no
+ * more TP work is coming until some fd or timer fires.
+ * SINCE is set to when the last of them entered epoll. */
+int scheduler_loopers_in_epoll (struct timespec *since);
+
 /* Register LCBN for potential scheduler_execute_lcbn()'d later. 
  * Caller must ensure mutex for deterministic replay.
  */
@@ -397,7 +480,8 @@ enum callback_type scheduler_next_lcbn_type (void);
  *   RECORD mode: might make a random choice about who goes next
  *   REPLAY mode: lets us have reproducible results
  *
- * For points SCHEDULE_POINT_{BEFORE,AFTER}_EXEC_CB, ensures mutex during execution of CB.
+ * For points SCHEDULE_POINT_{BEFORE,AFTER}_EXEC_CB, ensures mutex during execution of CB,
+ * if its type is serialized (scheduler_cb_is_serialized).
  *
  * INPUT:         point: What state is the calling thread in?
  * INPUT/OUTPUT:  schedule_point_details: The spd_X associated with the point.
@@ -405,7 +489,7 @@ enum callback_type scheduler_next_lcbn_type (void);
  */
 void scheduler_thread_yield (schedule_point_t point, void *schedule_point_details);
 
-/* Returns the thread id of the thread currently executing a CB, or NO_CURRENT_CB_THREAD.
+/* Returns the thread id of the thread currently executing a serialized CB of the calling thread's loop, or NO_CURRENT_CB_THREAD.
  * Only thread-safe if the calling thread is the one currently executing a CB.
  * This facilitates a clean release in the exit() path:
  *   while (uv_thread_self() == scheduler_current_cb_thread())
@@ -418,6 +502,19 @@ void scheduler_thread_yield (schedule_point_t point, void *schedule_point_detail
 static const uv_thread_t NO_CURRENT_CB_THREAD = -1;
 uv_thread_t scheduler_current_cb_thread (void);
 
+/* CB serialization policy.
+ * A serialized CB holds its loop's lock while it runs, so it never overlaps another serialized CB of the loop.
+ * An unserialized CB still yields at SCHEDULE_POINT_{BEFORE,AFTER}_EXEC_CB, but runs outside the lock.
+ * By default every type is serialized except the TP's work CBs (UV__WORK_WORK, UV_WORK_CB, UV_*_WORK_CB),
+ * which are pure C and never enter JS. Unserializing a type only helps if the types it is nested in
+ * are unserialized too. Wrapper types (is_wrapper_cb) never reach the scheduler at all.
+ *
+ * Set the policy before running any CBs; see UV_SCHEDULER_UNSERIALIZED_CBS in uv-common.c.
+ * CB_TYPE must be a CB type, UV_ALLOC_CB through UV__WORK_DONE. Other types are always serialized.
+ */
+void scheduler_set_cb_serialized (enum callback_type cb_type, int serialized);
+int scheduler_cb_is_serialized (enum callback_type cb_type);
+
 /* Dump the schedule (whatever that means; depends on the scheduler implementation) to the schedule_file specified in schedule_init. 
  *   RECORD mode: duh
  *   REPLAY mode: we don't want to overwrite the input schedule, so we emit to sprintf("%s-replay", schedule_file). 
@@ -445,12 +542,30 @@ long unsigned scheduler_n_executed (void);
  */
 scheduler_mode_t scheduler_get_scheduler_mode (void);
 
+/* The schedule fingerprint: a hash of the sequence of edges executed so far.
+ * An edge is (CB type, parent CB type, looper decisions since the previous CB).
+ * The parent is the enclosing CB of a nested CB, else the previous top-level CB.
+ * Two runs with the same fingerprint (almost certainly) executed the same schedule.
+ *
+ * Each edge also bumps its counter in an AFL-style coverage bitmap of
+ * SCHEDULER_COVERAGE_MAP_SIZE bytes. If UV_SCHEDULE_BITMAP_SHM names a POSIX
+ * shared-memory object, the bitmap lives there, so a driver that leaves it
+ * uncleared between runs can watch novelty plateau. */
+#define SCHEDULER_COVERAGE_MAP_SIZE (1 << 16)
+uint64_t scheduler_schedule_hash (void);
+
+/* Call in the child after fork(), from the thread that called fork().
+ * The other threads are gone: forget them, reseed the RNG with SEED,
+ * and record the rest of the schedule in "<schedule_file>.<pid>".
+ * No thread may have been executing a CB at the time of the fork(). */
+void scheduler_after_fork (unsigned seed);
+
 /*********************************
  * "Protected" scheduler methods shared by the scheduler implementations.
  * Only scheduler implementation code should call these.
  *********************************/
 
-/* Re-entrant lock/unlock. */
+/* Re-entrant lock/unlock of the calling thread's loop. */
 void scheduler__lock (void);
 void scheduler__unlock (void);
 
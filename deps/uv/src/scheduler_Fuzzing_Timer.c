@@ -102,6 +102,8 @@ scheduler_fuzzing_timer_thread_yield (schedule_point_t point, void *pointDetails
   /* Don't sleep at certain schedule points, where doing so merely delays forward progress. */
   if (point == SCHEDULE_POINT_TP_AFTER_PUT_DONE /* This thread is not about to do anything. */
    || point == SCHEDULE_POINT_AFTER_EXEC_CB /* This thread holds the mutex, and has already finished its CB. */
+   || point == SCHEDULE_POINT_LOOPER_ACCEPT /* The connections are already accepted; a sleep only delays announcing them. */
+   || point == SCHEDULE_POINT_LOOPER_SOURCE_CLOSED /* Bookkeeping on the close path, not a choice. */
      )
   {
     could_sleep = 0;
@@ -149,6 +151,11 @@ scheduler_fuzzing_timer_thread_yield (schedule_point_t point, void *pointDetails
       /* Don't short-circuit; close all handles. */
       ((spd_looper_run_closing_t *) pointDetails)->defer = 0;
       break;
+    case SCHEDULE_POINT_LOOPER_RUN_INLINE:
+      assert(scheduler__get_thread_type() == THREAD_TYPE_LOOPER);
+      /* We fuzz with delays in the TP, not with the choice of thread. */
+      ((spd_looper_run_inline_t *) pointDetails)->run_inline = 1;
+      break;
     case SCHEDULE_POINT_TIMER_READY:
       assert(scheduler__get_thread_type() == THREAD_TYPE_LOOPER);
       spd_timer_ready = (spd_timer_ready_t *) pointDetails;
@@ -165,6 +172,13 @@ scheduler_fuzzing_timer_thread_yield (schedule_point_t point, void *pointDetails
       for (iu = 0; iu < spd_timer_run->shuffleable_items.nitems; iu++)
         spd_timer_run->shuffleable_items.thoughts[i] = 1;
       break;
+    case SCHEDULE_POINT_LOOPER_ACCEPT:
+      assert(scheduler__get_thread_type() == THREAD_TYPE_LOOPER);
+      /* Announce new connections in the order we accepted them. */
+      break;
+    case SCHEDULE_POINT_LOOPER_SOURCE_CLOSED:
+      /* We don't track sources. */
+      break;
     default:
       /* Nothing to do. */
       break;
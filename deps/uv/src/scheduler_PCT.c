@@ -0,0 +1,552 @@
+#include "scheduler_PCT.h"
+
+#include "unix/linux-syscalls.h" /* struct uv__epoll_event */
+#include "scheduler.h"
+#include "timespec_funcs.h"
+#include "uv-random.h"
+#include "uv-common.h" /* Allocators */
+#include "uv-threadpool.h" /* struct uv__work */
+
+#include <unistd.h> /* usleep, unlink */
+#include <string.h> /* memcpy */
+#include <stdlib.h> /* getenv, qsort */
+#include <stdint.h> /* uintptr_t */
+#include <assert.h>
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+static int SCHEDULER_PCT_MAGIC = 60719348;
+
+/* Initial priorities are drawn from [depth, depth + SCHEDULER_PCT_PRIORITY_RANGE).
+ * Change point i demotes to depth - 1 - i, below every initial priority. */
+#define SCHEDULER_PCT_PRIORITY_RANGE (1 << 30)
+#define SCHEDULER_PCT_N_BUCKETS 1024
+
+/* A logical event source and its priority. */
+struct pct_source_s
+{
+  uintptr_t source; /* A TP work item's QUEUE, an fd, or a uv_timer_t *.
+                     * A work item's done event is its async's fd. */
+  int priority;
+  struct pct_source_s *next;
+};
+typedef struct pct_source_s pct_source_t;
+
+/* Returns the source of an item in a shuffleable_items_t. */
+typedef uintptr_t (*pct_source_of_func) (void *item);
+
+/* implDetails for the PCT scheduler. */
+
+static struct
+{
+  int magic;
+
+  int mode;
+  scheduler_pct_args_t args;
+
+  /* Accessed by looper and TP. Protected by mutex. */
+  uv_mutex_t mutex;
+  pct_source_t *sources[SCHEDULER_PCT_N_BUCKETS]; /* Hash table of source -> priority. */
+  unsigned n_sources;
+  uintptr_t last_first; /* The source that most recently went first. */
+  int have_last_first;
+
+  /* Only touched at SCHEDULE_POINT_AFTER_EXEC_CB. Protected by mutex. */
+  long unsigned *change_points; /* depth-1 CB counts, ascending. */
+  int next_change_point;
+} pct_implDetails;
+
+/***********************
+ * Private API declarations
+ ***********************/
+
+/* Returns non-zero if the scheduler_pct looks valid (e.g. is initialized properly). */
+static int scheduler_pct__looks_valid (void);
+
+static void scheduler_pct__lock (void);
+static void scheduler_pct__unlock (void);
+
+/* Returns the hash bucket for SOURCE. */
+static pct_source_t ** scheduler_pct__bucket (uintptr_t source);
+
+/* Returns the priority of SOURCE, assigning a random one if this is the first time we've seen it.
+ * Caller must hold the lock. */
+static int scheduler_pct__priority (uintptr_t source);
+/* Add SOURCE with PRIORITY. SOURCE must be new. Caller must hold the lock. */
+static void scheduler_pct__add (uintptr_t source, int priority);
+/* Set the priority of SOURCE, if we know it. Caller must hold the lock. */
+static void scheduler_pct__set_priority (uintptr_t source, int priority);
+/* Forget SOURCE. Caller must hold the lock. */
+static void scheduler_pct__forget (uintptr_t source);
+/* HEIR takes over SOURCE's priority, and its place as last_first. SOURCE is forgotten.
+ * Caller must hold the lock. */
+static void scheduler_pct__inherit (uintptr_t heir, uintptr_t source);
+/* SOURCE went first. Caller must hold the lock. */
+static void scheduler_pct__set_last_first (uintptr_t source);
+
+/* Order items by descending priority, within chunks of degrees_of_freedom (-1 means one chunk).
+ * The order among equal priorities is kept. The first item becomes last_first. */
+static void scheduler_pct__order_items (int degrees_of_freedom, shuffleable_items_t *shuffleable_items, pct_source_of_func source_of);
+
+/* Returns the index of the highest-priority entry among the first degrees_of_freedom entries in q. */
+static int scheduler_pct__pick_from_queue (int degrees_of_freedom, QUEUE *q);
+
+static uintptr_t scheduler_pct__epoll_event_source (void *item);
+static uintptr_t scheduler_pct__fd_source (void *item);
+static uintptr_t scheduler_pct__pointer_source (void *item);
+
+static int scheduler_pct__cmp_change_points (const void *a, const void *b);
+
+/***********************
+ * Public API definitions
+ ***********************/
+
+void
+scheduler_pct_init (scheduler_mode_t mode, void *args, schedulerImpl_t *schedulerImpl)
+{
+  const char *tpSize = NULL;
+  int i;
+
+  assert(args != NULL);
+  assert(schedulerImpl != NULL);
+
+  /* Like TP_FREEDOM, we simulate a multi-thread TP using a single TP thread. */
+  tpSize = getenv("UV_THREADPOOL_SIZE");
+  assert(tpSize != NULL && atoi(tpSize) == 1);
+
+  /* Populate schedulerImpl. */
+  schedulerImpl->register_lcbn = scheduler_pct_register_lcbn;
+  schedulerImpl->next_lcbn_type = scheduler_pct_next_lcbn_type;
+  schedulerImpl->thread_yield = scheduler_pct_thread_yield;
+  schedulerImpl->emit = scheduler_pct_emit;
+  schedulerImpl->lcbns_remaining = scheduler_pct_lcbns_remaining;
+  schedulerImpl->schedule_has_diverged = scheduler_pct_schedule_has_diverged;
+
+  /* Set implDetails. */
+  memset(&pct_implDetails, 0, sizeof pct_implDetails);
+  pct_implDetails.magic = SCHEDULER_PCT_MAGIC;
+  pct_implDetails.mode = mode;
+  pct_implDetails.args = *(scheduler_pct_args_t *) args;
+
+  assert(1 <= pct_implDetails.args.depth);
+  assert(1 <= pct_implDetails.args.max_cbs);
+  assert(pct_implDetails.args.tp_degrees_of_freedom == -1 || 1 <= pct_implDetails.args.tp_degrees_of_freedom);
+  assert(pct_implDetails.args.iopoll_degrees_of_freedom == -1 || 1 <= pct_implDetails.args.iopoll_degrees_of_freedom);
+  assert(pct_implDetails.args.timer_degrees_of_freedom == -1 || 1 <= pct_implDetails.args.timer_degrees_of_freedom);
+
+  assert(uv_mutex_init(&pct_implDetails.mutex) == 0);
+
+  /* Choose the change points. */
+  pct_implDetails.change_points = (long unsigned *) uv__malloc(pct_implDetails.args.depth * sizeof(long unsigned));
+  assert(pct_implDetails.change_points != NULL);
+  for (i = 0; i < pct_implDetails.args.depth - 1; i++)
+    pct_implDetails.change_points[i] = 1 + rand_int(pct_implDetails.args.max_cbs);
+  qsort(pct_implDetails.change_points, pct_implDetails.args.depth - 1, sizeof(long unsigned), scheduler_pct__cmp_change_points);
+  pct_implDetails.next_change_point = 0;
+
+  for (i = 0; i < pct_implDetails.args.depth - 1; i++)
+    mylog(LOG_SCHEDULER, 1, "scheduler_pct_init: change point %i at CB %lu\n", i, pct_implDetails.change_points[i]);
+
+  return;
+}
+
+void
+scheduler_pct_register_lcbn (lcbn_t *lcbn)
+{
+  assert(scheduler_pct__looks_valid());
+  assert(lcbn != NULL && lcbn_looks_valid(lcbn));
+
+  return;
+}
+
+enum callback_type
+scheduler_pct_next_lcbn_type (void)
+{
+  assert(scheduler_pct__looks_valid());
+  return CALLBACK_TYPE_ANY;
+}
+
+void
+scheduler_pct_thread_yield (schedule_point_t point, void *pointDetails)
+{
+  unsigned i;
+
+  assert(scheduler_pct__looks_valid());
+  /* Ensure {point, pointDetails} are consistent. Afterwards we know the inputs are correct. */
+  assert(schedule_point_looks_valid(point, pointDetails));
+
+  switch (point)
+  {
+    case SCHEDULE_POINT_AFTER_EXEC_CB:
+    {
+      /* Priority change points. With several loops, their CBs may finish concurrently: take our lock. */
+      long unsigned n_executed = scheduler_n_executed();
+      scheduler_pct__lock();
+      while (pct_implDetails.next_change_point < pct_implDetails.args.depth - 1 &&
+             pct_implDetails.change_points[pct_implDetails.next_change_point] <= n_executed)
+      {
+        int new_priority = pct_implDetails.args.depth - 1 - pct_implDetails.next_change_point;
+
+        if (pct_implDetails.have_last_first)
+        {
+          mylog(LOG_SCHEDULER, 1, "scheduler_pct_thread_yield: change point %i (CB %lu): source %p gets priority %i\n", pct_implDetails.next_change_point, n_executed, (void *) pct_implDetails.last_first, new_priority);
+          scheduler_pct__set_priority(pct_implDetails.last_first, new_priority);
+        }
+
+        pct_implDetails.next_change_point++;
+      }
+      scheduler_pct__unlock();
+      break;
+    }
+    case SCHEDULE_POINT_TP_WANTS_WORK:
+    {
+      /* Give the queue a chance to fill, so that there is a choice to make. */
+      spd_wants_work_t *spd_wants_work = (spd_wants_work_t *) pointDetails;
+      int deg_freedom = pct_implDetails.args.tp_degrees_of_freedom;
+      int queue_len = 0;
+      QUEUE *q = NULL;
+      struct timespec now, wait_diff;
+      long wait_diff_us = 0;
+
+      QUEUE_LEN(queue_len, q, spd_wants_work->wq);
+
+      assert(clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0);
+      if (timespec_cmp(&now, &spd_wants_work->start_time) == 1)
+      {
+        timespec_sub(&now, &spd_wants_work->start_time, &wait_diff);
+        wait_diff_us = timespec_us(&wait_diff);
+      }
+
+      if (0 < deg_freedom && deg_freedom <= queue_len)
+        spd_wants_work->should_get_work = 1;
+      else if (pct_implDetails.args.tp_max_delay_us <= (useconds_t) wait_diff_us)
+        spd_wants_work->should_get_work = 1;
+      else
+        spd_wants_work->should_get_work = 0;
+      break;
+    }
+    case SCHEDULE_POINT_TP_GETTING_WORK:
+      ((spd_getting_work_t *) pointDetails)->index = scheduler_pct__pick_from_queue(pct_implDetails.args.tp_degrees_of_freedom, ((spd_getting_work_t *) pointDetails)->wq);
+      break;
+    case SCHEDULE_POINT_TP_BEFORE_PUT_DONE:
+    {
+      /* The done event is the work item's async firing. It competes with the same priority. */
+      struct uv__work *w = ((spd_before_put_done_t *) pointDetails)->work_item;
+      uv_async_t *async = (uv_async_t *) w->ptr_and_async->async_buf;
+      scheduler_pct__lock();
+      scheduler_pct__inherit((uintptr_t) async->io_watcher.fd, (uintptr_t) &w->wq);
+      scheduler_pct__unlock();
+      break;
+    }
+    case SCHEDULE_POINT_LOOPER_GETTING_DONE:
+      ((spd_getting_done_t *) pointDetails)->index = scheduler_pct__pick_from_queue(pct_implDetails.args.tp_degrees_of_freedom, ((spd_getting_done_t *) pointDetails)->wq);
+      break;
+    case SCHEDULE_POINT_LOOPER_IOPOLL_BEFORE_HANDLING_EVENTS:
+    {
+      spd_iopoll_before_handling_events_t *spd_iopoll_before_handling_events = (spd_iopoll_before_handling_events_t *) pointDetails;
+
+      scheduler_pct__order_items(pct_implDetails.args.iopoll_degrees_of_freedom, &spd_iopoll_before_handling_events->shuffleable_items, scheduler_pct__epoll_event_source);
+      /* PCT reorders; it never defers. */
+      for (i = 0; i < spd_iopoll_before_handling_events->shuffleable_items.nitems; i++)
+        spd_iopoll_before_handling_events->shuffleable_items.thoughts[i] = 1;
+      break;
+    }
+    case SCHEDULE_POINT_LOOPER_ACCEPT:
+      scheduler_pct__order_items(pct_implDetails.args.iopoll_degrees_of_freedom, &((spd_looper_accept_t *) pointDetails)->shuffleable_items, scheduler_pct__fd_source);
+      break;
+    case SCHEDULE_POINT_LOOPER_RUN_CLOSING:
+      ((spd_looper_run_closing_t *) pointDetails)->defer = 0;
+      break;
+    case SCHEDULE_POINT_LOOPER_RUN_INLINE:
+      /* Work run inline is no event source to prioritize. */
+      ((spd_looper_run_inline_t *) pointDetails)->run_inline = 1;
+      break;
+    case SCHEDULE_POINT_LOOPER_SOURCE_CLOSED:
+    {
+      /* A reused fd number or timer address is a new source. */
+      spd_looper_source_closed_t *spd_looper_source_closed = (spd_looper_source_closed_t *) pointDetails;
+      scheduler_pct__lock();
+      if (spd_looper_source_closed->fd != -1)
+        scheduler_pct__forget((uintptr_t) spd_looper_source_closed->fd);
+      if (spd_looper_source_closed->timer != NULL)
+        scheduler_pct__forget((uintptr_t) spd_looper_source_closed->timer);
+      scheduler_pct__unlock();
+      break;
+    }
+    case SCHEDULE_POINT_TIMER_READY:
+    {
+      spd_timer_ready_t *spd_timer_ready = (spd_timer_ready_t *) pointDetails;
+      spd_timer_ready->ready = (spd_timer_ready->timer->timeout < spd_timer_ready->now);
+      break;
+    }
+    case SCHEDULE_POINT_TIMER_RUN:
+    {
+      spd_timer_run_t *spd_timer_run = (spd_timer_run_t *) pointDetails;
+
+      if (pct_implDetails.args.timer_degrees_of_freedom != 1)
+        scheduler_pct__order_items(pct_implDetails.args.timer_degrees_of_freedom, &spd_timer_run->shuffleable_items, scheduler_pct__pointer_source);
+      for (i = 0; i < spd_timer_run->shuffleable_items.nitems; i++)
+        spd_timer_run->shuffleable_items.thoughts[i] = 1;
+      break;
+    }
+    case SCHEDULE_POINT_TIMER_NEXT_TIMEOUT:
+    {
+      spd_timer_next_timeout_t *spd_timer_next_timeout = (spd_timer_next_timeout_t *) pointDetails;
+      if (spd_timer_next_timeout->timer->timeout < spd_timer_next_timeout->now)
+        spd_timer_next_timeout->time_until_timer = 0;
+      else
+        spd_timer_next_timeout->time_until_timer = spd_timer_next_timeout->timer->timeout - spd_timer_next_timeout->now;
+      break;
+    }
+    default:
+      /* Nothing to do. */
+      break;
+  }
+
+  return;
+}
+
+void
+scheduler_pct_emit (char *output_file)
+{
+  assert(scheduler_pct__looks_valid());
+  unlink(output_file);
+  return;
+}
+
+int
+scheduler_pct_lcbns_remaining (void)
+{
+  assert(scheduler_pct__looks_valid());
+  return -1;
+}
+
+int
+scheduler_pct_schedule_has_diverged (void)
+{
+  assert(scheduler_pct__looks_valid());
+  return -1;
+}
+
+/***********************
+ * Private API definitions.
+ ***********************/
+
+static int
+scheduler_pct__looks_valid (void)
+{
+  return (pct_implDetails.magic == SCHEDULER_PCT_MAGIC);
+}
+
+static void
+scheduler_pct__lock (void)
+{
+  uv_mutex_lock(&pct_implDetails.mutex);
+}
+
+static void
+scheduler_pct__unlock (void)
+{
+  uv_mutex_unlock(&pct_implDetails.mutex);
+}
+
+static pct_source_t **
+scheduler_pct__bucket (uintptr_t source)
+{
+  /* fds are small and pointers are aligned; mix the bits a little. */
+  return &pct_implDetails.sources[(source ^ (source >> 4) ^ (source >> 12)) % SCHEDULER_PCT_N_BUCKETS];
+}
+
+static int
+scheduler_pct__priority (uintptr_t source)
+{
+  pct_source_t *s = NULL;
+  int priority;
+
+  for (s = *scheduler_pct__bucket(source); s != NULL; s = s->next)
+    if (s->source == source)
+      return s->priority;
+
+  priority = pct_implDetails.args.depth + rand_int(SCHEDULER_PCT_PRIORITY_RANGE);
+  scheduler_pct__add(source, priority);
+  return priority;
+}
+
+static void
+scheduler_pct__add (uintptr_t source, int priority)
+{
+  pct_source_t **bucket = scheduler_pct__bucket(source);
+  pct_source_t *s = NULL;
+
+  s = (pct_source_t *) uv__malloc(sizeof *s);
+  assert(s != NULL);
+  s->source = source;
+  s->priority = priority;
+  s->next = *bucket;
+  *bucket = s;
+  pct_implDetails.n_sources++;
+
+  mylog(LOG_SCHEDULER, 5, "scheduler_pct__add: new source %p priority %i (%u sources)\n", (void *) source, priority, pct_implDetails.n_sources);
+}
+
+static void
+scheduler_pct__set_priority (uintptr_t source, int priority)
+{
+  pct_source_t *s = NULL;
+
+  for (s = *scheduler_pct__bucket(source); s != NULL; s = s->next)
+    if (s->source == source)
+    {
+      s->priority = priority;
+      return;
+    }
+}
+
+static void
+scheduler_pct__forget (uintptr_t source)
+{
+  pct_source_t **sP = NULL, *s = NULL;
+
+  for (sP = scheduler_pct__bucket(source); *sP != NULL; sP = &(*sP)->next)
+    if ((*sP)->source == source)
+    {
+      s = *sP;
+      *sP = s->next;
+      uv__free(s);
+      pct_implDetails.n_sources--;
+      break;
+    }
+
+  if (pct_implDetails.have_last_first && pct_implDetails.last_first == source)
+    pct_implDetails.have_last_first = 0;
+}
+
+static void
+scheduler_pct__inherit (uintptr_t heir, uintptr_t source)
+{
+  int priority = scheduler_pct__priority(source);
+  int was_last_first = (pct_implDetails.have_last_first && pct_implDetails.last_first == source);
+
+  scheduler_pct__forget(source);
+  scheduler_pct__forget(heir);
+  scheduler_pct__add(heir, priority);
+  if (was_last_first)
+    scheduler_pct__set_last_first(heir);
+}
+
+static void
+scheduler_pct__set_last_first (uintptr_t source)
+{
+  pct_implDetails.last_first = source;
+  pct_implDetails.have_last_first = 1;
+}
+
+static void
+scheduler_pct__order_items (int degrees_of_freedom, shuffleable_items_t *shuffleable_items, pct_source_of_func source_of)
+{
+  char *items = (char *) shuffleable_items->items;
+  size_t item_size = shuffleable_items->item_size;
+  unsigned nitems = shuffleable_items->nitems;
+  unsigned chunk_len, chunk_start, i, j;
+  int *priorities = NULL, priority;
+  void *tmp = NULL;
+
+  if (nitems == 0)
+    return;
+
+  priorities = (int *) uv__malloc(nitems * sizeof(int));
+  tmp = uv__malloc(item_size);
+  assert(priorities != NULL && tmp != NULL);
+
+  scheduler_pct__lock();
+  for (i = 0; i < nitems; i++)
+    priorities[i] = scheduler_pct__priority(source_of(items + i*item_size));
+
+  chunk_len = (degrees_of_freedom == -1) ? nitems : (unsigned) degrees_of_freedom;
+  for (chunk_start = 0; chunk_start < nitems; chunk_start += chunk_len)
+  {
+    unsigned chunk_end = MIN(chunk_start + chunk_len, nitems);
+
+    /* Insertion sort, descending. Chunks are short. */
+    for (i = chunk_start + 1; i < chunk_end; i++)
+    {
+      priority = priorities[i];
+      memcpy(tmp, items + i*item_size, item_size);
+      for (j = i; chunk_start < j && priorities[j-1] < priority; j--)
+      {
+        priorities[j] = priorities[j-1];
+        memcpy(items + j*item_size, items + (j-1)*item_size, item_size);
+      }
+      priorities[j] = priority;
+      memcpy(items + j*item_size, tmp, item_size);
+    }
+  }
+
+  scheduler_pct__set_last_first(source_of(items));
+  scheduler_pct__unlock();
+
+  mylog(LOG_SCHEDULER, 5, "scheduler_pct__order_items: ordered %u items, first has priority %i\n", nitems, priorities[0]);
+
+  uv__free(priorities);
+  uv__free(tmp);
+}
+
+static int
+scheduler_pct__pick_from_queue (int degrees_of_freedom, QUEUE *wq)
+{
+  QUEUE *q = NULL, *best_q = NULL;
+  int ix = 0, best_ix = 0, best_priority = -1, priority;
+
+  assert(wq != NULL && !QUEUE_EMPTY(wq));
+
+  scheduler_pct__lock();
+  QUEUE_FOREACH(q, wq)
+  {
+    if (degrees_of_freedom != -1 && degrees_of_freedom <= ix)
+      break;
+
+    priority = scheduler_pct__priority((uintptr_t) q);
+    if (best_priority < priority)
+    {
+      best_q = q;
+      best_ix = ix;
+      best_priority = priority;
+    }
+    ix++;
+  }
+
+  /* A work item keeps its priority until it is done. Then its done event inherits it, and the
+   * QUEUE is forgotten so a later item at the same address gets a fresh priority. */
+  assert(best_q != NULL);
+  scheduler_pct__set_last_first((uintptr_t) best_q);
+  scheduler_pct__unlock();
+
+  mylog(LOG_SCHEDULER, 5, "scheduler_pct__pick_from_queue: chose index %i (priority %i)\n", best_ix, best_priority);
+  return best_ix;
+}
+
+static uintptr_t
+scheduler_pct__epoll_event_source (void *item)
+{
+  /* linux-core.c stores the fd in data. */
+  return (uintptr_t) ((struct uv__epoll_event *) item)->data;
+}
+
+static uintptr_t
+scheduler_pct__fd_source (void *item)
+{
+  return (uintptr_t) *(int *) item;
+}
+
+static uintptr_t
+scheduler_pct__pointer_source (void *item)
+{
+  return (uintptr_t) *(void **) item;
+}
+
+static int
+scheduler_pct__cmp_change_points (const void *a, const void *b)
+{
+  long unsigned x = *(const long unsigned *) a, y = *(const long unsigned *) b;
+  return (x > y) - (x < y);
+}
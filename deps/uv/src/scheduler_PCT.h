@@ -0,0 +1,59 @@
+#ifndef UV_SRC_SCHEDULER_PCT_H_
+#define UV_SRC_SCHEDULER_PCT_H_
+
+#include "scheduler.h"
+#include "logical-callback-node.h"
+
+/* PCT: Probabilistic Concurrency Testing (Burckhardt et al., ASPLOS 2010).
+ *
+ * Every logical event source (a TP work item, an fd, a timer) gets a random
+ * priority the first time we see it. A work item's done event keeps the work
+ * item's priority. Wherever the scheduler has a choice, the
+ * highest-priority candidate goes first. At depth-1 randomly chosen CB counts,
+ * the source that most recently went first is demoted below every other source.
+ *
+ * For a bug that needs d ordering constraints to manifest in a run of n sources
+ * and k CBs, one run finds it with probability at least 1/(n * k^(d-1)).
+ * Coin flips at each decision give no such guarantee.
+ */
+struct scheduler_pct_args_s
+{
+  /* The bug depth we're hunting. There are depth-1 priority change points. */
+  int depth;
+  /* Estimate of the number of CBs in a run. Change points are drawn from [1, max_cbs]. */
+  int max_cbs;
+
+  /* As for TP_FREEDOM: how many TP threads to simulate (-1 for "the whole queue"),
+   * and how long the TP may wait for its queue to fill so it has something to choose from. */
+  int tp_degrees_of_freedom;
+  useconds_t tp_max_delay_us;
+
+  /* As for TP_FREEDOM: the "shuffle distance" of epoll events (-1 for "no limit") and of ready timers (1 for "don't reorder"). */
+  int iopoll_degrees_of_freedom;
+  int timer_degrees_of_freedom;
+};
+typedef struct scheduler_pct_args_s scheduler_pct_args_t;
+
+/* Env var UV_THREADPOOL_SIZE must be 1. */
+void
+scheduler_pct_init (scheduler_mode_t mode, void *args, schedulerImpl_t *schedulerImpl);
+
+void
+scheduler_pct_register_lcbn (lcbn_t *lcbn);
+
+enum callback_type
+scheduler_pct_next_lcbn_type (void);
+
+void
+scheduler_pct_thread_yield (schedule_point_t point, void *schedule_point_details);
+
+void
+scheduler_pct_emit (char *output_file);
+
+int
+scheduler_pct_lcbns_remaining (void);
+
+int
+scheduler_pct_schedule_has_diverged (void);
+
+#endif  /* UV_SRC_SCHEDULER_PCT_H_ */
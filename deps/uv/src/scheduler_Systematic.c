@@ -0,0 +1,732 @@
+#include "scheduler_Systematic.h"
+
+#include "scheduler.h"
+#include "timespec_funcs.h"
+#include "uv-common.h" /* Allocators */
+
+#include <unistd.h> /* getpid, unlink */
+#include <signal.h> /* kill */
+#include <errno.h>
+#include <stdio.h>  /* FILE */
+#include <string.h> /* memcpy, memmove */
+#include <stdlib.h> /* getenv, atexit */
+#include <assert.h>
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+static int SCHEDULER_SYSTEMATIC_MAGIC = 18273645;
+
+/* The decision streams. */
+enum systematic_stream_e
+{
+  SYSTEMATIC_STREAM_LOOPER,
+  SYSTEMATIC_STREAM_TP,
+  SYSTEMATIC_STREAM_MAX
+};
+
+static const char *systematic_stream_names[SYSTEMATIC_STREAM_MAX] = { "looper", "tp" };
+
+/* The decision vector of one thread. */
+struct systematic_stream_s
+{
+  /* The choices to follow, from the frontier file. */
+  int *prefix;
+  int prefix_len;
+
+  /* The choices made so far, and how many candidates each decision had. */
+  int *choices;
+  int *n_candidates;
+  int len;
+
+  /* In a fork-server child, the decisions made before the fork. All children share them. */
+  int len_at_fork;
+};
+typedef struct systematic_stream_s systematic_stream_t;
+
+/* implDetails for the systematic scheduler. */
+
+static struct
+{
+  int magic;
+
+  int mode;
+  scheduler_systematic_args_t args;
+
+  /* Accessed by looper and TP. Protected by mutex. */
+  uv_mutex_t mutex;
+  systematic_stream_t streams[SYSTEMATIC_STREAM_MAX];
+  long unsigned runs; /* How many runs have finished before this one. */
+  int done;           /* The frontier file says the search is over. */
+  int diverged;       /* This run could not follow its prefix. */
+  pid_t load_pid;     /* The process that loaded the frontier file. */
+
+  /* The decisions of this run so far, in case it dies before at_exit. See scheduler_systematic__journal. */
+  char journal_file[sizeof ((scheduler_systematic_args_t *) 0)->frontier_file + 8];
+  FILE *journal;
+  pid_t journal_pid;  /* The process that opened journal. A fork-server child opens its own. */
+} systematic_implDetails;
+
+/***********************
+ * Private API declarations
+ ***********************/
+
+/* Returns non-zero if the scheduler_systematic looks valid (e.g. is initialized properly). */
+static int scheduler_systematic__looks_valid (void);
+
+static void scheduler_systematic__lock (void);
+static void scheduler_systematic__unlock (void);
+
+/* Returns the choice to make among N candidates, and records it in stream STREAM. */
+static int scheduler_systematic__decide (enum systematic_stream_e stream, int n);
+
+/* Load the frontier file, if there is one.
+ * If the last run to load it died before at_exit, account for that run first.
+ * Caller must hold the lock. */
+static void scheduler_systematic__load_frontier (void);
+/* Parse the frontier file into the prefixes. Caller must hold the lock. */
+static void scheduler_systematic__read_frontier (void);
+
+/* Record the latest decision of STREAM in the journal. Caller must hold the lock. */
+static void scheduler_systematic__journal (enum systematic_stream_e stream);
+/* If a dead process left a journal, load its decisions into STREAMS and return 1. Caller must hold the lock. */
+static int scheduler_systematic__read_journal (systematic_stream_t *streams);
+/* Close and remove our journal, if we have one. Caller must hold the lock. */
+static void scheduler_systematic__close_journal (void);
+
+/* If we are a fork-server child, pick up the frontier the previous child left us.
+ * Caller must hold the lock. */
+static void scheduler_systematic__check_fork (void);
+
+/* Turn the decisions in STREAMS into the next unexplored vector.
+ * Returns 0 if there is none. Caller must hold the lock. */
+static int scheduler_systematic__advance (systematic_stream_t *streams);
+
+/* Write STREAMS to the frontier file. Caller must hold the lock. */
+static void scheduler_systematic__write_frontier (systematic_stream_t *streams, int exhausted);
+
+/* atexit handler. */
+static void scheduler_systematic__at_exit (void);
+
+/***********************
+ * Public API definitions
+ ***********************/
+
+void
+scheduler_systematic_init (scheduler_mode_t mode, void *args, schedulerImpl_t *schedulerImpl)
+{
+  const char *tpSize = NULL;
+  int i;
+
+  assert(args != NULL);
+  assert(schedulerImpl != NULL);
+
+  /* Like TP_FREEDOM, we simulate a multi-thread TP using a single TP thread. */
+  tpSize = getenv("UV_THREADPOOL_SIZE");
+  assert(tpSize != NULL && atoi(tpSize) == 1);
+
+  /* Populate schedulerImpl. */
+  schedulerImpl->register_lcbn = scheduler_systematic_register_lcbn;
+  schedulerImpl->next_lcbn_type = scheduler_systematic_next_lcbn_type;
+  schedulerImpl->thread_yield = scheduler_systematic_thread_yield;
+  schedulerImpl->emit = scheduler_systematic_emit;
+  schedulerImpl->lcbns_remaining = scheduler_systematic_lcbns_remaining;
+  schedulerImpl->schedule_has_diverged = scheduler_systematic_schedule_has_diverged;
+
+  /* Set implDetails. */
+  memset(&systematic_implDetails, 0, sizeof systematic_implDetails);
+  systematic_implDetails.magic = SCHEDULER_SYSTEMATIC_MAGIC;
+  systematic_implDetails.mode = mode;
+  systematic_implDetails.args = *(scheduler_systematic_args_t *) args;
+
+  assert(systematic_implDetails.args.frontier_file[0] != '\0');
+  assert(1 <= systematic_implDetails.args.max_decisions);
+  assert(0 <= systematic_implDetails.args.iopoll_window);
+  assert(systematic_implDetails.args.tp_degrees_of_freedom == -1 || 1 <= systematic_implDetails.args.tp_degrees_of_freedom);
+
+  assert(uv_mutex_init(&systematic_implDetails.mutex) == 0);
+
+  snprintf(systematic_implDetails.journal_file, sizeof systematic_implDetails.journal_file, "%s.journal", systematic_implDetails.args.frontier_file);
+
+  for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+  {
+    systematic_stream_t *s = &systematic_implDetails.streams[i];
+    s->prefix = (int *) uv__calloc(systematic_implDetails.args.max_decisions, sizeof(int));
+    s->choices = (int *) uv__calloc(systematic_implDetails.args.max_decisions, sizeof(int));
+    s->n_candidates = (int *) uv__calloc(systematic_implDetails.args.max_decisions, sizeof(int));
+    assert(s->prefix != NULL && s->choices != NULL && s->n_candidates != NULL);
+  }
+
+  scheduler_systematic__load_frontier();
+  assert(atexit(scheduler_systematic__at_exit) == 0);
+
+  return;
+}
+
+void
+scheduler_systematic_register_lcbn (lcbn_t *lcbn)
+{
+  assert(scheduler_systematic__looks_valid());
+  assert(lcbn != NULL && lcbn_looks_valid(lcbn));
+
+  return;
+}
+
+enum callback_type
+scheduler_systematic_next_lcbn_type (void)
+{
+  assert(scheduler_systematic__looks_valid());
+  return CALLBACK_TYPE_ANY;
+}
+
+void
+scheduler_systematic_thread_yield (schedule_point_t point, void *pointDetails)
+{
+  unsigned i;
+
+  assert(scheduler_systematic__looks_valid());
+  /* Ensure {point, pointDetails} are consistent. Afterwards we know the inputs are correct. */
+  assert(schedule_point_looks_valid(point, pointDetails));
+
+  switch (point)
+  {
+    case SCHEDULE_POINT_TP_WANTS_WORK:
+    {
+      /* Give the queue a chance to fill, so that there is a choice to make. */
+      spd_wants_work_t *spd_wants_work = (spd_wants_work_t *) pointDetails;
+      int deg_freedom = systematic_implDetails.args.tp_degrees_of_freedom;
+      int queue_len = 0;
+      QUEUE *q = NULL;
+      struct timespec now, wait_diff;
+      long wait_diff_us = 0;
+
+      QUEUE_LEN(queue_len, q, spd_wants_work->wq);
+
+      assert(clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0);
+      if (timespec_cmp(&now, &spd_wants_work->start_time) == 1)
+      {
+        timespec_sub(&now, &spd_wants_work->start_time, &wait_diff);
+        wait_diff_us = timespec_us(&wait_diff);
+      }
+
+      if (0 < deg_freedom && deg_freedom <= queue_len)
+        spd_wants_work->should_get_work = 1;
+      else if (systematic_implDetails.args.tp_max_delay_us <= (useconds_t) wait_diff_us)
+        spd_wants_work->should_get_work = 1;
+      else
+        spd_wants_work->should_get_work = 0;
+      break;
+    }
+    case SCHEDULE_POINT_TP_GETTING_WORK:
+    {
+      spd_getting_work_t *spd_getting_work = (spd_getting_work_t *) pointDetails;
+      int queue_len = 0;
+      QUEUE *q = NULL;
+
+      QUEUE_LEN(queue_len, q, spd_getting_work->wq);
+      if (systematic_implDetails.args.tp_degrees_of_freedom != -1)
+        queue_len = MIN(queue_len, systematic_implDetails.args.tp_degrees_of_freedom);
+      spd_getting_work->index = scheduler_systematic__decide(SYSTEMATIC_STREAM_TP, queue_len);
+      break;
+    }
+    case SCHEDULE_POINT_LOOPER_GETTING_DONE:
+    {
+      spd_getting_done_t *spd_getting_done = (spd_getting_done_t *) pointDetails;
+      int queue_len = 0;
+      QUEUE *q = NULL;
+
+      QUEUE_LEN(queue_len, q, spd_getting_done->wq);
+      if (systematic_implDetails.args.tp_degrees_of_freedom != -1)
+        queue_len = MIN(queue_len, systematic_implDetails.args.tp_degrees_of_freedom);
+      spd_getting_done->index = scheduler_systematic__decide(SYSTEMATIC_STREAM_LOOPER, queue_len);
+      break;
+    }
+    case SCHEDULE_POINT_LOOPER_IOPOLL_BEFORE_HANDLING_EVENTS:
+    {
+      shuffleable_items_t *shuffleable_items = &((spd_iopoll_before_handling_events_t *) pointDetails)->shuffleable_items;
+      char *items = (char *) shuffleable_items->items;
+      size_t item_size = shuffleable_items->item_size;
+      void *tmp = NULL;
+      int choice;
+
+      /* Position i gets one of the events in [i, i + iopoll_window]. The rest keep their order. */
+      if (0 < systematic_implDetails.args.iopoll_window && 1 < shuffleable_items->nitems)
+      {
+        tmp = uv__malloc(item_size);
+        assert(tmp != NULL);
+        for (i = 0; i + 1 < shuffleable_items->nitems; i++)
+        {
+          choice = scheduler_systematic__decide(SYSTEMATIC_STREAM_LOOPER, MIN(systematic_implDetails.args.iopoll_window + 1, (int) (shuffleable_items->nitems - i)));
+          if (choice == 0)
+            continue;
+          memcpy(tmp, items + (i + choice)*item_size, item_size);
+          memmove(items + (i + 1)*item_size, items + i*item_size, choice*item_size);
+          memcpy(items + i*item_size, tmp, item_size);
+        }
+        uv__free(tmp);
+      }
+
+      /* We reorder; we never defer. */
+      for (i = 0; i < shuffleable_items->nitems; i++)
+        shuffleable_items->thoughts[i] = 1;
+      break;
+    }
+    case SCHEDULE_POINT_LOOPER_RUN_CLOSING:
+    {
+      spd_looper_run_closing_t *spd_looper_run_closing = (spd_looper_run_closing_t *) pointDetails;
+      if (systematic_implDetails.args.closing_defers)
+        spd_looper_run_closing->defer = scheduler_systematic__decide(SYSTEMATIC_STREAM_LOOPER, 2);
+      else
+        spd_looper_run_closing->defer = 0;
+      break;
+    }
+    case SCHEDULE_POINT_LOOPER_RUN_INLINE:
+    {
+      /* Explore inline first, then the TP. */
+      spd_looper_run_inline_t *spd_looper_run_inline = (spd_looper_run_inline_t *) pointDetails;
+      spd_looper_run_inline->run_inline = !scheduler_systematic__decide(SYSTEMATIC_STREAM_LOOPER, 2);
+      break;
+    }
+    case SCHEDULE_POINT_TIMER_READY:
+    {
+      spd_timer_ready_t *spd_timer_ready = (spd_timer_ready_t *) pointDetails;
+      spd_timer_ready->ready = (spd_timer_ready->timer->timeout < spd_timer_ready->now);
+      break;
+    }
+    case SCHEDULE_POINT_TIMER_RUN:
+    {
+      spd_timer_run_t *spd_timer_run = (spd_timer_run_t *) pointDetails;
+      for (i = 0; i < spd_timer_run->shuffleable_items.nitems; i++)
+        spd_timer_run->shuffleable_items.thoughts[i] = 1;
+      break;
+    }
+    case SCHEDULE_POINT_TIMER_NEXT_TIMEOUT:
+    {
+      spd_timer_next_timeout_t *spd_timer_next_timeout = (spd_timer_next_timeout_t *) pointDetails;
+      if (spd_timer_next_timeout->timer->timeout < spd_timer_next_timeout->now)
+        spd_timer_next_timeout->time_until_timer = 0;
+      else
+        spd_timer_next_timeout->time_until_timer = spd_timer_next_timeout->timer->timeout - spd_timer_next_timeout->now;
+      break;
+    }
+    default:
+      /* Nothing to do. */
+      break;
+  }
+
+  return;
+}
+
+void
+scheduler_systematic_emit (char *output_file)
+{
+  assert(scheduler_systematic__looks_valid());
+  unlink(output_file);
+  return;
+}
+
+int
+scheduler_systematic_lcbns_remaining (void)
+{
+  assert(scheduler_systematic__looks_valid());
+  return -1;
+}
+
+int
+scheduler_systematic_schedule_has_diverged (void)
+{
+  int diverged;
+
+  assert(scheduler_systematic__looks_valid());
+
+  scheduler_systematic__lock();
+  diverged = systematic_implDetails.diverged;
+  scheduler_systematic__unlock();
+
+  return diverged;
+}
+
+/***********************
+ * Private API definitions.
+ ***********************/
+
+static int
+scheduler_systematic__looks_valid (void)
+{
+  return (systematic_implDetails.magic == SCHEDULER_SYSTEMATIC_MAGIC);
+}
+
+static void
+scheduler_systematic__lock (void)
+{
+  uv_mutex_lock(&systematic_implDetails.mutex);
+}
+
+static void
+scheduler_systematic__unlock (void)
+{
+  uv_mutex_unlock(&systematic_implDetails.mutex);
+}
+
+static int
+scheduler_systematic__decide (enum systematic_stream_e stream, int n)
+{
+  systematic_stream_t *s = &systematic_implDetails.streams[stream];
+  int choice = 0;
+
+  /* A single candidate is not a decision. */
+  if (n <= 1)
+    return 0;
+
+  scheduler_systematic__lock();
+  scheduler_systematic__check_fork();
+
+  /* Past the bound, take the defaults. */
+  if (systematic_implDetails.args.max_decisions <= s->len)
+  {
+    scheduler_systematic__unlock();
+    return 0;
+  }
+
+  if (s->len < s->prefix_len)
+    choice = s->prefix[s->len];
+  if (n <= choice)
+  {
+    /* The program did not repeat itself: this decision has fewer candidates than last time. */
+    mylog(LOG_SCHEDULER, 1, "scheduler_systematic__decide: %s decision %i: prefix says %i but there are only %i candidates\n", systematic_stream_names[stream], s->len, choice, n);
+    systematic_implDetails.diverged = 1;
+    choice = 0;
+  }
+
+  s->choices[s->len] = choice;
+  s->n_candidates[s->len] = n;
+  s->len++;
+  scheduler_systematic__journal(stream);
+  scheduler_systematic__unlock();
+
+  mylog(LOG_SCHEDULER, 5, "scheduler_systematic__decide: %s decision %i: chose %i of %i\n", systematic_stream_names[stream], s->len - 1, choice, n);
+  return choice;
+}
+
+static void
+scheduler_systematic__load_frontier (void)
+{
+  systematic_stream_t crashed[SYSTEMATIC_STREAM_MAX];
+  int i, exhausted;
+
+  systematic_implDetails.load_pid = getpid();
+  scheduler_systematic__read_frontier();
+
+  /* A run that dies leaves its journal behind. It still counts: move the frontier past it,
+   * or the next run would replay it forever. */
+  for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+  {
+    memset(&crashed[i], 0, sizeof crashed[i]);
+    crashed[i].choices = (int *) uv__calloc(systematic_implDetails.args.max_decisions, sizeof(int));
+    crashed[i].n_candidates = (int *) uv__calloc(systematic_implDetails.args.max_decisions, sizeof(int));
+    assert(crashed[i].choices != NULL && crashed[i].n_candidates != NULL);
+  }
+
+  if (scheduler_systematic__read_journal(crashed))
+  {
+    if (!systematic_implDetails.done)
+    {
+      mylog(LOG_SCHEDULER, 1, "scheduler_systematic__load_frontier: run %lu died after %i looper and %i tp decisions, skipping past it\n",
+        systematic_implDetails.runs, crashed[SYSTEMATIC_STREAM_LOOPER].len, crashed[SYSTEMATIC_STREAM_TP].len);
+      exhausted = !scheduler_systematic__advance(crashed);
+      scheduler_systematic__write_frontier(crashed, exhausted);
+    }
+    unlink(systematic_implDetails.journal_file);
+    scheduler_systematic__read_frontier();
+  }
+
+  for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+  {
+    uv__free(crashed[i].choices);
+    uv__free(crashed[i].n_candidates);
+  }
+}
+
+static void
+scheduler_systematic__read_frontier (void)
+{
+  FILE *fp = NULL;
+  char word[64];
+  int i, j, n, stream, choice;
+
+  systematic_implDetails.runs = 0;
+  systematic_implDetails.done = 0;
+  for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+    systematic_implDetails.streams[i].prefix_len = 0;
+
+  /* No file means we're starting a new search. */
+  fp = fopen(systematic_implDetails.args.frontier_file, "r");
+  if (fp == NULL)
+  {
+    mylog(LOG_SCHEDULER, 1, "scheduler_systematic__read_frontier: no frontier file %s, starting a new search\n", systematic_implDetails.args.frontier_file);
+    return;
+  }
+
+  while (fscanf(fp, "%63s", word) == 1)
+  {
+    if (word[0] == '#')
+    {
+      if (fscanf(fp, "%*[^\n]") == EOF)
+        break;
+    }
+    else if (strcmp(word, "runs") == 0)
+      assert(fscanf(fp, "%lu", &systematic_implDetails.runs) == 1);
+    else if (strcmp(word, "done") == 0)
+      systematic_implDetails.done = 1;
+    else
+    {
+      for (stream = 0; stream < SYSTEMATIC_STREAM_MAX; stream++)
+        if (strcmp(word, systematic_stream_names[stream]) == 0)
+          break;
+      if (stream == SYSTEMATIC_STREAM_MAX)
+        assert(!"scheduler_systematic__read_frontier: unrecognized line in the frontier file");
+
+      assert(fscanf(fp, "%i", &n) == 1 && 0 <= n);
+      for (j = 0; j < n; j++)
+      {
+        assert(fscanf(fp, "%i", &choice) == 1 && 0 <= choice);
+        /* A run with a smaller bound explores a prefix of the same tree. */
+        if (j < systematic_implDetails.args.max_decisions)
+          systematic_implDetails.streams[stream].prefix[j] = choice;
+      }
+      systematic_implDetails.streams[stream].prefix_len = MIN(n, systematic_implDetails.args.max_decisions);
+    }
+  }
+  fclose(fp);
+
+  mylog(LOG_SCHEDULER, 1, "scheduler_systematic__read_frontier: run %lu, looper prefix of %i decisions, tp prefix of %i decisions%s\n",
+    systematic_implDetails.runs, systematic_implDetails.streams[SYSTEMATIC_STREAM_LOOPER].prefix_len, systematic_implDetails.streams[SYSTEMATIC_STREAM_TP].prefix_len,
+    systematic_implDetails.done ? " (search is done)" : "");
+}
+
+static void
+scheduler_systematic__check_fork (void)
+{
+  systematic_stream_t *s = NULL;
+  int i, j, expected;
+
+  if (systematic_implDetails.load_pid == getpid())
+    return;
+
+  /* The decisions made before the fork are fixed for every child. Explore below them. */
+  for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+    systematic_implDetails.streams[i].len_at_fork = systematic_implDetails.streams[i].len;
+
+  scheduler_systematic__load_frontier();
+
+  for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+  {
+    s = &systematic_implDetails.streams[i];
+    for (j = 0; j < s->len_at_fork; j++)
+    {
+      expected = (j < s->prefix_len) ? s->prefix[j] : 0;
+      if (s->choices[j] != expected)
+      {
+        mylog(LOG_SCHEDULER, 1, "scheduler_systematic__check_fork: %s decision %i was made before the fork and cannot follow the frontier\n", systematic_stream_names[i], j);
+        systematic_implDetails.diverged = 1;
+      }
+    }
+  }
+}
+
+static int
+scheduler_systematic__advance (systematic_stream_t *streams)
+{
+  systematic_stream_t *s = NULL;
+  int i, j, later;
+
+  /* Depth-first over the vector looper ++ tp: bump the deepest decision with an untried candidate. */
+  for (i = SYSTEMATIC_STREAM_MAX - 1; 0 <= i; i--)
+  {
+    s = &streams[i];
+    for (j = s->len - 1; s->len_at_fork <= j; j--)
+    {
+      if (s->choices[j] + 1 < s->n_candidates[j])
+      {
+        s->choices[j]++;
+        s->len = j + 1;
+        for (later = i + 1; later < SYSTEMATIC_STREAM_MAX; later++)
+          streams[later].len = streams[later].len_at_fork;
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static void
+scheduler_systematic__write_frontier (systematic_stream_t *streams, int exhausted)
+{
+  char tmp_file[sizeof systematic_implDetails.args.frontier_file + 8];
+  systematic_stream_t *s = NULL;
+  FILE *fp = NULL;
+  int i, j;
+
+  /* Write a new file and rename it, so a reader never sees half a frontier. */
+  snprintf(tmp_file, sizeof tmp_file, "%s.tmp", systematic_implDetails.args.frontier_file);
+  fp = fopen(tmp_file, "w");
+  if (fp == NULL)
+  {
+    mylog(LOG_SCHEDULER, 1, "scheduler_systematic__write_frontier: could not open %s\n", tmp_file);
+    return;
+  }
+
+  fprintf(fp, "# Systematic scheduler frontier. Lines are \"<thread> <n> <choice>...\".\n");
+  fprintf(fp, "runs %lu\n", systematic_implDetails.runs + 1);
+  if (exhausted)
+    fprintf(fp, "done\n");
+  else
+  {
+    for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+    {
+      s = &streams[i];
+      fprintf(fp, "%s %i", systematic_stream_names[i], s->len);
+      for (j = 0; j < s->len; j++)
+        fprintf(fp, " %i", s->choices[j]);
+      fprintf(fp, "\n");
+    }
+  }
+
+  if (fclose(fp) != 0 || rename(tmp_file, systematic_implDetails.args.frontier_file) != 0)
+    mylog(LOG_SCHEDULER, 1, "scheduler_systematic__write_frontier: could not write %s\n", systematic_implDetails.args.frontier_file);
+}
+
+static void
+scheduler_systematic__at_exit (void)
+{
+  int exhausted;
+
+  if (!scheduler_systematic__looks_valid())
+    return;
+
+  scheduler_systematic__lock();
+  scheduler_systematic__check_fork();
+
+  /* Leave a finished search alone; remove the file to start over. */
+  if (systematic_implDetails.done)
+  {
+    mylog(LOG_SCHEDULER, 1, "scheduler_systematic__at_exit: the search was already done\n");
+    scheduler_systematic__close_journal();
+    scheduler_systematic__unlock();
+    return;
+  }
+
+  mylog(LOG_SCHEDULER, 1, "scheduler_systematic__at_exit: run %lu made %i looper and %i tp decisions%s\n",
+    systematic_implDetails.runs, systematic_implDetails.streams[SYSTEMATIC_STREAM_LOOPER].len, systematic_implDetails.streams[SYSTEMATIC_STREAM_TP].len,
+    systematic_implDetails.diverged ? " (diverged from its prefix)" : "");
+
+  exhausted = !scheduler_systematic__advance(systematic_implDetails.streams);
+  if (exhausted)
+    mylog(LOG_SCHEDULER, 1, "scheduler_systematic__at_exit: search is done after %lu runs\n", systematic_implDetails.runs + 1);
+  scheduler_systematic__write_frontier(systematic_implDetails.streams, exhausted);
+  /* Only now is the run accounted for. */
+  scheduler_systematic__close_journal();
+
+  scheduler_systematic__unlock();
+}
+
+/* The journal is "<frontier_file>.journal":
+ *   pid <pid>
+ *   at_fork <looper len_at_fork> <tp len_at_fork>
+ *   <thread> <choice> <n>     one line per decision, in the order each thread made them
+ * Each line is flushed as it is made, so it survives the process dying. A run makes at most
+ * max_decisions per thread, so this is cheap. at_exit removes it.
+ */
+static void
+scheduler_systematic__journal (enum systematic_stream_e stream)
+{
+  systematic_stream_t *s = NULL;
+  int i, j;
+
+  if (systematic_implDetails.journal == NULL || systematic_implDetails.journal_pid != getpid())
+  {
+    /* A fork-server child starts over with its own copy of the decisions made before the fork. */
+    if (systematic_implDetails.journal != NULL)
+      fclose(systematic_implDetails.journal);
+    systematic_implDetails.journal = fopen(systematic_implDetails.journal_file, "w");
+    systematic_implDetails.journal_pid = getpid();
+    if (systematic_implDetails.journal == NULL)
+    {
+      mylog(LOG_SCHEDULER, 1, "scheduler_systematic__journal: could not open %s\n", systematic_implDetails.journal_file);
+      return;
+    }
+
+    fprintf(systematic_implDetails.journal, "pid %i\n", (int) getpid());
+    fprintf(systematic_implDetails.journal, "at_fork %i %i\n",
+      systematic_implDetails.streams[SYSTEMATIC_STREAM_LOOPER].len_at_fork, systematic_implDetails.streams[SYSTEMATIC_STREAM_TP].len_at_fork);
+    for (i = 0; i < SYSTEMATIC_STREAM_MAX; i++)
+    {
+      s = &systematic_implDetails.streams[i];
+      for (j = 0; j < s->len; j++)
+        fprintf(systematic_implDetails.journal, "%s %i %i\n", systematic_stream_names[i], s->choices[j], s->n_candidates[j]);
+    }
+  }
+  else
+  {
+    s = &systematic_implDetails.streams[stream];
+    fprintf(systematic_implDetails.journal, "%s %i %i\n", systematic_stream_names[stream], s->choices[s->len - 1], s->n_candidates[s->len - 1]);
+  }
+
+  fflush(systematic_implDetails.journal);
+}
+
+static int
+scheduler_systematic__read_journal (systematic_stream_t *streams)
+{
+  FILE *fp = NULL;
+  char word[64];
+  int pid = 0, choice, n, stream;
+
+  fp = fopen(systematic_implDetails.journal_file, "r");
+  if (fp == NULL)
+    return 0;
+
+  /* Whoever wrote it may still be running, e.g. the fork server whose child we are. */
+  if (fscanf(fp, "pid %i", &pid) != 1 || pid == (int) getpid() || kill((pid_t) pid, 0) == 0 || errno != ESRCH)
+  {
+    fclose(fp);
+    return 0;
+  }
+
+  while (fscanf(fp, "%63s", word) == 1)
+  {
+    if (strcmp(word, "at_fork") == 0)
+    {
+      assert(fscanf(fp, "%i %i", &streams[SYSTEMATIC_STREAM_LOOPER].len_at_fork, &streams[SYSTEMATIC_STREAM_TP].len_at_fork) == 2);
+      continue;
+    }
+
+    for (stream = 0; stream < SYSTEMATIC_STREAM_MAX; stream++)
+      if (strcmp(word, systematic_stream_names[stream]) == 0)
+        break;
+    /* The last line may be cut short. */
+    if (stream == SYSTEMATIC_STREAM_MAX || fscanf(fp, "%i %i", &choice, &n) != 2)
+      break;
+
+    if (streams[stream].len < systematic_implDetails.args.max_decisions)
+    {
+      streams[stream].choices[streams[stream].len] = choice;
+      streams[stream].n_candidates[streams[stream].len] = n;
+      streams[stream].len++;
+    }
+  }
+  fclose(fp);
+
+  return 1;
+}
+
+static void
+scheduler_systematic__close_journal (void)
+{
+  if (systematic_implDetails.journal == NULL || systematic_implDetails.journal_pid != getpid())
+    return;
+
+  fclose(systematic_implDetails.journal);
+  systematic_implDetails.journal = NULL;
+  unlink(systematic_implDetails.journal_file);
+}
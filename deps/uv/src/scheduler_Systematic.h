@@ -0,0 +1,71 @@
+#ifndef UV_SRC_SCHEDULER_SYSTEMATIC_H_
+#define UV_SRC_SCHEDULER_SYSTEMATIC_H_
+
+#include "scheduler.h"
+#include "logical-callback-node.h"
+
+/* Systematic, bounded exploration.
+ *
+ * A run is described by its decision vector: the candidate chosen at each schedule
+ * point that had more than one candidate. Points with a single candidate are not decisions.
+ * We enumerate decision vectors depth-first, one per run:
+ *   - A run follows the vector in the frontier file, then takes the default (candidate 0)
+ *     at every later decision.
+ *   - At exit, it writes the next vector to the frontier file: its own trace with
+ *     the deepest decision that has an untried candidate bumped, and everything after
+ *     it dropped. When there is no such decision, it writes "done".
+ * Runs of the same program therefore explore distinct schedules until the tree is exhausted.
+ * Run them one at a time (or as fork-server children, which the server runs one at a time).
+ *
+ * The looper and the TP thread keep separate decision vectors, so that their interleaving
+ * does not shift one thread's decisions into the other's positions.
+ *
+ * Decisions:
+ *   - TP: which of the first tp_degrees_of_freedom queued work items to take.
+ *   - Looper: the order of epoll events. Each event in turn may be swapped with one of the
+ *     next iopoll_window events.
+ *   - Looper: whether to defer the remaining closing handles to the next turn of the loop.
+ *   - Looper: which done item to take (SCHEDULE_POINT_LOOPER_GETTING_DONE).
+ * Each thread makes at most max_decisions decisions per run; after that it takes the defaults.
+ */
+struct scheduler_systematic_args_s
+{
+  /* Where the next decision vector is kept between runs. */
+  char frontier_file[1024];
+  /* Bound on the depth of the search, per thread. */
+  int max_decisions;
+  /* How far ahead an epoll event may be pulled forward. 0 means "don't reorder epoll events". */
+  int iopoll_window;
+  /* Whether deferring closing handles is a decision. */
+  int closing_defers;
+
+  /* As for TP_FREEDOM: how many TP threads to simulate (-1 for "the whole queue"),
+   * and how long the TP may wait for its queue to fill so it has something to choose from. */
+  int tp_degrees_of_freedom;
+  useconds_t tp_max_delay_us;
+};
+typedef struct scheduler_systematic_args_s scheduler_systematic_args_t;
+
+/* Env var UV_THREADPOOL_SIZE must be 1. */
+void
+scheduler_systematic_init (scheduler_mode_t mode, void *args, schedulerImpl_t *schedulerImpl);
+
+void
+scheduler_systematic_register_lcbn (lcbn_t *lcbn);
+
+enum callback_type
+scheduler_systematic_next_lcbn_type (void);
+
+void
+scheduler_systematic_thread_yield (schedule_point_t point, void *schedule_point_details);
+
+void
+scheduler_systematic_emit (char *output_file);
+
+int
+scheduler_systematic_lcbns_remaining (void);
+
+int
+scheduler_systematic_schedule_has_diverged (void);
+
+#endif  /* UV_SRC_SCHEDULER_SYSTEMATIC_H_ */
@@ -4,6 +4,7 @@
 #include "scheduler.h"
 #include "timespec_funcs.h"
 #include "uv-random.h"
+#include "statistics.h"
 
 #include <unistd.h> /* usleep, unlink */
 #include <string.h> /* memcpy */
@@ -15,6 +16,10 @@
 
 static int SCHEDULER_TP_FREEDOM_MAGIC = 81929393;
 
+/* Adaptive mode: how often we re-tune, and how low the TP delay may go. */
+#define SCHEDULER_TP_FREEDOM_ADAPTIVE_EPOCH_US 100000
+#define SCHEDULER_TP_FREEDOM_ADAPTIVE_MIN_DELAY_US 10
+
 /* implDetails for the fuzzing timer scheduler. */
 
 static struct
@@ -26,9 +31,15 @@ static struct
 
   uv_mutex_t mutex;
 
-  /* Accessed by looper and TP. Protected by mutex. */
-  int looper_in_epoll; /* Non-zero if looper thread is between SCHEDULE_POINT_LOOPER_BEFORE_EPOLL and AFTER_EPOLL. */
-  struct timespec looper_epoll_start_time; /* If looper_in_epoll, this is when looper reached SCHEDULE_POINT_LOOPER_BEFORE_EPOLL. */
+  /* Adaptive mode. args holds the current knobs, ceiling the configured ones.
+   * tp_max_delay_us is written by a looper and read by the TP: protected by mutex. 
+   * The looper knobs are only written by the looper holding adapt_mutex. */
+  scheduler_tp_freedom_args_t ceiling;
+  uv_mutex_t adapt_mutex; /* With several loops, one looper at a time adapts. */
+  struct timespec epoch_start; /* Protected by adapt_mutex. */
+  long epoch_waited_us; /* Time the TP spent waiting for its queue to fill this epoch. Protected by mutex. */
+  unsigned long int tp_work_total, tp_work_n; /* STATISTIC_TP_SIMULTANEOUS_WORK at epoch_start. */
+  unsigned long int epoll_events_total, epoll_events_n; /* STATISTIC_EPOLL_SIMULTANEOUS_EVENTS at epoch_start. */
 
 } tpFreedom_implDetails;
 
@@ -51,6 +62,10 @@ static void scheduler_tp_freedom__shuffle_items (int degrees_of_freedom, void *e
 static void scheduler_tP_freedom__lock (void);
 static void scheduler_tP_freedom__unlock (void);
 
+/* Adaptive mode: once per epoch, re-tune the knobs. Looper only, holding adapt_mutex. */
+static void scheduler_tp_freedom__adapt (void);
+static int scheduler_tp_freedom__knob_up (int knob, int ceiling);
+
 /***********************
  * Public API definitions
  ***********************/
@@ -84,8 +99,12 @@ scheduler_tp_freedom_init (scheduler_mode_t mode, void *args, schedulerImpl_t *s
   assert(tpFreedom_implDetails.args.tp_degrees_of_freedom == -1 || 1 <= tpFreedom_implDetails.args.tp_degrees_of_freedom);
   assert(0 <= tpFreedom_implDetails.args.iopoll_defer_perc && tpFreedom_implDetails.args.iopoll_defer_perc <= 100);
 
-  tpFreedom_implDetails.looper_in_epoll = 0;
   assert(uv_mutex_init(&tpFreedom_implDetails.mutex) == 0);
+  assert(uv_mutex_init(&tpFreedom_implDetails.adapt_mutex) == 0);
+
+  assert(0 <= tpFreedom_implDetails.args.adaptive_overhead_perc && tpFreedom_implDetails.args.adaptive_overhead_perc <= 100);
+  tpFreedom_implDetails.ceiling = tpFreedom_implDetails.args;
+  assert(clock_gettime(CLOCK_MONOTONIC_RAW, &tpFreedom_implDetails.epoch_start) == 0);
 
   return;
 }
@@ -124,8 +143,9 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
 
     spd_wants_work_t *spd_wants_work = (spd_wants_work_t *) pointDetails;
     int queue_len = scheduler_tp_freedom__queue_len(spd_wants_work->wq);
-    struct timespec now, wait_diff, looper_epoll_diff;
+    struct timespec now, wait_diff, looper_epoll_start_time, looper_epoll_diff;
     long wait_diff_us = 0, looper_epoll_diff_us = 0;
+    useconds_t tp_max_delay_us = 0;
 
     assert(clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0);
   
@@ -138,14 +158,17 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
     else
       wait_diff_us = 0;
 
-    scheduler_tP_freedom__lock();
-    if (tpFreedom_implDetails.looper_in_epoll && timespec_cmp(&now, &tpFreedom_implDetails.looper_epoll_start_time) == 1)
+    /* With several loops, any of them could submit more work until they are all blocked. */
+    if (scheduler_loopers_in_epoll(&looper_epoll_start_time) && timespec_cmp(&now, &looper_epoll_start_time) == 1)
     {
-      timespec_sub(&now, &tpFreedom_implDetails.looper_epoll_start_time, &looper_epoll_diff);
+      timespec_sub(&now, &looper_epoll_start_time, &looper_epoll_diff);
       looper_epoll_diff_us = timespec_us(&looper_epoll_diff);
     }
     else
       looper_epoll_diff_us = 0;
+
+    scheduler_tP_freedom__lock();
+    tp_max_delay_us = tpFreedom_implDetails.args.tp_max_delay_us;
     scheduler_tP_freedom__unlock();
 
     if (0 < tpFreedom_implDetails.args.tp_degrees_of_freedom && tpFreedom_implDetails.args.tp_degrees_of_freedom <= queue_len)
@@ -153,9 +176,9 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
       mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: thread can get work (tp_degrees_of_freedom %i, queue_len %i) (%s)\n", tpFreedom_implDetails.args.tp_degrees_of_freedom, queue_len, schedule_point_to_string(point));
       spd_wants_work->should_get_work = 1;
     }
-    else if (tpFreedom_implDetails.args.tp_max_delay_us <= wait_diff_us)
+    else if (tp_max_delay_us <= wait_diff_us)
     {
-      mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: thread can get work (tp_max_delay_us %llu exceeded) (%s)\n", tpFreedom_implDetails.args.tp_max_delay_us, schedule_point_to_string(point));
+      mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: thread can get work (tp_max_delay_us %llu exceeded) (%s)\n", tp_max_delay_us, schedule_point_to_string(point));
       spd_wants_work->should_get_work = 1;
     }
     else if (tpFreedom_implDetails.args.tp_epoll_threshold < looper_epoll_diff_us)
@@ -164,7 +187,15 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
       spd_wants_work->should_get_work = 1;
     }
     else
-      mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: thread can't get work yet (tp_degrees_of_freedom %i, queue_len %i; delay %llu tp_max_delay_us %llu; looper_epoll_diff_us %li tp_epoll_threshold %li) (%s)\n", tpFreedom_implDetails.args.tp_degrees_of_freedom, queue_len, wait_diff_us, tpFreedom_implDetails.args.tp_max_delay_us, looper_epoll_diff_us, tpFreedom_implDetails.args.tp_epoll_threshold, schedule_point_to_string(point));
+      mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: thread can't get work yet (tp_degrees_of_freedom %i, queue_len %i; delay %llu tp_max_delay_us %llu; looper_epoll_diff_us %li tp_epoll_threshold %li) (%s)\n", tpFreedom_implDetails.args.tp_degrees_of_freedom, queue_len, wait_diff_us, tp_max_delay_us, looper_epoll_diff_us, tpFreedom_implDetails.args.tp_epoll_threshold, schedule_point_to_string(point));
+
+    /* Adaptive mode: charge the wait to this epoch. */
+    if (spd_wants_work->should_get_work && tpFreedom_implDetails.args.adaptive_overhead_perc)
+    {
+      scheduler_tP_freedom__lock();
+      tpFreedom_implDetails.epoch_waited_us += wait_diff_us;
+      scheduler_tP_freedom__unlock();
+    }
   }
   else if (point == SCHEDULE_POINT_TP_GETTING_WORK || point == SCHEDULE_POINT_LOOPER_GETTING_DONE)
   {
@@ -204,18 +235,12 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
   }
   else if (point == SCHEDULE_POINT_LOOPER_BEFORE_EPOLL)
   {
-    assert(!tpFreedom_implDetails.looper_in_epoll);
-    scheduler_tP_freedom__lock();
-    tpFreedom_implDetails.looper_in_epoll = 1;
-    assert(clock_gettime(CLOCK_MONOTONIC_RAW, &tpFreedom_implDetails.looper_epoll_start_time) == 0);
-    scheduler_tP_freedom__unlock();
-  }
-  else if (point == SCHEDULE_POINT_LOOPER_AFTER_EPOLL)
-  {
-    assert(tpFreedom_implDetails.looper_in_epoll);
-    scheduler_tP_freedom__lock();
-    tpFreedom_implDetails.looper_in_epoll = 0;
-    scheduler_tP_freedom__unlock();
+    /* scheduler.c tracks which loopers are in epoll. See scheduler_loopers_in_epoll. */
+    if (tpFreedom_implDetails.args.adaptive_overhead_perc && uv_mutex_trylock(&tpFreedom_implDetails.adapt_mutex) == 0)
+    {
+      scheduler_tp_freedom__adapt();
+      uv_mutex_unlock(&tpFreedom_implDetails.adapt_mutex);
+    }
   }
   else if (point == SCHEDULE_POINT_LOOPER_IOPOLL_BEFORE_HANDLING_EVENTS)
   {
@@ -246,6 +271,18 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
       }
     }
   }
+  else if (point == SCHEDULE_POINT_LOOPER_ACCEPT)
+  {
+    /* For SCHEDULE_POINT_LOOPER_ACCEPT, decide the order in which the new connections are announced.
+     * Connections that arrive together are as concurrent as epoll events, so use the same degrees of freedom. */
+    spd_looper_accept_t *spd_looper_accept = (spd_looper_accept_t *) pointDetails;
+
+    if (1 < spd_looper_accept->shuffleable_items.nitems)
+    {
+      mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: shuffling %i new connections with %i degrees of freedom\n", spd_looper_accept->shuffleable_items.nitems, tpFreedom_implDetails.args.iopoll_degrees_of_freedom);
+      scheduler_tp_freedom__shuffle_items(tpFreedom_implDetails.args.iopoll_degrees_of_freedom, spd_looper_accept->shuffleable_items.items, spd_looper_accept->shuffleable_items.nitems, spd_looper_accept->shuffleable_items.item_size);
+    }
+  }
   else if (point == SCHEDULE_POINT_LOOPER_RUN_CLOSING)
   {
     spd_looper_run_closing_t *spd_looper_run_closing = (spd_looper_run_closing_t *) pointDetails;
@@ -260,6 +297,15 @@ scheduler_tp_freedom_thread_yield (schedule_point_t point, void *pointDetails)
     assert(spd_looper_run_closing->defer == 0 || spd_looper_run_closing->defer == 1);
     mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: %s defer %i\n", schedule_point_to_string(point), spd_looper_run_closing->defer);
   }
+  else if (point == SCHEDULE_POINT_LOOPER_RUN_INLINE)
+  {
+    /* For SCHEDULE_POINT_LOOPER_RUN_INLINE, decide whether small work skips the TP.
+     * Sending some of it to the TP anyway keeps its work/done orderings in play. */
+    spd_looper_run_inline_t *spd_looper_run_inline = (spd_looper_run_inline_t *) pointDetails;
+
+    spd_looper_run_inline->run_inline = !(rand_int(100) < tpFreedom_implDetails.args.inline_defer_perc);
+    mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom_thread_yield: %s size %lu run_inline %i\n", schedule_point_to_string(point), (unsigned long) spd_looper_run_inline->size, spd_looper_run_inline->run_inline);
+  }
   else if (point == SCHEDULE_POINT_TIMER_READY)
   {
     spd_timer_ready_t *spd_timer_ready = (spd_timer_ready_t *) pointDetails;
@@ -469,3 +515,107 @@ static void scheduler_tP_freedom__unlock (void)
 {
   uv_mutex_unlock(&tpFreedom_implDetails.mutex);
 }
+
+/* Returns KNOB moved toward CEILING by a quarter of CEILING (at least 1). */
+static int scheduler_tp_freedom__knob_up (int knob, int ceiling)
+{
+  int step = ceiling/4 ? ceiling/4 : 1;
+  return MIN(knob + step, ceiling);
+}
+
+/* Spend the overhead budget where it buys choices:
+ *   - The TP delay only helps if the work queue fills while we wait. If it doesn't, waiting is pure overhead.
+ *   - Deferring epoll events is how singleton events become batches we can shuffle. If they already come
+ *     in batches, deferring more buys little.
+ *   - Everything backs off while we're over budget, and recovers toward the configured values once we're
+ *     comfortably under it.
+ * Waiting in the TP is the overhead we can measure directly; we treat it as time the program lost.
+ */
+static void scheduler_tp_freedom__adapt (void)
+{
+  scheduler_tp_freedom_args_t *args = &tpFreedom_implDetails.args;
+  scheduler_tp_freedom_args_t *ceiling = &tpFreedom_implDetails.ceiling;
+  int budget = args->adaptive_overhead_perc;
+  struct timespec now, epoch_diff;
+  long epoch_us = 0, waited_us = 0, overhead_perc = 0;
+  unsigned long int tp_work_total, tp_work_n, epoll_events_total, epoll_events_n;
+  long tp_work_avg10 = -1, epoll_events_avg10 = -1; /* Average queue length / events per epoll in tenths. -1 if no observations. */
+  int over_budget = 0, under_budget = 0;
+  useconds_t tp_max_delay_us;
+
+  assert(clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0);
+  if (timespec_cmp(&now, &tpFreedom_implDetails.epoch_start) != 1)
+    return;
+  timespec_sub(&now, &tpFreedom_implDetails.epoch_start, &epoch_diff);
+  epoch_us = timespec_us(&epoch_diff);
+  if (epoch_us < SCHEDULER_TP_FREEDOM_ADAPTIVE_EPOCH_US)
+    return;
+
+  /* What happened this epoch? */
+  statistics_get(STATISTIC_TP_SIMULTANEOUS_WORK, &tp_work_total, &tp_work_n);
+  statistics_get(STATISTIC_EPOLL_SIMULTANEOUS_EVENTS, &epoll_events_total, &epoll_events_n);
+  if (tpFreedom_implDetails.tp_work_n < tp_work_n)
+    tp_work_avg10 = 10*(tp_work_total - tpFreedom_implDetails.tp_work_total) / (tp_work_n - tpFreedom_implDetails.tp_work_n);
+  if (tpFreedom_implDetails.epoll_events_n < epoll_events_n)
+    epoll_events_avg10 = 10*(epoll_events_total - tpFreedom_implDetails.epoll_events_total) / (epoll_events_n - tpFreedom_implDetails.epoll_events_n);
+
+  scheduler_tP_freedom__lock();
+  waited_us = tpFreedom_implDetails.epoch_waited_us;
+  tpFreedom_implDetails.epoch_waited_us = 0;
+  scheduler_tP_freedom__unlock();
+
+  overhead_perc = (100*waited_us) / epoch_us;
+  over_budget = (budget < overhead_perc);
+  under_budget = (overhead_perc < budget/2);
+
+  /* TP delay. */
+  tp_max_delay_us = args->tp_max_delay_us;
+  if (0 <= tp_work_avg10 && tp_work_avg10 < 15)
+    tp_max_delay_us = tp_max_delay_us/2; /* Waiting isn't filling the queue. */
+  else if (over_budget)
+    tp_max_delay_us = tp_max_delay_us*3/4;
+  else if (under_budget)
+    tp_max_delay_us = MIN(tp_max_delay_us*5/4 + 1, ceiling->tp_max_delay_us);
+  if (tp_max_delay_us < SCHEDULER_TP_FREEDOM_ADAPTIVE_MIN_DELAY_US)
+    tp_max_delay_us = MIN(SCHEDULER_TP_FREEDOM_ADAPTIVE_MIN_DELAY_US, ceiling->tp_max_delay_us);
+
+  scheduler_tP_freedom__lock();
+  args->tp_max_delay_us = tp_max_delay_us;
+  scheduler_tP_freedom__unlock();
+
+  /* Looper knobs. */
+  if (over_budget)
+  {
+    args->iopoll_defer_perc = args->iopoll_defer_perc*3/4;
+    args->run_closing_defer_perc = args->run_closing_defer_perc*3/4;
+    args->timer_early_exec_tperc = args->timer_early_exec_tperc*3/4;
+    args->timer_late_exec_tperc = args->timer_late_exec_tperc*3/4;
+  }
+  else
+  {
+    if (0 <= epoll_events_avg10 && epoll_events_avg10 < 15)
+      args->iopoll_defer_perc = scheduler_tp_freedom__knob_up(args->iopoll_defer_perc, ceiling->iopoll_defer_perc);
+    else if (30 <= epoll_events_avg10)
+      args->iopoll_defer_perc = args->iopoll_defer_perc*3/4;
+    else if (under_budget)
+      args->iopoll_defer_perc = scheduler_tp_freedom__knob_up(args->iopoll_defer_perc, ceiling->iopoll_defer_perc);
+
+    if (under_budget)
+    {
+      args->run_closing_defer_perc = scheduler_tp_freedom__knob_up(args->run_closing_defer_perc, ceiling->run_closing_defer_perc);
+      args->timer_early_exec_tperc = scheduler_tp_freedom__knob_up(args->timer_early_exec_tperc, ceiling->timer_early_exec_tperc);
+      args->timer_late_exec_tperc = scheduler_tp_freedom__knob_up(args->timer_late_exec_tperc, ceiling->timer_late_exec_tperc);
+    }
+  }
+
+  mylog(LOG_SCHEDULER, 1, "scheduler_tp_freedom__adapt: epoch %li us, TP waited %li us (overhead %li%%, budget %i%%), avg TP queue %li.%li, avg epoll events %li.%li -> tp_max_delay_us %u iopoll_defer_perc %i run_closing_defer_perc %i timer_early_exec_tperc %i timer_late_exec_tperc %i\n",
+    epoch_us, waited_us, overhead_perc, budget, tp_work_avg10/10, tp_work_avg10 < 0 ? 0 : tp_work_avg10%10, epoll_events_avg10/10, epoll_events_avg10 < 0 ? 0 : epoll_events_avg10%10,
+    args->tp_max_delay_us, args->iopoll_defer_perc, args->run_closing_defer_perc, args->timer_early_exec_tperc, args->timer_late_exec_tperc);
+
+  /* Next epoch. */
+  tpFreedom_implDetails.epoch_start = now;
+  tpFreedom_implDetails.tp_work_total = tp_work_total;
+  tpFreedom_implDetails.tp_work_n = tp_work_n;
+  tpFreedom_implDetails.epoll_events_total = epoll_events_total;
+  tpFreedom_implDetails.epoll_events_n = epoll_events_n;
+}
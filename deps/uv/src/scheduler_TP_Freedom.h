@@ -32,6 +32,11 @@ struct scheduler_tp_freedom_args_s
   /* In uv__run_closing, what percentage of the time will we defer a handle until the next turn of the loop? */
   int run_closing_defer_perc;
 
+  /* uv_work_should_inline parameters. */
+
+  /* What percentage of the small work items offered to run inline do we send to the TP anyway? */
+  int inline_defer_perc;
+
   /* Timer parameters. */
   /* In uv__run_timers, how far can we swap ready timers? Give -1 for "no limit". 
    * Legal because of https://nodejs.org/api/timers.html#timers_settimeout_callback_delay_arg. */
@@ -45,6 +50,12 @@ struct scheduler_tp_freedom_args_s
   int timer_max_early_multiple;
   /* Probability of executing a timer late. Measured in tenths of a percent. */
   int timer_late_exec_tperc;
+
+  /* Adaptive mode. */
+  /* If non-zero, tune tp_max_delay_us and the defer knobs while running to keep the
+   * time the TP spends waiting for its queue under this percentage of the run time.
+   * The values above are then upper bounds. 0 means "use them as given". */
+  int adaptive_overhead_perc;
 };
 typedef struct scheduler_tp_freedom_args_s scheduler_tp_freedom_args_t;
 
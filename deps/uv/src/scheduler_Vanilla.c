@@ -108,6 +108,11 @@ scheduler_vanilla_thread_yield (schedule_point_t point, void *pointDetails)
       /* Don't short-circuit; close all handles. */
       ((spd_looper_run_closing_t *) pointDetails)->defer = 0;
       break;
+    case SCHEDULE_POINT_LOOPER_RUN_INLINE:
+      assert(scheduler__get_thread_type() == THREAD_TYPE_LOOPER);
+      /* Nothing to fuzz; take the fast path. */
+      ((spd_looper_run_inline_t *) pointDetails)->run_inline = 1;
+      break;
     case SCHEDULE_POINT_TIMER_READY:
       assert(scheduler__get_thread_type() == THREAD_TYPE_LOOPER);
       spd_timer_ready = (spd_timer_ready_t *) pointDetails;
@@ -133,6 +138,13 @@ scheduler_vanilla_thread_yield (schedule_point_t point, void *pointDetails)
       else
         spd_timer_next_timeout->time_until_timer = spd_timer_next_timeout->timer->timeout - spd_timer_next_timeout->now;
       break;
+    case SCHEDULE_POINT_LOOPER_ACCEPT:
+      assert(scheduler__get_thread_type() == THREAD_TYPE_LOOPER);
+      /* Announce new connections in the order we accepted them. */
+      break;
+    case SCHEDULE_POINT_LOOPER_SOURCE_CLOSED:
+      /* We don't track sources. */
+      break;
     default:
       /* Nothing to do. */
       break;
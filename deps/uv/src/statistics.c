@@ -92,6 +92,17 @@ void statistics_record (statistic_t stat, int value)
   statistics__unlock();
 }
 
+void statistics_get (statistic_t stat, unsigned long int *total, unsigned long int *n_calls)
+{
+  assert(statistic_valid(stat));
+  assert(total != NULL && n_calls != NULL);
+
+  statistics__lock();
+  *total = statistics_records[stat].total;
+  *n_calls = statistics_records[stat].n_calls;
+  statistics__unlock();
+}
+
 void statistics_dump (void)
 {
   assert(initialized);
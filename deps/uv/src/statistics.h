@@ -42,6 +42,12 @@ void statistics_init (void);
  */
 void statistics_record (statistic_t stat, int value);
 
+/* Get the running total and number of observations of STAT so far,
+ *   e.g. to compute an average while the program runs. 
+ * Thread safe.
+ */
+void statistics_get (statistic_t stat, unsigned long int *total, unsigned long int *n_calls);
+
 /* Dump all of the statistics we've recorded to stdout. 
  * Suitable for use with atexit, and registered as such by statistics_init.
  */
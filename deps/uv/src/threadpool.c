@@ -203,6 +203,9 @@ static void worker(void* arg) {
     mylog(LOG_THREADPOOL, 9, "worker: Got work item %i\n", work_item_number);
     w = QUEUE_DATA(q, struct uv__work, wq);
 
+    /* The work CB is serialized with the CBs of the loop that submitted it. */
+    scheduler_loop_bind(w->loop);
+
     /* Yield to scheduler. */
     spd_got_work_init(&spd_got_work);
     spd_got_work.work_item = w;
@@ -236,6 +239,7 @@ static void worker(void* arg) {
     spd_after_put_done.work_item = w;
     spd_after_put_done.work_item_num = work_item_number;
     scheduler_thread_yield(SCHEDULE_POINT_TP_AFTER_PUT_DONE, &spd_after_put_done);
+    scheduler_loop_bind(NULL);
 
     statistics_record(STATISTIC_TP_WORK_EXECUTED, 1);
   }
@@ -259,6 +263,7 @@ UV_DESTRUCTOR(static void cleanup(void)) {
 
     mylog(LOG_THREADPOOL, 1, "cleanup: unwinding CB stack\n");
     spd_after_exec_cb_init(&spd_after_exec_cb);
+    spd_after_exec_cb.cb_type = CALLBACK_TYPE_ANY; /* Whatever it was, it holds the lock. */
     spd_after_exec_cb.lcbn = NULL;
     scheduler_thread_yield(SCHEDULE_POINT_AFTER_EXEC_CB, &spd_after_exec_cb);
   }
@@ -320,6 +325,58 @@ static void init_once(void) {
   initialized = 1;
 }
 
+
+#ifndef _WIN32
+/* For uv_fork_server: wait until every worker is idle, then return with
+ * the pool locked so that no worker holds anything across the fork().
+ * Returns UV_EBUSY if the workers stay busy.
+ */
+int uv__threadpool_before_fork(void) {
+  int i;
+
+  if (!initialized)
+    return 0;
+
+  for (i = 0; i < 1000; i++) {
+    uv_mutex_lock(&mutex);
+    if (idle_threads == nthreads)
+      return 0;
+    uv_mutex_unlock(&mutex);
+    usleep(1000);
+  }
+
+  return UV_EBUSY;
+}
+
+
+/* Undoes uv__threadpool_before_fork. In the child, the workers are gone:
+ * start new ones. Work that was queued stays queued for them.
+ */
+void uv__threadpool_after_fork(int is_child) {
+  unsigned int i;
+
+  if (!initialized)
+    return;
+
+  if (!is_child) {
+    uv_mutex_unlock(&mutex);
+    return;
+  }
+
+  if (uv_cond_init(&cond))
+    abort();
+
+  if (uv_mutex_init(&mutex))
+    abort();
+
+  idle_threads = 0;
+  mylog(LOG_THREADPOOL, 1, "uv__threadpool_after_fork: %i threads\n", nthreads);
+  for (i = 0; i < nthreads; i++)
+    if (uv_thread_create(threads + i, worker, NULL))
+      abort();
+}
+#endif
+
 void uv__work_done(uv_async_t *handle) {
   struct uv__work *w = NULL;
   uv__work_async_t *uv__work_async = NULL;
@@ -440,6 +497,19 @@ int uv_queue_work(uv_loop_t* loop,
 }
 
 
+int uv_work_should_inline(uv_loop_t* loop, size_t size) {
+  spd_looper_run_inline_t spd_looper_run_inline;
+
+  spd_looper_run_inline_init(&spd_looper_run_inline);
+  spd_looper_run_inline.size = size;
+  scheduler_thread_yield(SCHEDULE_POINT_LOOPER_RUN_INLINE, &spd_looper_run_inline);
+  assert(spd_looper_run_inline.run_inline == 0 || spd_looper_run_inline.run_inline == 1);
+
+  mylog(LOG_THREADPOOL, 7, "uv_work_should_inline: loop %p size %lu run_inline %i\n", loop, (unsigned long) size, spd_looper_run_inline.run_inline);
+  return spd_looper_run_inline.run_inline;
+}
+
+
 int uv_cancel(uv_req_t* req) {
   struct uv__work* wreq;
   uv_loop_t* loop;
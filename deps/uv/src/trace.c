@@ -0,0 +1,190 @@
+#include "trace.h"
+
+#include "uv.h"
+#include "runtime.h"
+#include "logfile.h"
+
+#include <stdio.h>
+#include <stdlib.h> /* atexit */
+#include <assert.h>
+
+/* Private declarations. */
+
+static logfile_t trace;
+
+static int initialized = 0;
+
+/* Private helpers. */
+static void trace__open_cb (logfile_t *logfile);
+static void trace__close_cb (logfile_t *logfile);
+static void trace__close (void);
+/* Format the current time, in usec since trace.start, into TS. */
+static void trace__now (char *ts, size_t size);
+/* Account for an event of LEN bytes, stopping if we hit the cap. Caller holds the mutex. */
+static void trace__account (int len);
+
+/* Public API implementation. */
+
+void trace_init (void)
+{
+  const char *file = NULL;
+
+  if (initialized)
+    return;
+  initialized = 1;
+
+  file = runtime_trace_file();
+  logfile_init(&trace, file, "w", trace__open_cb, trace__close_cb);
+  if (file != NULL)
+    assert(atexit(trace__close) == 0);
+}
+
+int trace_enabled (void)
+{
+  return trace.enabled;
+}
+
+void trace_begin (const char *name, const char *cat, const void *context)
+{
+  char ts[64];
+  int len;
+
+  if (!trace.enabled)
+    return;
+
+  uv_mutex_lock(&trace.mutex);
+  if (trace.enabled)
+  {
+    trace__now(ts, sizeof ts);
+    if (context != NULL)
+      len = fprintf(trace.fileP, "{\"ph\":\"B\",\"name\":\"%s\",\"cat\":\"%s\",\"ts\":%s,\"pid\":%i,\"tid\":%lu,\"args\":{\"context\":\"%p\"}},\n",
+                    name, cat, ts, trace.pid, (long unsigned) uv_thread_self(), context);
+    else
+      len = fprintf(trace.fileP, "{\"ph\":\"B\",\"name\":\"%s\",\"cat\":\"%s\",\"ts\":%s,\"pid\":%i,\"tid\":%lu},\n",
+                    name, cat, ts, trace.pid, (long unsigned) uv_thread_self());
+    trace__account(len);
+  }
+  uv_mutex_unlock(&trace.mutex);
+}
+
+void trace_end (const char *name, const char *cat)
+{
+  char ts[64];
+  int len;
+
+  if (!trace.enabled)
+    return;
+
+  uv_mutex_lock(&trace.mutex);
+  if (trace.enabled)
+  {
+    trace__now(ts, sizeof ts);
+    len = fprintf(trace.fileP, "{\"ph\":\"E\",\"name\":\"%s\",\"cat\":\"%s\",\"ts\":%s,\"pid\":%i,\"tid\":%lu},\n",
+                  name, cat, ts, trace.pid, (long unsigned) uv_thread_self());
+    trace__account(len);
+  }
+  uv_mutex_unlock(&trace.mutex);
+}
+
+void trace_instant (const char *name, const char *cat, unsigned long decision)
+{
+  char ts[64];
+  int len;
+
+  if (!trace.enabled)
+    return;
+
+  uv_mutex_lock(&trace.mutex);
+  if (trace.enabled)
+  {
+    trace__now(ts, sizeof ts);
+    len = fprintf(trace.fileP, "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"cat\":\"%s\",\"ts\":%s,\"pid\":%i,\"tid\":%lu,\"args\":{\"decision\":\"%lx\"}},\n",
+                  name, cat, ts, trace.pid, (long unsigned) uv_thread_self(), decision);
+    trace__account(len);
+  }
+  uv_mutex_unlock(&trace.mutex);
+}
+
+void trace_thread_name (const char *name)
+{
+  int len;
+
+  if (!trace.enabled)
+    return;
+
+  uv_mutex_lock(&trace.mutex);
+  if (trace.enabled)
+  {
+    len = fprintf(trace.fileP, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%i,\"tid\":%lu,\"args\":{\"name\":\"%s\"}},\n",
+                  trace.pid, (long unsigned) uv_thread_self(), name);
+    trace__account(len);
+  }
+  uv_mutex_unlock(&trace.mutex);
+}
+
+void trace_before_fork (void)
+{
+  logfile_before_fork(&trace);
+}
+
+void trace_after_fork (int is_child)
+{
+  logfile_after_fork(&trace, is_child);
+}
+
+/* Embedder API, declared in uv.h. */
+
+int uv_trace_enabled (void)
+{
+  return trace_enabled();
+}
+
+void uv_trace_begin (const char *name)
+{
+  trace_begin(name, "node", NULL);
+}
+
+void uv_trace_end (const char *name)
+{
+  trace_end(name, "node");
+}
+
+/* Private helpers. */
+
+static void trace__open_cb (logfile_t *logfile)
+{
+  fputs("[\n", logfile->fileP);
+}
+
+static void trace__close_cb (logfile_t *logfile)
+{
+  /* The last event has no trailing comma. */
+  fprintf(logfile->fileP, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%i,\"tid\":0,\"args\":{\"name\":\"libuv %i\"}}\n]\n",
+          logfile->pid, logfile->pid);
+}
+
+static void trace__close (void)
+{
+  logfile_close(&trace);
+}
+
+static void trace__now (char *ts, size_t size)
+{
+  long unsigned ns;
+
+  ns = (long unsigned) logfile_now(&trace);
+  snprintf(ts, size, "%lu.%03lu", ns / 1000, ns % 1000);
+}
+
+static void trace__account (int len)
+{
+  char ts[64];
+
+  if (logfile_account(&trace, len))
+  {
+    trace__now(ts, sizeof ts);
+    fprintf(trace.fileP, "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"trace truncated (UV_TRACE_MAX_MB)\",\"cat\":\"trace\",\"ts\":%s,\"pid\":%i,\"tid\":%lu},\n",
+            ts, trace.pid, (long unsigned) uv_thread_self());
+    trace.enabled = 0;
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef UV_SRC_TRACE_H_
+#define UV_SRC_TRACE_H_
+
+/* This module streams a timeline of the CBs we run, and of the scheduler's decisions,
+ * to the file named by UV_TRACE_FILE.
+ *
+ * The file is in the JSON Array Format of Chrome's Trace Event Format, so a run can be
+ * opened directly in chrome://tracing or ui.perfetto.dev:
+ *   - Each CB is a slice on the thread that ran it, named after its type, with the handle or req in args.context.
+ *   - Time spent in epoll is a slice on the looper.
+ *   - Each scheduler decision is an instant event, with a digest of the choice in args.decision.
+ * Events are written one per line as they happen. The closing ']' is written at exit;
+ *   the viewers accept a file without it, so a crashed run can be opened too.
+ *
+ * The file itself is handled by src/logfile.h.
+ *
+ * Bounds:
+ *   - Loss: the file is fully buffered (UV_TRACE_BUFFER_KB, default 64). A process that dies without
+ *     running its atexit handlers loses at most one buffer's worth of events. 0 means unbuffered.
+ *   - Size and overhead: once the file reaches UV_TRACE_MAX_MB (default 256), tracing stops.
+ *     Each event costs one formatted write into the buffer under a mutex.
+ * With UV_TRACE_FILE unset, each hook costs one test of a flag.
+ */
+
+/* Initialize the trace module. Call after runtime_init.
+ * Call once. Not thread safe. */
+void trace_init (void);
+
+/* Returns non-zero if we are tracing. */
+int trace_enabled (void);
+
+/* The calling thread begins or ends a slice called NAME, in category CAT.
+ * CONTEXT, if non-NULL, is recorded in args.context.
+ * Slices on a thread must nest.
+ * Thread safe. */
+void trace_begin (const char *name, const char *cat, const void *context);
+void trace_end (const char *name, const char *cat);
+
+/* The calling thread made a decision called NAME. DECISION is recorded in args.decision.
+ * Thread safe. */
+void trace_instant (const char *name, const char *cat, unsigned long decision);
+
+/* Name the calling thread in the viewer.
+ * Thread safe. */
+void trace_thread_name (const char *name);
+
+/* Call in the parent just before fork(), then trace_after_fork in both processes.
+ * The child streams to "<UV_TRACE_FILE>.<pid>". */
+void trace_before_fork (void);
+void trace_after_fork (int is_child);
+
+#endif  /* UV_SRC_TRACE_H_ */
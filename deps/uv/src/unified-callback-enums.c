@@ -251,3 +251,9 @@ int is_internal_event (enum callback_type cbt)
 {
   return (INTERNAL_BEGIN <= cbt && cbt <= INTERNAL_END);
 }
+
+int is_wrapper_cb (enum callback_type cbt)
+{
+  assert(CALLBACK_TYPE_MIN <= cbt && cbt < CALLBACK_TYPE_MAX);
+  return (cbt == UV__IO_CB || cbt == UV__ASYNC_CB || cbt == UV__WORK_WORK || cbt == UV__WORK_DONE);
+}
@@ -173,4 +173,8 @@ int is_marker_event (enum callback_type cb_type);
                        present in libuv. */
 int is_internal_event (enum callback_type cb_type);
 
+/* "wrapper" -- libuv plumbing (uv__stream_io, uv__queue_work, ...) that does no user work itself,
+                but invokes the user-facing CBs, each through invoke_callback_wrap. */
+int is_wrapper_cb (enum callback_type cb_type);
+
 #endif /* UV_UNIFIED_CALLBACK_ENUMS_H_ */
@@ -381,6 +381,7 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   int timeout;
   int r;
   int ran_pending;
+  uv_loop_t* prev_loop;
   static int here_already = 0;
   static long unsigned loop_num = 0;
 
@@ -396,6 +397,9 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   else
     here_already = 1;
 
+  /* Our CBs are serialized with each other, not with those of other loops. */
+  prev_loop = scheduler_loop_enter(loop);
+
   r = uv__loop_alive(loop);
   if (!r)
     uv__update_time(loop);
@@ -464,6 +468,8 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   if (loop->stop_flag != 0)
     loop->stop_flag = 0;
 
+  scheduler_loop_leave(prev_loop);
+
   ENTRY_EXIT_LOG((LOG_MAIN, 9, "uv_run: returning r %i\n", r));
   return r;
 }
@@ -1014,6 +1020,15 @@ void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
 
 void uv__io_close(uv_loop_t* loop, uv__io_t* w) {
+  spd_looper_source_closed_t spd_looper_source_closed;
+
+  /* The fd number is about to be free for reuse.
+   * If no loop has initialized the scheduler, it has seen no sources. */
+  spd_looper_source_closed_init(&spd_looper_source_closed);
+  spd_looper_source_closed.fd = w->fd;
+  if (w->fd != -1 && scheduler_is_initialized())
+    scheduler_thread_yield(SCHEDULE_POINT_LOOPER_SOURCE_CLOSED, &spd_looper_source_closed);
+
   uv__io_stop(loop, w, UV__POLLIN | UV__POLLOUT);
   QUEUE_REMOVE(&w->pending_queue);
 
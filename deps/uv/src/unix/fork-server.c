@@ -0,0 +1,212 @@
+/* Fork-server mode.
+ *
+ * A fuzzing campaign runs the same program many times with different
+ * scheduler seeds. Rather than pay for process startup on every run, the
+ * program calls uv_fork_server() once it is initialized. If
+ * UV_FORK_SERVER_FD is set, the process becomes a fork server. Each
+ * request from the driver forks a child. The child reseeds the scheduler
+ * and returns from uv_fork_server() to run the rest of the program.
+ *
+ * Protocol (fds are UV_FORK_SERVER_FD and UV_FORK_SERVER_FD + 1, as in AFL):
+ *   server -> driver  int32 0            once, when the server is ready.
+ *   driver -> server  uint32 seed        request a run. EOF stops the server.
+ *   server -> driver  int32 pid          the child is running. The driver
+ *                                        may kill it, e.g. on a timeout.
+ *                                        A negative value is the -errno
+ *                                        of a failed fork; the server has
+ *                                        exited and nothing else follows.
+ *   server -> driver  int32 status       the child's waitpid() status.
+ *   server -> driver  uint64 hash        scheduler_schedule_hash() at the
+ *                                        child's exit, or 0 if it crashed.
+ *
+ * Until it reports ready, the server returns errors to its caller. Once in
+ * the loop it never returns: the caller's stack belongs to the children.
+ */
+
+#include "uv.h"
+#include "internal.h"
+#include "scheduler.h"
+#include "mylog.h"
+#include "trace.h"
+#include "causal.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+static int fork_server_report_fd = -1;
+
+
+static int uv__fork_server_read(int fd, void* buf, size_t len) {
+  ssize_t n;
+
+  do
+    n = read(fd, buf, len);
+  while (n == -1 && errno == EINTR);
+
+  return n == (ssize_t) len ? 0 : -1;
+}
+
+
+static void uv__fork_server_write(int fd, const void* buf, size_t len) {
+  ssize_t n;
+
+  do
+    n = write(fd, buf, len);
+  while (n == -1 && errno == EINTR);
+
+  /* If the driver went away, the next read() tells us. */
+  (void) n;
+}
+
+
+/* The server can't start a run. Tell the driver and give up. */
+static void uv__fork_server_fail(int st_fd, int err) {
+  int32_t msg;
+
+  assert(err < 0);
+  msg = err;
+  uv__fork_server_write(st_fd, &msg, sizeof(msg));
+  _exit(1);
+}
+
+
+/* Runs at the child's exit. */
+static void uv__fork_server_report(void) {
+  uint64_t hash;
+
+  if (fork_server_report_fd == -1)
+    return;
+
+  hash = scheduler_schedule_hash();
+  uv__fork_server_write(fork_server_report_fd, &hash, sizeof(hash));
+  uv__close(fork_server_report_fd);
+  fork_server_report_fd = -1;
+}
+
+
+#if defined(__linux__)
+static int uv__fork_server_child(uv_loop_t* loop, unsigned seed, int report_fd) {
+  int err;
+
+  mylog_after_fork();
+  trace_after_fork(1);
+  causal_after_fork(1);
+  /* Before the workers start: they register themselves with the scheduler. */
+  scheduler_after_fork(seed);
+  uv__threadpool_after_fork(1);
+
+  /* Processes this run spawns are not fork servers. */
+  unsetenv("UV_FORK_SERVER_FD");
+
+  err = uv__platform_loop_fork(loop);
+  if (err)
+    return err;
+
+  fork_server_report_fd = report_fd;
+  if (atexit(uv__fork_server_report))
+    return -ENOMEM;
+
+  mylog(LOG_MAIN, 1, "uv__fork_server_child: running with seed %u\n", seed);
+  return 0;
+}
+#endif
+
+
+int uv_fork_server(uv_loop_t* loop) {
+#if defined(__linux__)
+  static int started;
+  const char* val;
+  int report[2];
+  int32_t msg;
+  uint32_t seed;
+  uint64_t hash;
+  int ctl_fd;
+  int st_fd;
+  int status;
+  pid_t pid;
+  int err;
+
+  val = getenv("UV_FORK_SERVER_FD");
+  if (val == NULL || started)
+    return 0;
+  started = 1;
+
+  ctl_fd = atoi(val);
+  st_fd = ctl_fd + 1;
+
+  /* A replay must not be forked into many. */
+  if (scheduler_get_scheduler_mode() != SCHEDULER_MODE_RECORD)
+    return -EINVAL;
+
+  /* Whoever holds the CB mutex would not own it in the child. */
+  if (scheduler_current_cb_thread() != NO_CURRENT_CB_THREAD)
+    return -EBUSY;
+
+  msg = 0;
+  uv__fork_server_write(st_fd, &msg, sizeof(msg));
+
+  for (;;) {
+    if (uv__fork_server_read(ctl_fd, &seed, sizeof(seed)))
+      _exit(0);  /* The driver is done with us. */
+
+    err = uv__make_pipe(report, 0);
+    if (err)
+      uv__fork_server_fail(st_fd, err);
+
+    err = uv__threadpool_before_fork();
+    if (err)
+      uv__fork_server_fail(st_fd, err);
+
+    /* Don't let the child inherit our buffered output (the schedule file, stdout).
+     * The log mutexes stay held across the fork, so no other thread refills their buffers. */
+    trace_before_fork();
+    causal_before_fork();
+    fflush(NULL);
+
+    pid = fork();
+    if (pid == -1)
+      uv__fork_server_fail(st_fd, -errno);
+
+    if (pid == 0) {
+      uv__close(ctl_fd);
+      uv__close(st_fd);
+      uv__close(report[0]);
+      return uv__fork_server_child(loop, seed, report[1]);
+    }
+
+    trace_after_fork(0);
+    causal_after_fork(0);
+    uv__threadpool_after_fork(0);
+    uv__close(report[1]);
+
+    msg = pid;
+    uv__fork_server_write(st_fd, &msg, sizeof(msg));
+
+    do
+      err = waitpid(pid, &status, 0);
+    while (err == -1 && errno == EINTR);
+    if (err == -1)
+      abort();
+
+    if (uv__fork_server_read(report[0], &hash, sizeof(hash)))
+      hash = 0;
+    uv__close(report[0]);
+
+    msg = status;
+    uv__fork_server_write(st_fd, &msg, sizeof(msg));
+    uv__fork_server_write(st_fd, &hash, sizeof(hash));
+  }
+#else
+  (void) loop;
+  (void) uv__fork_server_read;
+  (void) uv__fork_server_fail;
+  (void) uv__fork_server_report;
+  return getenv("UV_FORK_SERVER_FD") == NULL ? 0 : -ENOSYS;
+#endif
+}
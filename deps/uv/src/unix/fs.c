@@ -412,6 +412,90 @@ static ssize_t uv__fs_readlink(uv_fs_t* req) {
 }
 
 
+static int uv__fs_fstat(int fd, uv_stat_t *buf);
+
+
+/* open, fstat, read to EOF and close, in one go. The file may hold at most
+ * req->bufsml[0].len bytes. req->statbuf stays zeroed unless the open worked.
+ */
+static ssize_t uv__fs_readfile(uv_fs_t* req) {
+  uv_stat_t s;
+  size_t max_size;
+  size_t size;
+  size_t len;
+  ssize_t n;
+  char* buf;
+  char* tmp;
+  int saved_errno;
+  int fd;
+
+  fd = uv__fs_open(req);
+  if (fd == -1)
+    return -1;
+
+  buf = NULL;
+  len = 0;
+  max_size = req->bufsml[0].len;
+
+  if (uv__fs_fstat(fd, &s))
+    goto error;
+  req->statbuf = s;
+
+  if (S_ISREG(s.st_mode) && s.st_size > max_size) {
+    errno = EFBIG;
+    goto error;
+  }
+
+  /* st_size is only a hint: it is 0 for most special files and for procfs,
+   * and the file may change while we read it. Leave room to see EOF in the
+   * first read.
+   */
+  if (S_ISREG(s.st_mode) && s.st_size > 0)
+    size = (size_t) s.st_size + 1;
+  else
+    size = 8192;
+
+  for (;;) {
+    if (len == size || buf == NULL) {
+      if (buf != NULL)
+        size *= 2;
+      tmp = uv__realloc(buf, size);
+      if (tmp == NULL) {
+        errno = ENOMEM;
+        goto error;
+      }
+      buf = tmp;
+    }
+
+    do
+      n = read(fd, buf + len, size - len);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1)
+      goto error;
+    if (n == 0)
+      break;
+    len += n;
+
+    if (len > max_size) {
+      errno = EFBIG;
+      goto error;
+    }
+  }
+
+  close(fd);
+  req->ptr = buf;
+  return len;
+
+error:
+  saved_errno = errno;
+  uv__free(buf);
+  close(fd);
+  errno = saved_errno;
+  return -1;
+}
+
+
 static ssize_t uv__fs_sendfile_emul(uv_fs_t* req) {
   struct pollfd pfd;
   int use_pread;
@@ -874,6 +958,7 @@ static void uv__fs_work(struct uv__work* w) {
     X(READ, uv__fs_buf_iter(req, uv__fs_read));
     X(SCANDIR, uv__fs_scandir(req));
     X(READLINK, uv__fs_readlink(req));
+    X(READFILE, uv__fs_readfile(req));
     X(RENAME, rename(req->path, req->new_path));
     X(RMDIR, rmdir(req->path));
     X(SENDFILE, uv__fs_sendfile(req));
@@ -1190,6 +1275,24 @@ int uv_fs_readlink(uv_loop_t* loop,
 }
 
 
+int uv_fs_readfile(uv_loop_t* loop,
+                   uv_fs_t* req,
+                   const char* path,
+                   int flags,
+                   int mode,
+                   size_t max_size,
+                   uv_fs_cb cb) {
+  uv_work_t *work_req;
+  INIT(READFILE);
+  memset(&req->statbuf, 0, sizeof(req->statbuf));
+  PATH;
+  req->flags = flags;
+  req->mode = mode;
+  req->bufsml[0].len = max_size;
+  POST;
+}
+
+
 int uv_fs_rename(uv_loop_t* loop,
                  uv_fs_t* req,
                  const char* path,
@@ -111,6 +111,43 @@ void uv__platform_loop_delete(uv_loop_t* loop) {
 }
 
 
+/* The child of a fork() shares the epoll instance with its parent, so its
+ * epoll_ctl() calls would change the parent's interest list too.
+ * Give the child its own, and have uv__io_poll re-add every watcher to it.
+ */
+int uv__platform_loop_fork(uv_loop_t* loop) {
+  uv__io_t* w;
+  unsigned int i;
+  int fd;
+
+  fd = uv__epoll_create1(UV__EPOLL_CLOEXEC);
+  if (fd == -1 && (errno == ENOSYS || errno == EINVAL)) {
+    fd = uv__epoll_create(256);
+
+    if (fd != -1)
+      uv__cloexec(fd, 1);
+  }
+
+  if (fd == -1)
+    return -errno;
+
+  uv__close(loop->backend_fd);
+  loop->backend_fd = fd;
+
+  for (i = 0; i < loop->nwatchers; i++) {
+    w = loop->watchers[i];
+    if (w == NULL)
+      continue;
+
+    w->events = 0;
+    if (QUEUE_EMPTY(&w->watcher_queue))
+      QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
+  }
+
+  return 0;
+}
+
+
 void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
   struct uv__epoll_event* events;
   struct uv__epoll_event dummy;
@@ -98,6 +98,7 @@ fail_signal_init:
 
 
 void uv__loop_close(uv_loop_t* loop) {
+  scheduler_loop_close(loop);
   uv__signal_loop_cleanup(loop);
   uv__platform_loop_delete(loop);
 
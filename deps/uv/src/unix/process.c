@@ -25,14 +25,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <limits.h> /* PATH_MAX */
 
 #if defined(__APPLE__) && !TARGET_OS_IPHONE
 # include <crt_externs.h>
@@ -45,6 +48,18 @@ extern char **environ;
 # include <grp.h>
 #endif
 
+/* From glibc 2.24, posix_spawn() uses CLONE_VM | CLONE_VFORK instead of
+ * fork(), so its cost doesn't grow with the size of the parent's heap.
+ */
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 24))
+# define UV__HAVE_POSIX_SPAWN 1
+# include <spawn.h>
+# if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29)
+#  define UV__HAVE_POSIX_SPAWN_CHDIR 1
+# endif
+#endif
+
 
 static void uv__chld(uv_signal_t* handle, int signum) {
   uv_process_t* process;
@@ -382,49 +397,218 @@ static void uv__process_child_init(const uv_process_options_t* options,
 }
 
 
-int uv_spawn(uv_loop_t* loop,
-             uv_process_t* process,
-             const uv_process_options_t* options) {
-  int signal_pipe[2] = { -1, -1 };
-  int (*pipes)[2];
-  int stdio_count;
-  ssize_t r;
-  pid_t pid;
-  int err;
-  int exec_errorno;
+#if defined(UV__HAVE_POSIX_SPAWN)
+/* execvp() searches the PATH of the environment it is about to install,
+ * not ours. Do the same. Returns -ENOSYS for anything execvp() should
+ * handle itself, e.g. relative PATH entries or a file that isn't there.
+ */
+static int uv__spawn_search_path(const uv_process_options_t* options,
+                                 char* buf,
+                                 size_t bufsize) {
+  const char* path;
+  const char* end;
+  struct stat st;
+  size_t filelen;
+  size_t dirlen;
+  char** env;
+
+  filelen = strlen(options->file);
+
+  if (strchr(options->file, '/') != NULL) {
+    if (filelen >= bufsize)
+      return -ENOSYS;
+    memcpy(buf, options->file, filelen + 1);
+    return 0;
+  }
+
+  path = NULL;
+  if (options->env != NULL) {
+    for (env = options->env; *env != NULL; env++)
+      if (strncmp(*env, "PATH=", 5) == 0) {
+        path = *env + 5;
+        break;
+      }
+  } else {
+    path = getenv("PATH");
+  }
+
+  if (path == NULL)
+    path = "/bin:/usr/bin";  /* Same default as execvp(). */
+
+  for (;;) {
+    end = strchr(path, ':');
+    if (end == NULL)
+      end = path + strlen(path);
+    dirlen = end - path;
+
+    /* Relative entries depend on the child's cwd. */
+    if (dirlen == 0 || path[0] != '/')
+      return -ENOSYS;
+
+    if (dirlen + 1 + filelen < bufsize) {
+      memcpy(buf, path, dirlen);
+      buf[dirlen] = '/';
+      memcpy(buf + dirlen + 1, options->file, filelen + 1);
+      if (stat(buf, &st) == 0 && S_ISREG(st.st_mode) && access(buf, X_OK) == 0)
+        return 0;
+    }
+
+    if (*end == '\0')
+      return -ENOSYS;
+    path = end + 1;
+  }
+}
+
+
+/* Spawns the child with posix_spawn() when uv__process_child_init() can be
+ * expressed as spawn file actions: no uid/gid changes, and stdio made of
+ * fds that dup2() can put in place in order. Must be called with the
+ * cloexec_lock held.
+ * Returns -ENOSYS if the caller should fork() instead, otherwise 0 or the
+ * error from exec(). In the latter case the child has already been reaped.
+ */
+static int uv__spawn_posix(const uv_process_options_t* options,
+                           int stdio_count,
+                           int (*pipes)[2],
+                           pid_t* pid) {
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  char path[PATH_MAX];
+  int use_fd;
+  int fd;
   int i;
-  int status;
+  int err;
 
-  assert(options->file != NULL);
-  assert(!(options->flags & ~(UV_PROCESS_DETACHED |
-                              UV_PROCESS_SETGID |
-                              UV_PROCESS_SETUID |
-                              UV_PROCESS_WINDOWS_HIDE |
-                              UV_PROCESS_WINDOWS_VERBATIM_ARGUMENTS)));
+  if (options->flags & (UV_PROCESS_SETUID | UV_PROCESS_SETGID))
+    return -ENOSYS;
 
-  uv__handle_init(loop, (uv_handle_t*)process, UV_PROCESS);
-  QUEUE_INIT(&process->queue);
+#if !defined(POSIX_SPAWN_SETSID)
+  if (options->flags & UV_PROCESS_DETACHED)
+    return -ENOSYS;
+#endif
 
-  stdio_count = options->stdio_count;
-  if (stdio_count < 3)
-    stdio_count = 3;
+#if !defined(UV__HAVE_POSIX_SPAWN_CHDIR)
+  if (options->cwd != NULL)
+    return -ENOSYS;
+#endif
 
-  err = -ENOMEM;
-  pipes = uv__malloc(stdio_count * sizeof(*pipes));
-  if (pipes == NULL)
-    goto error;
+  /* uv__process_child_init() moves every low fd out of the way before
+   * dup2()ing anything. File actions run in order, so we can only use them
+   * if no target fd is overwritten before it is read.
+   */
+  for (fd = 0; fd < stdio_count; fd++) {
+    use_fd = pipes[fd][1];
+    if (use_fd < 0 || use_fd >= fd)
+      continue;
+    if (pipes[use_fd][1] != use_fd)
+      return -ENOSYS;
+  }
 
-  for (i = 0; i < stdio_count; i++) {
-    pipes[i][0] = -1;
-    pipes[i][1] = -1;
+  /* dup2() onto itself leaves FD_CLOEXEC set. */
+  for (fd = 0; fd < stdio_count; fd++)
+    if (pipes[fd][1] == fd && (fcntl(fd, F_GETFD) & FD_CLOEXEC))
+      return -ENOSYS;
+
+  if (uv__spawn_search_path(options, path, sizeof(path)))
+    return -ENOSYS;
+
+  err = posix_spawn_file_actions_init(&actions);
+  if (err)
+    return -ENOSYS;
+
+  err = posix_spawnattr_init(&attr);
+  if (err) {
+    posix_spawn_file_actions_destroy(&actions);
+    return -ENOSYS;
   }
 
-  for (i = 0; i < options->stdio_count; i++) {
-    err = uv__process_init_stdio(options->stdio + i, pipes[i]);
-    if (err)
-      goto error;
+#if defined(POSIX_SPAWN_SETSID)
+  if (options->flags & UV_PROCESS_DETACHED)
+    err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#endif
+
+  for (fd = 0; fd < stdio_count && err == 0; fd++) {
+    use_fd = pipes[fd][1];
+
+    if (use_fd < 0) {
+      /* redirect stdin, stdout and stderr to /dev/null even if UV_IGNORE is
+       * set
+       */
+      if (fd < 3)
+        err = posix_spawn_file_actions_addopen(&actions,
+                                               fd,
+                                               "/dev/null",
+                                               fd == 0 ? O_RDONLY : O_RDWR,
+                                               0);
+      continue;
+    }
+
+    /* The child shares the file description, so this is what the child
+     * would do to its stdio after the dup2().
+     */
+    if (fd <= 2)
+      uv__nonblock(use_fd, 0);
+
+    if (use_fd != fd)
+      err = posix_spawn_file_actions_adddup2(&actions, use_fd, fd);
   }
 
+  for (fd = 0; fd < stdio_count && err == 0; fd++) {
+    use_fd = pipes[fd][1];
+    if (use_fd < stdio_count)
+      continue;
+
+    /* The same fd may back several stdio slots; close it once. */
+    for (i = 0; i < fd; i++)
+      if (pipes[i][1] == use_fd)
+        break;
+    if (i == fd)
+      err = posix_spawn_file_actions_addclose(&actions, use_fd);
+  }
+
+#if defined(UV__HAVE_POSIX_SPAWN_CHDIR)
+  if (options->cwd != NULL && err == 0)
+    err = posix_spawn_file_actions_addchdir_np(&actions, options->cwd);
+#endif
+
+  if (err == 0) {
+    *pid = 0;
+    err = posix_spawn(pid,
+                      path,
+                      &actions,
+                      &attr,
+                      options->args,
+                      options->env != NULL ? options->env : environ);
+
+    /* execvp() would run the file with /bin/sh, and a failed clone() is
+     * better reported by fork().
+     */
+    if (err == ENOEXEC || err == EAGAIN || err == ENOMEM)
+      err = ENOSYS;
+    err = -err;
+  } else {
+    err = -ENOSYS;
+  }
+
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return err;
+}
+#endif /* defined(UV__HAVE_POSIX_SPAWN) */
+
+
+static int uv__spawn_fork(uv_loop_t* loop,
+                          const uv_process_options_t* options,
+                          int stdio_count,
+                          int (*pipes)[2],
+                          pid_t* pid,
+                          int* exec_errorno) {
+  int signal_pipe[2] = { -1, -1 };
+  ssize_t r;
+  int status;
+  int err;
+
   /* This pipe is used by the parent to wait until
    * the child has called `execve()`. We need this
    * to avoid the following race condition:
@@ -447,23 +631,21 @@ int uv_spawn(uv_loop_t* loop,
    */
   err = uv__make_pipe(signal_pipe, 0);
   if (err)
-    goto error;
-
-  uv_signal_start(&loop->child_watcher, uv__chld, SIGCHLD);
+    return err;
 
   /* Acquire write lock to prevent opening new fds in worker threads */
   uv_rwlock_wrlock(&loop->cloexec_lock);
-  pid = fork();
+  *pid = fork();
 
-  if (pid == -1) {
+  if (*pid == -1) {
     err = -errno;
     uv_rwlock_wrunlock(&loop->cloexec_lock);
     uv__close(signal_pipe[0]);
     uv__close(signal_pipe[1]);
-    goto error;
+    return err;
   }
 
-  if (pid == 0) {
+  if (*pid == 0) {
     uv__process_child_init(options, stdio_count, pipes, signal_pipe[1]);
     abort();
   }
@@ -472,29 +654,90 @@ int uv_spawn(uv_loop_t* loop,
   uv_rwlock_wrunlock(&loop->cloexec_lock);
   uv__close(signal_pipe[1]);
 
-  process->status = 0;
-  exec_errorno = 0;
+  *exec_errorno = 0;
   do
-    r = read(signal_pipe[0], &exec_errorno, sizeof(exec_errorno));
+    r = read(signal_pipe[0], exec_errorno, sizeof(*exec_errorno));
   while (r == -1 && errno == EINTR);
 
   if (r == 0)
     ; /* okay, EOF */
-  else if (r == sizeof(exec_errorno)) {
+  else if (r == sizeof(*exec_errorno)) {
     do
-      err = waitpid(pid, &status, 0); /* okay, read errorno */
+      err = waitpid(*pid, &status, 0); /* okay, read errorno */
     while (err == -1 && errno == EINTR);
-    assert(err == pid);
+    assert(err == *pid);
   } else if (r == -1 && errno == EPIPE) {
     do
-      err = waitpid(pid, &status, 0); /* okay, got EPIPE */
+      err = waitpid(*pid, &status, 0); /* okay, got EPIPE */
     while (err == -1 && errno == EINTR);
-    assert(err == pid);
+    assert(err == *pid);
   } else
     abort();
 
   uv__close(signal_pipe[0]);
 
+  return 0;
+}
+
+
+int uv_spawn(uv_loop_t* loop,
+             uv_process_t* process,
+             const uv_process_options_t* options) {
+  int (*pipes)[2];
+  int stdio_count;
+  pid_t pid;
+  int err;
+  int exec_errorno;
+  int i;
+
+  assert(options->file != NULL);
+  assert(!(options->flags & ~(UV_PROCESS_DETACHED |
+                              UV_PROCESS_SETGID |
+                              UV_PROCESS_SETUID |
+                              UV_PROCESS_WINDOWS_HIDE |
+                              UV_PROCESS_WINDOWS_VERBATIM_ARGUMENTS)));
+
+  uv__handle_init(loop, (uv_handle_t*)process, UV_PROCESS);
+  QUEUE_INIT(&process->queue);
+
+  stdio_count = options->stdio_count;
+  if (stdio_count < 3)
+    stdio_count = 3;
+
+  err = -ENOMEM;
+  pipes = uv__malloc(stdio_count * sizeof(*pipes));
+  if (pipes == NULL)
+    goto error;
+
+  for (i = 0; i < stdio_count; i++) {
+    pipes[i][0] = -1;
+    pipes[i][1] = -1;
+  }
+
+  for (i = 0; i < options->stdio_count; i++) {
+    err = uv__process_init_stdio(options->stdio + i, pipes[i]);
+    if (err)
+      goto error;
+  }
+
+  uv_signal_start(&loop->child_watcher, uv__chld, SIGCHLD);
+
+  exec_errorno = -ENOSYS;
+#if defined(UV__HAVE_POSIX_SPAWN)
+  /* Acquire write lock to prevent opening new fds in worker threads */
+  uv_rwlock_wrlock(&loop->cloexec_lock);
+  exec_errorno = uv__spawn_posix(options, stdio_count, pipes, &pid);
+  uv_rwlock_wrunlock(&loop->cloexec_lock);
+#endif
+
+  if (exec_errorno == -ENOSYS) {
+    err = uv__spawn_fork(loop, options, stdio_count, pipes, &pid, &exec_errorno);
+    if (err)
+      goto error;
+  }
+
+  process->status = 0;
+
   for (i = 0; i < options->stdio_count; i++) {
     err = uv__process_open_stream(options->stdio + i, pipes[i], i == 0);
     if (err == 0)
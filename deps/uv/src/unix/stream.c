@@ -22,6 +22,7 @@
 #include "uv.h"
 #include "internal.h"
 #include "scheduler.h"
+#include "runtime.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,6 +40,9 @@
 #include <sys/ioctl.h> /* scheduling: FIONREAD for an assert */
 #include <termios.h>
 
+/* Upper bound on the iovecs uv__write gathers from queued write requests. */
+#define UV__WRITE_GATHER_MAX 1024
+
 #if defined(__APPLE__)
 # include <sys/event.h>
 # include <sys/time.h>
@@ -72,6 +76,8 @@ static void uv__read(uv_stream_t* stream);
 static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
 static void uv__write_callbacks(uv_stream_t* stream);
 static size_t uv__write_req_size(uv_write_t* req);
+static int uv__stream_queue_fd(uv_stream_t* stream, int fd);
+static int uv__stream_dequeue_fd(uv_stream_t* stream);
 
 /* Dummy CB for uv_try_write. */
 void uv_try_write_cb(uv_write_t* req, int status);
@@ -551,56 +557,140 @@ static int uv__emfile_trick(uv_loop_t* loop, int accept_fd) {
 #endif /* defined(UV_HAVE_KQUEUE) */
 
 
+/* Drain up to batch_size connections from the listen backlog into
+ * stream->queued_fds, then let the scheduler choose the order in which
+ * they are announced.
+ * Returns 0 if at least one connection was queued, else the accept error.
+ */
+static int uv__server_accept_batch(uv_stream_t* stream, int batch_size) {
+  uv__stream_queued_fds_t* queued_fds;
+  spd_looper_accept_t spd_looper_accept;
+  int naccepted;
+  int fd;
+  int err;
+
+  assert(stream->queued_fds == NULL);
+  assert(1 < batch_size);
+
+  naccepted = 0;
+  while (naccepted < batch_size) {
+#if defined(UV_HAVE_KQUEUE)
+    if (stream->io_watcher.rcount <= 0)
+      break;
+#endif /* defined(UV_HAVE_KQUEUE) */
+
+    fd = uv__accept(uv__stream_fd(stream));
+    if (fd < 0) {
+      if (fd == -ECONNABORTED)
+        continue;  /* Ignore. Nothing we can do about that. */
+
+      if (naccepted == 0)
+        return fd;
+
+      /* Dispatch what we have. The next accept reports the error, if any. */
+      break;
+    }
+
+    UV_DEC_BACKLOG((&stream->io_watcher))
+    err = uv__stream_queue_fd(stream, fd);
+    if (err) {
+      uv__close(fd);
+      if (naccepted == 0)
+        return err;
+      break;
+    }
+    naccepted++;
+  }
+
+  if (naccepted == 0)
+    return -EAGAIN;  /* kqueue says the backlog is empty. */
+
+  mylog(LOG_UV_STREAM, 7, "uv__server_accept_batch: stream %p (fd %i) accepted %i new connections\n", stream, stream->io_watcher.fd, naccepted);
+
+  queued_fds = stream->queued_fds;
+  spd_looper_accept_init(&spd_looper_accept);
+  spd_looper_accept.shuffleable_items.item_size = sizeof(*queued_fds->fds);
+  spd_looper_accept.shuffleable_items.nitems = queued_fds->offset;
+  spd_looper_accept.shuffleable_items.items = (void *) queued_fds->fds;
+  scheduler_thread_yield(SCHEDULE_POINT_LOOPER_ACCEPT, &spd_looper_accept);
+
+  return 0;
+}
+
+
 void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   uv_stream_t* stream = NULL;
+  int batch_size;
   int err;
 
   stream = container_of(w, uv_stream_t, io_watcher);
 
   ENTRY_EXIT_LOG((LOG_UV_STREAM, 9, "uv__server_io: begin: loop %p w %p events %i stream %p fd %i\n", loop, w, events, stream, stream->io_watcher.fd));
 
-  assert(events == UV__POLLIN);
-  assert(stream->accepted_fd == -1);
+  /* UV__POLLOUT means uv_accept() fed us because connections from an
+   * earlier batch are still queued. They may have been dispatched since.
+   */
+  assert(events == UV__POLLIN || events == UV__POLLOUT);
   assert(!(stream->flags & UV_CLOSING));
+  if (events == UV__POLLOUT &&
+      (stream->accepted_fd != -1 || stream->queued_fds == NULL))
+    goto DONE;
+  assert(stream->accepted_fd == -1);
 
   uv__io_start(stream->loop, &stream->io_watcher, UV__POLLIN);
 
+  batch_size = runtime_accept_batch_size();
+  if (stream->type == UV_TCP && (stream->flags & UV_TCP_SINGLE_ACCEPT))
+    batch_size = 1;
+
   /* connection_cb can close the server socket while we're
    * in the loop so check it on each iteration.
    */
   while (uv__stream_fd(stream) != -1) {
     assert(stream->accepted_fd == -1);
 
+    /* Dispatch the rest of the current batch before accepting more. */
+    if (stream->queued_fds == NULL) {
 #if defined(UV_HAVE_KQUEUE)
-    if (w->rcount <= 0)
-      goto DONE;
+      if (w->rcount <= 0)
+        goto DONE;
 #endif /* defined(UV_HAVE_KQUEUE) */
 
-    err = uv__accept(uv__stream_fd(stream));
-    if (err < 0) {
-      if (err == -EAGAIN || err == -EWOULDBLOCK)
-        goto DONE;  /* Not an error. */
+      if (1 < batch_size)
+        err = uv__server_accept_batch(stream, batch_size);
+      else
+        err = uv__accept(uv__stream_fd(stream));
+      if (err < 0) {
+        if (err == -EAGAIN || err == -EWOULDBLOCK)
+          goto DONE;  /* Not an error. */
 
-      if (err == -ECONNABORTED)
-        continue;  /* Ignore. Nothing we can do about that. */
+        if (err == -ECONNABORTED)
+          continue;  /* Ignore. Nothing we can do about that. */
 
-      if (err == -EMFILE || err == -ENFILE) {
-        err = uv__emfile_trick(loop, uv__stream_fd(stream));
-        if (err == -EAGAIN || err == -EWOULDBLOCK)
-          break;
-      }
+        if (err == -EMFILE || err == -ENFILE) {
+          err = uv__emfile_trick(loop, uv__stream_fd(stream));
+          if (err == -EAGAIN || err == -EWOULDBLOCK)
+            break;
+        }
 
 #if UNIFIED_CALLBACK
-      mylog(LOG_UV_STREAM, 7, "uv__server_io: accepting new connection failed\n");
-      invoke_callback_wrap((any_func) stream->connection_cb, UV_CONNECTION_CB, (long) stream, (long) err);
+        mylog(LOG_UV_STREAM, 7, "uv__server_io: accepting new connection failed\n");
+        invoke_callback_wrap((any_func) stream->connection_cb, UV_CONNECTION_CB, (long) stream, (long) err);
 #else
-      stream->connection_cb(stream, err);
+        stream->connection_cb(stream, err);
 #endif
-      continue;
-    } /* end of err < 0 case */
+        continue;
+      } /* end of err < 0 case */
+
+      if (batch_size == 1) {
+        UV_DEC_BACKLOG(w)
+        stream->accepted_fd = err;
+      }
+    }
+
+    if (stream->accepted_fd == -1)
+      stream->accepted_fd = uv__stream_dequeue_fd(stream);
 
-    UV_DEC_BACKLOG(w)
-    stream->accepted_fd = err;
 #if UNIFIED_CALLBACK
     mylog(LOG_UV_STREAM, 7, "uv__server_io: stream %p (fd %i) accepted new connection (accepted_fd %i)\n", stream, stream->io_watcher.fd, stream->accepted_fd);
     invoke_callback_wrap((any_func) stream->connection_cb, UV_CONNECTION_CB, (long) stream, (long) 0);
@@ -672,30 +762,17 @@ int uv_accept(uv_stream_t* server, uv_stream_t* client) {
   }
 
 done:
-  /* Process queued fds */
-  if (server->queued_fds != NULL) {
-    uv__stream_queued_fds_t* queued_fds;
-
-    queued_fds = server->queued_fds;
-
-    /* Read first */
-    server->accepted_fd = queued_fds->fds[0];
-
-    /* All read, free */
-    assert(queued_fds->offset > 0);
-    if (--queued_fds->offset == 0) {
-      uv__free(queued_fds);
-      server->queued_fds = NULL;
-    } else {
-      /* Shift rest */
-      memmove(queued_fds->fds,
-              queued_fds->fds + 1,
-              queued_fds->offset * sizeof(*queued_fds->fds));
-    }
+  /* Process queued fds. A listening server's queue holds the rest of an
+   * accept batch; uv__server_io announces those one UV_CONNECTION_CB at a time.
+   */
+  if (server->queued_fds != NULL && server->io_watcher.cb != uv__server_io) {
+    server->accepted_fd = uv__stream_dequeue_fd(server);
   } else {
     server->accepted_fd = -1;
     if (err == 0)
       uv__io_start(server->loop, &server->io_watcher, UV__POLLIN);
+    if (server->queued_fds != NULL)
+      uv__io_feed(server->loop, &server->io_watcher);
   }
 
 RETURN:
@@ -825,7 +902,39 @@ static int uv__handle_fd(uv_handle_t* handle) {
   }
 }
 
+/* Gather the unwritten bufs of the requests queued on stream, starting at the
+ * head, into iov (at most iovmax entries). This lets one writev() cover many
+ * small uv_write()s. Gathering stops at a request that passes a handle, since
+ * that one needs a sendmsg() of its own.
+ * Returns the number of entries in iov.
+ */
+static int uv__write_gather(uv_stream_t* stream, struct iovec* iov, int iovmax) {
+  QUEUE* q;
+  uv_write_t* req;
+  unsigned int i;
+  int iovcnt;
+
+  iovcnt = 0;
+  QUEUE_FOREACH(q, &stream->write_queue) {
+    req = QUEUE_DATA(q, uv_write_t, queue);
+    if (req->send_handle != NULL && iovcnt != 0)
+      break;
+
+    for (i = req->write_index; i < req->nbufs && iovcnt < iovmax; i++) {
+      iov[iovcnt].iov_base = req->bufs[i].base;
+      iov[iovcnt].iov_len = req->bufs[i].len;
+      iovcnt++;
+    }
+
+    if (iovcnt == iovmax)
+      break;
+  }
+
+  return iovcnt;
+}
+
 static void uv__write(uv_stream_t* stream) {
+  struct iovec iovbuf[UV__WRITE_GATHER_MAX];
   struct iovec* iov;
   QUEUE* q;
   uv_write_t* req;
@@ -860,6 +969,16 @@ start:
   if (iovcnt > iovmax)
     iovcnt = iovmax;
 
+  /* More requests queued behind this one? Write them all in one go.
+   * Each request still completes (and gets its UV_WRITE_CB) on its own.
+   */
+  if (req->send_handle == NULL && QUEUE_NEXT(q) != &stream->write_queue) {
+    if (iovmax > UV__WRITE_GATHER_MAX)
+      iovmax = UV__WRITE_GATHER_MAX;
+    iov = iovbuf;
+    iovcnt = uv__write_gather(stream, iov, iovmax);
+  }
+
   /*
    * Now do the actual writev. Note that we've been updating the pointers
    * inside the iov each time we write. So there is no need to offset it.
@@ -957,8 +1076,14 @@ start:
     mylog(LOG_UV_STREAM, 1, "uv__write: Successful write!\n");
 
     while (n >= 0) {
-      uv_buf_t* buf = &(req->bufs[req->write_index]);
-      size_t len = buf->len;
+      uv_buf_t* buf;
+      size_t len;
+
+      /* n may span several gathered requests; walk them in queue order. */
+      q = QUEUE_HEAD(&stream->write_queue);
+      req = QUEUE_DATA(q, uv_write_t, queue);
+      buf = &(req->bufs[req->write_index]);
+      len = buf->len;
 
       assert(req->write_index < req->nbufs);
 
@@ -991,11 +1116,12 @@ start:
         stream->write_queue_size -= len;
 
         if (req->write_index == req->nbufs) {
-          /* Then we're done! */
-          assert(n == 0);
+          /* Then we're done with this request. */
           uv__write_req_finish(req);
-          /* TODO: start trying to write the next request. */
-          goto DONE;
+          if (n == 0)
+            goto DONE;
+          /* The rest of n belongs to the next gathered request. */
+          assert(!QUEUE_EMPTY(&stream->write_queue));
         }
       }
     }
@@ -1142,6 +1268,32 @@ static int uv__stream_queue_fd(uv_stream_t* stream, int fd) {
 }
 
 
+static int uv__stream_dequeue_fd(uv_stream_t* stream) {
+  uv__stream_queued_fds_t* queued_fds;
+  int fd;
+
+  queued_fds = stream->queued_fds;
+  assert(queued_fds != NULL);
+
+  /* Read first */
+  fd = queued_fds->fds[0];
+
+  /* All read, free */
+  assert(queued_fds->offset > 0);
+  if (--queued_fds->offset == 0) {
+    uv__free(queued_fds);
+    stream->queued_fds = NULL;
+  } else {
+    /* Shift rest */
+    memmove(queued_fds->fds,
+            queued_fds->fds + 1,
+            queued_fds->offset * sizeof(*queued_fds->fds));
+  }
+
+  return fd;
+}
+
+
 #define UV__CMSG_FD_COUNT 64
 #define UV__CMSG_FD_SIZE (UV__CMSG_FD_COUNT * sizeof(int))
 
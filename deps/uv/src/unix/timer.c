@@ -318,5 +318,12 @@ void uv__run_timers(uv_loop_t* loop) {
 }
 
 void uv__timer_close(uv_timer_t* handle) {
+  spd_looper_source_closed_t spd_looper_source_closed;
+
+  spd_looper_source_closed_init(&spd_looper_source_closed);
+  spd_looper_source_closed.timer = handle;
+  if (scheduler_is_initialized())
+    scheduler_thread_yield(SCHEDULE_POINT_LOOPER_SOURCE_CLOSED, &spd_looper_source_closed);
+
   uv_timer_stop(handle);
 }
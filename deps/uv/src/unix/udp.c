@@ -37,6 +37,9 @@
 # define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
 #endif
 
+/* Maximum number of queued datagrams handed to a single sendmmsg(). */
+#define UV__UDP_MMSG_MAX 32
+
 
 static void uv__udp_run_completed(uv_udp_t* handle);
 static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents);
@@ -238,12 +241,96 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
 }
 
 
+#if defined(__linux__)
+/* Drain the write queue with sendmmsg(), UV__UDP_MMSG_MAX datagrams at a time.
+ * Each request still lands on write_completed_queue individually, so
+ * uv__udp_run_completed invokes one UV_UDP_SEND_CB per request, in order.
+ * Returns -ENOSYS if the kernel lacks sendmmsg() and nothing was sent,
+ * in which case the caller falls back to sendmsg().
+ */
+static int uv__udp_sendmmsg(uv_udp_t* handle) {
+  struct uv__mmsghdr h[UV__UDP_MMSG_MAX];
+  uv_udp_send_t* req;
+  QUEUE* q;
+  unsigned int npkts;
+  unsigned int i;
+  int nsent;
+
+  while (!QUEUE_EMPTY(&handle->write_queue)) {
+    npkts = 0;
+    QUEUE_FOREACH(q, &handle->write_queue) {
+      if (npkts == ARRAY_SIZE(h))
+        break;
+
+      req = QUEUE_DATA(q, uv_udp_send_t, queue);
+      memset(&h[npkts], 0, sizeof h[npkts]);
+      h[npkts].msg_hdr.msg_name = &req->addr;
+      h[npkts].msg_hdr.msg_namelen = (req->addr.ss_family == AF_INET6 ?
+        sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in));
+      h[npkts].msg_hdr.msg_iov = (struct iovec*) req->bufs;
+      h[npkts].msg_hdr.msg_iovlen = req->nbufs;
+      npkts++;
+    }
+
+    do {
+      nsent = uv__sendmmsg(handle->io_watcher.fd, h, npkts, 0);
+    } while (nsent == -1 && errno == EINTR);
+
+    if (nsent == -1) {
+      if (errno == ENOSYS)
+        return -ENOSYS;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+
+      /* The error belongs to the first datagram; fail just that request,
+       * exactly as sendmsg() would have, and carry on with the rest.
+       */
+      req = QUEUE_DATA(QUEUE_HEAD(&handle->write_queue), uv_udp_send_t, queue);
+      req->status = -errno;
+      QUEUE_REMOVE(&req->queue);
+      QUEUE_INSERT_TAIL(&handle->write_completed_queue, &req->queue);
+      uv__io_feed(handle->loop, &handle->io_watcher);
+      continue;
+    }
+
+    mylog(LOG_MAIN, 7, "uv__udp_sendmmsg: sent %i/%u datagrams\n", nsent, npkts);
+
+    /* Datagrams are atomic, see uv__udp_sendmsg. */
+    for (i = 0; i < (unsigned int) nsent; i++) {
+      req = QUEUE_DATA(QUEUE_HEAD(&handle->write_queue), uv_udp_send_t, queue);
+      assert(h[i].msg_hdr.msg_iov == (struct iovec*) req->bufs);
+      req->status = h[i].msg_len;
+      QUEUE_REMOVE(&req->queue);
+      QUEUE_INSERT_TAIL(&handle->write_completed_queue, &req->queue);
+    }
+    uv__io_feed(handle->loop, &handle->io_watcher);
+
+    /* Short count: the socket buffer is full. Wait for the next POLLOUT. */
+    if ((unsigned int) nsent < npkts)
+      break;
+  }
+
+  return 0;
+}
+#endif
+
+
 static void uv__udp_sendmsg(uv_udp_t* handle) {
   uv_udp_send_t* req;
   QUEUE* q;
   struct msghdr h;
   ssize_t size;
 
+#if defined(__linux__)
+  static int no_sendmmsg;
+
+  if (!no_sendmmsg) {
+    if (uv__udp_sendmmsg(handle) == 0)
+      return;
+    no_sendmmsg = 1;
+  }
+#endif
+
   while (!QUEUE_EMPTY(&handle->write_queue)) {
     q = QUEUE_HEAD(&handle->write_queue);
     assert(q != NULL);
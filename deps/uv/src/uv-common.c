@@ -28,6 +28,9 @@
 #include "scheduler.h"
 #include "statistics.h"
 #include "runtime.h"
+#include "trace.h"
+#include "causal.h"
+#include "uv-probes.h"
 
 #if defined(ENABLE_SCHEDULER_VANILLA)
   #include "scheduler_Vanilla.h"
@@ -41,6 +44,14 @@
   #include "scheduler_TP_Freedom.h"
 #endif
 
+#if defined(ENABLE_SCHEDULER_PCT)
+  #include "scheduler_PCT.h"
+#endif
+
+#if defined(ENABLE_SCHEDULER_SYSTEMATIC)
+  #include "scheduler_Systematic.h"
+#endif
+
 #include <stdio.h>
 #include <assert.h>
 #include <stdarg.h>
@@ -898,6 +909,11 @@ void initialize_fuzzy_libuv (void)
   mylog_set_verbosity(LOG_UV_IO, 9);
   mylog_set_verbosity(LOG_UV_ASYNC, 9);
   mylog_set_verbosity(LOG_STATISTICS, 9);
+  mylog_set_verbosity(LOG_NODE, runtime_node_log_verbosity());
+
+  /* CB timeline and causal log. Before the scheduler, which names the threads. */
+  trace_init();
+  causal_init();
 
 #ifdef JD_UT
   mylog(LOG_MAIN, 1, "initialize_fuzzy_libuv: Running unit tests\n");
@@ -933,7 +949,7 @@ void initialize_fuzzy_libuv (void)
  *    Environment variable            Details                                   Notes
  * ---------------------------------------------------------------------------------------------------
  *     UV_SCHEDULER_TYPE           Changes the scheduler type.                  Default is VANILLA.
- *                                 Choose from: VANILLA, FUZZING_TIME, TP_FREEDOM.
+ *                                 Choose from: VANILLA, FUZZING_TIME, TP_FREEDOM, PCT, SYSTEMATIC.
  *                                 Each scheduler is parameterized using environment variables.
  *
  *                                 VANILLA                                      Schedule is inviolate. As natural as possible.
@@ -986,8 +1002,48 @@ void initialize_fuzzy_libuv (void)
  *                                                                              This means we'll probabilistically break out of timer execution and proceed through the event loop.
  *                                                                              We defer every timer after the first deferred one to ensure no additional shuffling beyond UV_SCHEDULER_TIMER_DEG_FREEDOM.
  *                                                                              Default is 0: never execute timers late.
+ *                                     [UV_SCHEDULER_TP_ADAPTIVE_OVERHEAD_PERC] Adaptive mode. Target for the time the TP spends waiting for its queue to fill, as a percentage of run time.
+ *                                                                              Every 100 ms we re-tune UV_SCHEDULER_TP_MAX_DELAY, UV_SCHEDULER_IOPOLL_DEFER_PERC, UV_SCHEDULER_RUN_CLOSING_DEFER_PERC,
+ *                                                                              UV_SCHEDULER_TIMER_EARLY_EXEC_TPERC and UV_SCHEDULER_TIMER_LATE_EXEC_TPERC to meet it,
+ *                                                                              using the values given as upper bounds.
+ *                                                                              We favor delays and deferrals that give the scheduler more than one candidate to choose from.
+ *                                                                              Default is 0: use the parameters as given.
+ *                                     [UV_SCHEDULER_INLINE_DEFER_PERC]         Percentage of the small work items an embedder offers to run on the looper
+ *                                                                              (uv_work_should_inline) that we send to the TP anyway.
+ *                                                                              Default is 10. The other schedulers run all of them inline; SYSTEMATIC explores both.
+ *                                     UV_THREADPOOL_SIZE                       Must be 1
+ *
+ *                                 PCT                                          Probabilistic Concurrency Testing. Each event source (TP work item, fd, timer) gets a random priority,
+ *                                                                              and wherever there is a choice the highest priority goes first. At UV_SCHEDULER_PCT_DEPTH-1
+ *                                                                              random CB counts, the source that last went first drops below all others.
+ *                                                                              Finds a depth-d ordering bug in one run with probability at least 1/(n*k^(d-1)), n sources, k CBs.
+ *                                  Parameters
+ *                                     [UV_SCHEDULER_PCT_DEPTH]                 Bug depth d. Default 3.
+ *                                     [UV_SCHEDULER_PCT_MAX_CBS]               Estimate of k, the number of CBs in a run. Change points are drawn from [1, k]. Default 10000.
+ *                                     [UV_SCHEDULER_TP_DEG_FREEDOM]            As for TP_FREEDOM. Default -1.
+ *                                     [UV_SCHEDULER_TP_MAX_DELAY]              As for TP_FREEDOM. Default 0: take work as soon as there is any.
+ *                                     [UV_SCHEDULER_IOPOLL_DEG_FREEDOM]        As for TP_FREEDOM. Default -1. PCT never defers events.
+ *                                     [UV_SCHEDULER_TIMER_DEG_FREEDOM]         As for TP_FREEDOM, with the same warning. Default 1.
+ *                                     UV_THREADPOOL_SIZE                       Must be 1
+ *
+ *                                 SYSTEMATIC                                   Bounded depth-first exploration of the decision vectors, one vector per run.
+ *                                                                              A decision is a schedule point with more than one candidate: the TP work item,
+ *                                                                              the done item, the epoll event order, deferring closing handles, and running work inline.
+ *                                                                              At exit, a run writes the next unexplored vector to the frontier file, or "done".
+ *                                                                              Run the program repeatedly (one at a time, or under the fork server) until it says "done".
+ *                                                                              A run also journals its decisions to "<frontier file>.journal" as it makes them.
+ *                                                                              If it dies before exit, the next run reads the journal and moves the frontier past it.
+ *                                  Parameters
+ *                                     UV_SCHEDULER_SYSTEMATIC_FRONTIER_FILE    Where the next decision vector is kept between runs. Remove it to start over.
+ *                                     [UV_SCHEDULER_SYSTEMATIC_MAX_DECISIONS]  Bound on the search depth, per thread (looper, TP). Later decisions take the default. Default 64.
+ *                                     [UV_SCHEDULER_SYSTEMATIC_IOPOLL_WINDOW]  Each epoll event in turn may be swapped with one of the next k. 0 means "don't reorder". Default 1.
+ *                                     [UV_SCHEDULER_SYSTEMATIC_CLOSING_DEFERS] Whether deferring the closing handles is a decision. Give 0 or 1. Default 1.
+ *                                     [UV_SCHEDULER_TP_DEG_FREEDOM]            As for TP_FREEDOM. Default -1.
+ *                                     [UV_SCHEDULER_TP_MAX_DELAY]              As for TP_FREEDOM. Default 0: take work as soon as there is any.
  *                                     UV_THREADPOOL_SIZE                       Must be 1
  *
+ *     [UV_SCHEDULER_SEED]         Seed for the scheduler's RNG.                Default is the clock. Fix it to compare runs, e.g. in benchmark-matrix.sh.
+ *
  *     UV_SCHEDULER_MODE           Choose from: RECORD[, REPLAY]                Defaults to RECORD
  *
  *     UV_SCHEDULER_SCHEDULE_FILE  Where to emit or load schedule               Defaults to /tmp/libuv_<pid>.sched
@@ -995,12 +1051,37 @@ void initialize_fuzzy_libuv (void)
  *                                                                                       so in this case specifying UV_SCHEDULER_SCHEDULE_FILE will produce a garbled file.
  *                                                                                       It's safer to rely on the default behavior unless you're confident about the behavior of the application.
  *
+ *     [UV_SCHEDULER_UNSERIALIZED_CBS]  Comma-separated CB types to run         Default UV__WORK_WORK,UV_WORK_CB,UV_FS_WORK_CB,UV_GETADDRINFO_WORK_CB,UV_GETNAMEINFO_WORK_CB
+ *                                      outside the loop's CB lock.             (the TP's work, which never enters JS). Give NONE to serialize every CB.
+ *                                                                              Unserializing a type only helps if the types it is nested in are unserialized too.
+ *                                                                              See scheduler_set_cb_serialized.
+ *
  *  General runtime parameters are described below.
  *    Environment variable            Details                                   Notes
  * ---------------------------------------------------------------------------------------------------
  *    [UV_THREADPOOL_SIZE]              How many threads in the threadpool?     Default 4.
  *    [UV_SILENT]                       Whether to print anything.              Default 0 (not silent). Give 0 or 1.
  *    [UV_PRINT_SUMMARY]                Whether to print summary (overrides UV_SILENT=1).
+ *    [UV_ACCEPT_BATCH_SIZE]            Max. connections a server accepts       Default 1 (one accept per wakeup). Capped at 64.
+ *                                      per wakeup.                             A batch is offered to the scheduler at SCHEDULE_POINT_LOOPER_ACCEPT
+ *                                                                              before its UV_CONNECTION_CBs are invoked.
+ *    [UV_FORK_SERVER_FD]               Control fd of a fork-server driver;     Default unset. See src/unix/fork-server.c for the protocol.
+ *                                      status fd is UV_FORK_SERVER_FD+1.       Only honored in RECORD mode by uv_fork_server().
+ *    [UV_SCHEDULE_BITMAP_SHM]          POSIX shm object (e.g. /nodefz-cov)     Default unset (private bitmap). Created and sized if missing.
+ *                                      for the schedule coverage bitmap.       Leave it uncleared across runs to measure novelty.
+ *    [UV_SCHEDULE_FINGERPRINT_FILE]    At exit, append a line                  Default unset. See scheduler_schedule_hash.
+ *                                      "<fingerprint> <n_executed> <new_edges>".
+ *    [UV_TRACE_FILE]                   Stream a CB timeline here, in Chrome's  Default unset (no tracing). See src/trace.h.
+ *                                      Trace Event Format (chrome://tracing,   Fork-server children write <UV_TRACE_FILE>.<pid>.
+ *                                      ui.perfetto.dev).
+ *    [UV_TRACE_BUFFER_KB]              Trace file buffer. Bounds the events    Default 64. 0 means unbuffered.
+ *                                      lost if we die without atexit.
+ *    [UV_TRACE_MAX_MB]                 Stop tracing at this file size.         Default 256.
+ *    [UV_CAUSAL_FILE]                  Write a binary log of which embedder    Default unset (no log). See src/causal.h.
+ *                                      resource each CB serves, embedder       Buffer and cap as for UV_TRACE_FILE.
+ *                                      phases, and scheduler decisions.        Fork-server children write <UV_CAUSAL_FILE>.<pid>.
+ *    [UV_LOG_NODE_VERBOSITY]           Verbosity of the embedder's log         Default 0 (quiet). Node logs its startup at 1, loop turns at 5,
+ *                                      (uv_log, log class LOG_NODE).           and each nextTick, microtask and setImmediate pass at 7.
  */
 static void initialize_scheduler (void)
 {
@@ -1009,15 +1090,22 @@ static void initialize_scheduler (void)
   scheduler_type_t scheduler_type;
   scheduler_mode_t scheduler_mode;
   struct stat stat_buf;
+  char *unserialized_cbsP = NULL, *cb_typeP = NULL;
+  char unserialized_cbs[1024];
+  int cb_type;
 
   scheduler_vanilla_args_t vanilla_args;
   scheduler_fuzzing_timer_args_t fuzzing_timer_args;
   scheduler_tp_freedom_args_t tp_freedom_args;
+  scheduler_pct_args_t pct_args;
+  scheduler_systematic_args_t systematic_args;
   void *args;
 
   memset(&vanilla_args, 0, sizeof vanilla_args);
   memset(&fuzzing_timer_args, 0, sizeof fuzzing_timer_args);
   memset(&tp_freedom_args, 0, sizeof tp_freedom_args);
+  memset(&pct_args, 0, sizeof pct_args);
+  memset(&systematic_args, 0, sizeof systematic_args);
 
   /* Scheduler type. */
   scheduler_typeP = getenv("UV_SCHEDULER_TYPE");
@@ -1052,10 +1140,14 @@ static void initialize_scheduler (void)
          *scheduler_iopoll_deg_freedomP = NULL, *scheduler_iopoll_defer_percP = NULL,
          *scheduler_run_closing_defer_percP = NULL, 
          *scheduler_timer_deg_freedomP = NULL, *scheduler_timer_early_exec_tpercP = NULL, *scheduler_timer_max_early_multipleP = NULL, *scheduler_timer_late_exec_tpercP = NULL, 
+         *scheduler_tp_adaptive_overhead_percP = NULL,
+         *scheduler_inline_defer_percP = NULL,
          *tp_sizeP = NULL;
 
     /* Defaults. */
     int scheduler_timer_deg_freedom = 1, scheduler_timer_early_exec_tperc = 0, scheduler_timer_max_early_multiple = 1, scheduler_timer_late_exec_tperc = 0;
+    int scheduler_tp_adaptive_overhead_perc = 0;
+    int scheduler_inline_defer_perc = 10;
 
     scheduler_type = SCHEDULER_TYPE_TP_FREEDOM;
 
@@ -1099,6 +1191,14 @@ static void initialize_scheduler (void)
     if (scheduler_timer_late_exec_tpercP != NULL)
       scheduler_timer_late_exec_tperc = atoi(scheduler_timer_late_exec_tpercP);
 
+    scheduler_tp_adaptive_overhead_percP = getenv("UV_SCHEDULER_TP_ADAPTIVE_OVERHEAD_PERC");
+    if (scheduler_tp_adaptive_overhead_percP != NULL)
+      scheduler_tp_adaptive_overhead_perc = atoi(scheduler_tp_adaptive_overhead_percP);
+
+    scheduler_inline_defer_percP = getenv("UV_SCHEDULER_INLINE_DEFER_PERC");
+    if (scheduler_inline_defer_percP != NULL)
+      scheduler_inline_defer_perc = atoi(scheduler_inline_defer_percP);
+
     tp_sizeP = getenv("UV_THREADPOOL_SIZE");
     if (tp_sizeP == NULL || atoi(tp_sizeP) != 1)
       assert(!"Error, for scheduler TP_FREEDOM, you must provide UV_THREADPOOL_SIZE=1");
@@ -1113,8 +1213,79 @@ static void initialize_scheduler (void)
     tp_freedom_args.timer_early_exec_tperc = scheduler_timer_early_exec_tperc;
     tp_freedom_args.timer_max_early_multiple = scheduler_timer_max_early_multiple;
     tp_freedom_args.timer_late_exec_tperc = scheduler_timer_late_exec_tperc;
+    tp_freedom_args.adaptive_overhead_perc = scheduler_tp_adaptive_overhead_perc;
+    tp_freedom_args.inline_defer_perc = scheduler_inline_defer_perc;
     args = &tp_freedom_args;
   }
+  else if (strcmp(scheduler_typeP, "PCT") == 0)
+  {
+    char *tp_sizeP = NULL, *valP = NULL;
+
+    scheduler_type = SCHEDULER_TYPE_PCT;
+
+    /* Defaults. */
+    pct_args.depth = 3;
+    pct_args.max_cbs = 10000;
+    pct_args.tp_degrees_of_freedom = -1;
+    pct_args.tp_max_delay_us = 0;
+    pct_args.iopoll_degrees_of_freedom = -1;
+    pct_args.timer_degrees_of_freedom = 1;
+
+    if ((valP = getenv("UV_SCHEDULER_PCT_DEPTH")) != NULL)
+      pct_args.depth = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_PCT_MAX_CBS")) != NULL)
+      pct_args.max_cbs = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_TP_DEG_FREEDOM")) != NULL)
+      pct_args.tp_degrees_of_freedom = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_TP_MAX_DELAY")) != NULL)
+      pct_args.tp_max_delay_us = atol(valP);
+    if ((valP = getenv("UV_SCHEDULER_IOPOLL_DEG_FREEDOM")) != NULL)
+      pct_args.iopoll_degrees_of_freedom = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_TIMER_DEG_FREEDOM")) != NULL)
+      pct_args.timer_degrees_of_freedom = atoi(valP);
+
+    tp_sizeP = getenv("UV_THREADPOOL_SIZE");
+    if (tp_sizeP == NULL || atoi(tp_sizeP) != 1)
+      assert(!"Error, for scheduler PCT, you must provide UV_THREADPOOL_SIZE=1");
+
+    args = &pct_args;
+  }
+  else if (strcmp(scheduler_typeP, "SYSTEMATIC") == 0)
+  {
+    char *tp_sizeP = NULL, *valP = NULL;
+
+    scheduler_type = SCHEDULER_TYPE_SYSTEMATIC;
+
+    /* Defaults. */
+    systematic_args.max_decisions = 64;
+    systematic_args.iopoll_window = 1;
+    systematic_args.closing_defers = 1;
+    systematic_args.tp_degrees_of_freedom = -1;
+    systematic_args.tp_max_delay_us = 0;
+
+    valP = getenv("UV_SCHEDULER_SYSTEMATIC_FRONTIER_FILE");
+    if (valP == NULL || valP[0] == '\0')
+      assert(!"Error, for scheduler SYSTEMATIC, you must provide UV_SCHEDULER_SYSTEMATIC_FRONTIER_FILE");
+    assert(strlen(valP) < sizeof systematic_args.frontier_file);
+    strcpy(systematic_args.frontier_file, valP);
+
+    if ((valP = getenv("UV_SCHEDULER_SYSTEMATIC_MAX_DECISIONS")) != NULL)
+      systematic_args.max_decisions = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_SYSTEMATIC_IOPOLL_WINDOW")) != NULL)
+      systematic_args.iopoll_window = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_SYSTEMATIC_CLOSING_DEFERS")) != NULL)
+      systematic_args.closing_defers = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_TP_DEG_FREEDOM")) != NULL)
+      systematic_args.tp_degrees_of_freedom = atoi(valP);
+    if ((valP = getenv("UV_SCHEDULER_TP_MAX_DELAY")) != NULL)
+      systematic_args.tp_max_delay_us = atol(valP);
+
+    tp_sizeP = getenv("UV_THREADPOOL_SIZE");
+    if (tp_sizeP == NULL || atoi(tp_sizeP) != 1)
+      assert(!"Error, for scheduler SYSTEMATIC, you must provide UV_THREADPOOL_SIZE=1");
+
+    args = &systematic_args;
+  }
   else
     assert(!"Error, unsupported UV_SCHEDULER_TYPE");
 
@@ -1141,6 +1312,28 @@ static void initialize_scheduler (void)
 
   mylog(LOG_MAIN, 1, "scheduler_type %s scheduler_mode %s schedule_file %s\n", scheduler_type_to_string(scheduler_type), scheduler_mode_to_string(scheduler_mode), schedule_fileP);
   scheduler_init(scheduler_type, scheduler_mode, schedule_fileP, args);
+
+  /* CB serialization policy. The list replaces the default. */
+  unserialized_cbsP = getenv("UV_SCHEDULER_UNSERIALIZED_CBS");
+  if (unserialized_cbsP != NULL)
+  {
+    if (sizeof unserialized_cbs <= strlen(unserialized_cbsP))
+      assert(!"Error, UV_SCHEDULER_UNSERIALIZED_CBS is too long");
+    strcpy(unserialized_cbs, unserialized_cbsP);
+
+    for (cb_type = UV_ALLOC_CB; cb_type <= UV__WORK_DONE; cb_type++)
+      scheduler_set_cb_serialized(cb_type, 1);
+    if (strcmp(unserialized_cbs, "NONE") != 0)
+    {
+      for (cb_typeP = strtok(unserialized_cbs, ","); cb_typeP != NULL; cb_typeP = strtok(NULL, ","))
+      {
+        cb_type = callback_type_from_string(cb_typeP);
+        if (UV__WORK_DONE < cb_type)
+          assert(!"Error, UV_SCHEDULER_UNSERIALIZED_CBS may only name CB types (UV_ALLOC_CB through UV__WORK_DONE)");
+        scheduler_set_cb_serialized(cb_type, 0);
+      }
+    }
+  }
 }
 
 /* Returns time in microseconds (us) relative to the time at which the first CB was invoked. */
@@ -1226,6 +1419,8 @@ void invoke_callback_wrap (any_func cb, enum callback_type type, ...)
   int i, nargs;
   va_list ap;
   callback_info_t *cbi = NULL;
+  callback_info_t wrapper_cbi;
+  int is_wrapper;
 
   /* Scheduler supplies. */
   spd_before_exec_cb_t spd_before_exec_cb;
@@ -1233,9 +1428,13 @@ void invoke_callback_wrap (any_func cb, enum callback_type type, ...)
 
   assert(UV_ALLOC_CB <= type && type <= UV__WORK_DONE);
   nargs = callback_type_to_nargs[type];
+  is_wrapper = is_wrapper_cb(type);
 
   /* Prep a CBI with args. */
-  cbi = (callback_info_t *) uv__malloc(sizeof *cbi);
+  if (is_wrapper)
+    cbi = &wrapper_cbi;
+  else
+    cbi = (callback_info_t *) uv__malloc(sizeof *cbi);
   assert(cbi);
   memset(cbi, 0, sizeof(*cbi));                   
   cbi->type = type;                           
@@ -1246,20 +1445,33 @@ void invoke_callback_wrap (any_func cb, enum callback_type type, ...)
     cbi->args[i] = va_arg(ap, long);
   va_end(ap);
 
+  /* Plumbing: pass straight through. The CBs it wraps get the full treatment. */
+  if (is_wrapper)
+  {
+    cbi_execute_callback(cbi);
+    return;
+  }
+
   /* Yield to scheduler (and, if scheduler desires, serialize CBs). */
   spd_before_exec_cb_init(&spd_before_exec_cb);
   spd_before_exec_cb.cb_type = type;
   spd_before_exec_cb.lcbn = NULL; /* TODO Change this. */
   scheduler_thread_yield(SCHEDULE_POINT_BEFORE_EXEC_CB, &spd_before_exec_cb);
 
-  /* User code or not, run the callback. */
+  /* User code or not, run the callback. The first arg is the handle or req, if any. */
   mylog(LOG_MAIN, 7, "invoke_callback_wrap: Invoking cbi %p (type %s)\n", cbi, callback_type_to_string(cbi->type));
+  trace_begin(callback_type_to_string(type), "cb", 0 < nargs ? (void *) cbi->args[0] : NULL);
+  causal_record(CAUSAL_CB_BEGIN, type, 0 < nargs ? (void *) cbi->args[0] : NULL, 0);
+  UV_CALLBACK_START((int) type, 0 < nargs ? (void *) cbi->args[0] : NULL);
   cbi_execute_callback(cbi); 
+  UV_CALLBACK_DONE((int) type);
+  causal_record(CAUSAL_CB_END, type, 0 < nargs ? (void *) cbi->args[0] : NULL, 0);
+  trace_end(callback_type_to_string(type), "cb");
   mylog(LOG_MAIN, 7, "invoke_callback_wrap: Done invoking cbi %p (type %s)\n", cbi, callback_type_to_string(cbi->type));
   statistics_record(STATISTIC_CB_EXECUTED, 1);
 
   /* Yield to scheduler. */
-  assert(scheduler_current_cb_thread() == uv_thread_self()); /* Only fails if threadpool.c:cleanup ever happens and returns from the CB. */
+  assert(!scheduler_cb_is_serialized(type) || scheduler_current_cb_thread() == uv_thread_self()); /* Only fails if threadpool.c:cleanup ever happens and returns from the CB. */
   spd_after_exec_cb_init(&spd_after_exec_cb);
   spd_after_exec_cb.cb_type = type;
   spd_after_exec_cb.lcbn = NULL; /* TODO Change this. */
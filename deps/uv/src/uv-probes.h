@@ -0,0 +1,42 @@
+#ifndef UV_SRC_UV_PROBES_H_
+#define UV_SRC_UV_PROBES_H_
+
+/* USDT probes of provider "uv", declared in src/unix/uv-dtrace.d.
+ *
+ * Built when uv_use_dtrace is "true" (./configure --with-dtrace), from the header that
+ * dtrace -h generates. On Linux that is SystemTap's dtrace, so the probes are also visible
+ * to bpftrace, e.g.
+ *   bpftrace -e 'usdt:./node:uv:callback__start { @[arg0] = count(); }'
+ * A probe that is not enabled costs a nop. Guard costly arguments with UV_*_ENABLED().
+ *
+ * Otherwise the probes compile away.
+ */
+
+#if defined(HAVE_DTRACE)
+
+#include "uv-dtrace.h"
+
+#else
+
+#define UV_SCHEDULE_POINT_ENTRY(arg0)
+#define UV_SCHEDULE_POINT_ENTRY_ENABLED() (0)
+#define UV_SCHEDULE_POINT_RETURN(arg0, arg1)
+#define UV_SCHEDULE_POINT_RETURN_ENABLED() (0)
+#define UV_CALLBACK_START(arg0, arg1)
+#define UV_CALLBACK_START_ENABLED() (0)
+#define UV_CALLBACK_DONE(arg0)
+#define UV_CALLBACK_DONE_ENABLED() (0)
+#define UV_TP_GET(arg0, arg1)
+#define UV_TP_GET_ENABLED() (0)
+#define UV_TP_PUT(arg0)
+#define UV_TP_PUT_ENABLED() (0)
+#define UV_EPOLL_EVENTS(arg0, arg1)
+#define UV_EPOLL_EVENTS_ENABLED() (0)
+#define UV_TIMER_READY(arg0, arg1, arg2)
+#define UV_TIMER_READY_ENABLED() (0)
+#define UV_TIMER_RUN(arg0, arg1)
+#define UV_TIMER_RUN_ENABLED() (0)
+
+#endif  /* HAVE_DTRACE */
+
+#endif  /* UV_SRC_UV_PROBES_H_ */
@@ -2106,6 +2106,13 @@ int uv_fs_fchown(uv_loop_t* loop, uv_fs_t* req, uv_file fd, uv_uid_t uid,
 }
 
 
+int uv_fs_readfile(uv_loop_t* loop, uv_fs_t* req, const char* path,
+    int flags, int mode, size_t max_size, uv_fs_cb cb) {
+  /* Not implemented. Callers fall back to open, fstat, read and close. */
+  return UV_ENOSYS;
+}
+
+
 int uv_fs_stat(uv_loop_t* loop, uv_fs_t* req, const char* path, uv_fs_cb cb) {
   int err;
 
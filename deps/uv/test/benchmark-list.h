@@ -75,6 +75,9 @@ BENCHMARK_DECLARE (spawn)
 BENCHMARK_DECLARE (thread_create)
 BENCHMARK_DECLARE (million_async)
 BENCHMARK_DECLARE (million_timers)
+BENCHMARK_DECLARE (sched_yield)
+BENCHMARK_DECLARE (sched_cb_dispatch)
+BENCHMARK_DECLARE (sched_work_latency)
 HELPER_DECLARE    (tcp4_blackhole_server)
 HELPER_DECLARE    (tcp_pump_server)
 HELPER_DECLARE    (pipe_pump_server)
@@ -160,4 +163,8 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (thread_create)
   BENCHMARK_ENTRY  (million_async)
   BENCHMARK_ENTRY  (million_timers)
+
+  BENCHMARK_ENTRY  (sched_yield)
+  BENCHMARK_ENTRY  (sched_cb_dispatch)
+  BENCHMARK_ENTRY  (sched_work_latency)
 TASK_LIST_END
@@ -0,0 +1,190 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Overhead of the scheduler, under whatever UV_SCHEDULER_TYPE is set.
+ * benchmark-matrix.sh runs these under each scheduler with fixed seeds.
+ *
+ * Each benchmark prints one line of key=value pairs:
+ *   <name>: scheduler=<type> ops=<n> ns_per_op=<mean> [more keys]
+ */
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_TURNS (200 * 1000)
+#define NUM_IDLE_HANDLES 100
+#define NUM_DISPATCHES (1000 * 1000)
+#define NUM_WORK_REQS (10 * 1000)
+
+static uv_timer_t keepalive_handle;
+static uv_idle_t idle_handles[NUM_IDLE_HANDLES];
+static unsigned long dispatches;
+static uv_work_t work_req;
+static unsigned long work_done;
+static uint64_t work_submitted_at;
+static uint64_t work_latency[NUM_WORK_REQS];
+
+
+static const char* scheduler_type(void) {
+  const char* type = getenv("UV_SCHEDULER_TYPE");
+  return type != NULL ? type : "VANILLA";
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  ASSERT(0 && "should not be called");
+}
+
+
+/* A turn of the loop with nothing to do. It still passes the looper's
+ * schedule points (timers, epoll, closing handles), so this is the cost of
+ * yielding to the scheduler without running a CB.
+ */
+BENCHMARK_IMPL(sched_yield) {
+  uv_loop_t* loop = uv_default_loop();
+  uint64_t ns;
+  int i;
+
+  /* Keep the loop alive. */
+  ASSERT(0 == uv_timer_init(loop, &keepalive_handle));
+  ASSERT(0 == uv_timer_start(&keepalive_handle, timer_cb, 3600 * 1000, 0));
+
+  ns = uv_hrtime();
+  for (i = 0; i < NUM_TURNS; i++)
+    uv_run(loop, UV_RUN_NOWAIT);
+  ns = uv_hrtime() - ns;
+
+  uv_close((uv_handle_t*) &keepalive_handle, close_cb);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  fprintf(stderr, "sched_yield: scheduler=%s ops=%d ns_per_op=%.1f\n",
+          scheduler_type(),
+          NUM_TURNS,
+          (double) ns / NUM_TURNS);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void idle_cb(uv_idle_t* handle) {
+  if (++dispatches == NUM_DISPATCHES)
+    uv_stop(handle->loop);
+}
+
+
+/* Many handles per turn, so this is dominated by the cost of invoking a CB:
+ * the BEFORE/AFTER_EXEC_CB schedule points and the CB lock.
+ */
+BENCHMARK_IMPL(sched_cb_dispatch) {
+  uv_loop_t* loop = uv_default_loop();
+  uint64_t ns;
+  int i;
+
+  for (i = 0; i < NUM_IDLE_HANDLES; i++) {
+    ASSERT(0 == uv_idle_init(loop, &idle_handles[i]));
+    ASSERT(0 == uv_idle_start(&idle_handles[i], idle_cb));
+  }
+
+  ns = uv_hrtime();
+  uv_run(loop, UV_RUN_DEFAULT);
+  ns = uv_hrtime() - ns;
+
+  /* uv_stop takes effect at the end of the turn. */
+  ASSERT(dispatches >= NUM_DISPATCHES);
+
+  for (i = 0; i < NUM_IDLE_HANDLES; i++)
+    uv_close((uv_handle_t*) &idle_handles[i], close_cb);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  fprintf(stderr, "sched_cb_dispatch: scheduler=%s ops=%lu ns_per_op=%.1f\n",
+          scheduler_type(),
+          dispatches,
+          (double) ns / dispatches);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void work_cb(uv_work_t* req) {
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  work_latency[work_done++] = uv_hrtime() - work_submitted_at;
+
+  if (work_done < NUM_WORK_REQS) {
+    work_submitted_at = uv_hrtime();
+    ASSERT(0 == uv_queue_work(req->loop, req, work_cb, after_work_cb));
+  }
+}
+
+
+static int compare_latency(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*) a;
+  uint64_t y = *(const uint64_t*) b;
+  return x < y ? -1 : x > y;
+}
+
+
+/* One work item in flight at a time, so each sample is the full trip
+ * through the threadpool's schedule points and back to the looper.
+ */
+BENCHMARK_IMPL(sched_work_latency) {
+  uv_loop_t* loop = uv_default_loop();
+  uint64_t total;
+  int i;
+
+  work_submitted_at = uv_hrtime();
+  ASSERT(0 == uv_queue_work(loop, &work_req, work_cb, after_work_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(work_done == NUM_WORK_REQS);
+
+  total = 0;
+  for (i = 0; i < NUM_WORK_REQS; i++)
+    total += work_latency[i];
+  qsort(work_latency, NUM_WORK_REQS, sizeof work_latency[0], compare_latency);
+
+  fprintf(stderr,
+          "sched_work_latency: scheduler=%s ops=%d ns_per_op=%.1f "
+          "p50_ns=%lu p99_ns=%lu max_ns=%lu\n",
+          scheduler_type(),
+          NUM_WORK_REQS,
+          (double) total / NUM_WORK_REQS,
+          (unsigned long) work_latency[NUM_WORK_REQS / 2],
+          (unsigned long) work_latency[NUM_WORK_REQS * 99 / 100],
+          (unsigned long) work_latency[NUM_WORK_REQS - 1]);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
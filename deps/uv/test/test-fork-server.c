@@ -0,0 +1,158 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#if defined(__linux__)
+
+#include "uv.h"
+#include "task.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* AFL's fds. The status fd is CTL_FD + 1. */
+#define CTL_FD 198
+#define ST_FD (CTL_FD + 1)
+#define NUM_TIMERS 4
+
+static uv_timer_t timers[NUM_TIMERS];
+static int timer_cb_called;
+
+
+static void timer_cb(uv_timer_t* handle) {
+  timer_cb_called++;
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+/* One run of the program, in a child of the server. */
+static void run_child(uv_loop_t* loop) {
+  int i;
+
+  for (i = 0; i < NUM_TIMERS; i++) {
+    ASSERT(0 == uv_timer_init(loop, &timers[i]));
+    ASSERT(0 == uv_timer_start(&timers[i], timer_cb, 0, 0));
+  }
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(timer_cb_called == NUM_TIMERS);
+
+  /* The server collects the schedule hash at exit. */
+  exit(0);
+}
+
+
+static void run_server(int ctl_fd, int st_fd) {
+  uv_loop_t* loop;
+
+  ASSERT(CTL_FD == dup2(ctl_fd, CTL_FD));
+  ASSERT(ST_FD == dup2(st_fd, ST_FD));
+  ASSERT(0 == close(ctl_fd));
+  ASSERT(0 == close(st_fd));
+  ASSERT(0 == setenv("UV_FORK_SERVER_FD", "198", 1));
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  /* Returns only in the children. The server _exit()s when we close ctl. */
+  ASSERT(0 == uv_fork_server(loop));
+  ASSERT(getenv("UV_FORK_SERVER_FD") == NULL);
+  run_child(loop);
+}
+
+
+static void read_all(int fd, void* buf, size_t len) {
+  ssize_t n;
+
+  do
+    n = read(fd, buf, len);
+  while (n == -1 && errno == EINTR);
+  ASSERT(n == (ssize_t) len);
+}
+
+
+/* Request a run with SEED and return its schedule hash. */
+static uint64_t drive(int ctl_fd, int st_fd, uint32_t seed) {
+  int32_t pid;
+  int32_t status;
+  uint64_t hash;
+
+  ASSERT(sizeof(seed) == write(ctl_fd, &seed, sizeof(seed)));
+
+  read_all(st_fd, &pid, sizeof(pid));
+  ASSERT(pid > 0);
+  read_all(st_fd, &status, sizeof(status));
+  ASSERT(WIFEXITED(status));
+  ASSERT(WEXITSTATUS(status) == 0);
+  read_all(st_fd, &hash, sizeof(hash));
+  ASSERT(hash != 0);
+
+  return hash;
+}
+
+
+TEST_IMPL(fork_server) {
+  int ctl[2];
+  int st[2];
+  int32_t msg;
+  uint64_t hash1;
+  uint64_t hash2;
+  int status;
+  pid_t pid;
+
+  ASSERT(0 == pipe(ctl));
+  ASSERT(0 == pipe(st));
+
+  pid = fork();
+  ASSERT(pid != -1);
+  if (pid == 0) {
+    close(ctl[1]);
+    close(st[0]);
+    run_server(ctl[0], st[1]);
+  }
+
+  close(ctl[0]);
+  close(st[1]);
+
+  read_all(st[0], &msg, sizeof(msg));
+  ASSERT(msg == 0);
+
+  /* Same program, same seed, same schedule. */
+  hash1 = drive(ctl[1], st[0], 1);
+  hash2 = drive(ctl[1], st[0], 2);
+  ASSERT(hash1 == drive(ctl[1], st[0], 1));
+  ASSERT(hash2 == drive(ctl[1], st[0], 2));
+
+  /* EOF stops the server. */
+  close(ctl[1]);
+  ASSERT(pid == waitpid(pid, &status, 0));
+  ASSERT(WIFEXITED(status));
+  ASSERT(WEXITSTATUS(status) == 0);
+  close(st[0]);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif /* defined(__linux__) */
@@ -1565,6 +1565,79 @@ TEST_IMPL(fs_readlink) {
 }
 
 
+TEST_IMPL(fs_readfile) {
+  static char big[100 * 1024];
+  uv_fs_t req;
+  int fd;
+  size_t i;
+
+  for (i = 0; i < sizeof(big); i++)
+    big[i] = 'a' + i % 26;
+
+  unlink("test_file");
+  fd = open("test_file", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ASSERT(fd >= 0);
+  ASSERT((ssize_t) sizeof(big) == write(fd, big, sizeof(big)));
+  close(fd);
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_fs_readfile(loop, &req, "test_file", O_RDONLY, 0, sizeof(big),
+                             dummy_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(dummy_cb_count == 1);
+  ASSERT(req.fs_type == UV_FS_READFILE);
+  ASSERT(req.result == (ssize_t) sizeof(big));
+  ASSERT(0 == memcmp(req.ptr, big, sizeof(big)));
+  uv_fs_req_cleanup(&req);
+
+  ASSERT((int) sizeof(big) ==
+         uv_fs_readfile(NULL, &req, "test_file", O_RDONLY, 0, sizeof(big),
+                        NULL));
+  ASSERT(0 == memcmp(req.ptr, big, sizeof(big)));
+  ASSERT(req.statbuf.st_size == sizeof(big));
+  uv_fs_req_cleanup(&req);
+
+  ASSERT(UV_EFBIG == uv_fs_readfile(NULL, &req, "test_file", O_RDONLY, 0,
+                                    sizeof(big) - 1, NULL));
+  ASSERT(req.ptr == NULL);
+  ASSERT(req.statbuf.st_size == sizeof(big));
+  uv_fs_req_cleanup(&req);
+
+  /* Empty files, and files whose st_size is 0 but that have data. */
+  fd = open("test_file", O_WRONLY | O_TRUNC);
+  ASSERT(fd >= 0);
+  close(fd);
+  ASSERT(0 == uv_fs_readfile(NULL, &req, "test_file", O_RDONLY, 0, sizeof(big),
+                             NULL));
+  uv_fs_req_cleanup(&req);
+
+#ifdef __linux__
+  ASSERT(0 < uv_fs_readfile(NULL, &req, "/proc/self/status", O_RDONLY, 0,
+                            sizeof(big), NULL));
+  ASSERT(0 == memcmp(req.ptr, "Name:", 5));
+  uv_fs_req_cleanup(&req);
+#endif
+
+  ASSERT(UV_ENOENT ==
+         uv_fs_readfile(NULL, &req, "no_such_file", O_RDONLY, 0, sizeof(big),
+                        NULL));
+  ASSERT(req.ptr == NULL);
+  ASSERT(req.statbuf.st_mode == 0);
+  uv_fs_req_cleanup(&req);
+
+  ASSERT(UV_EISDIR == uv_fs_readfile(NULL, &req, ".", O_RDONLY, 0, sizeof(big),
+                                     NULL));
+  ASSERT(req.ptr == NULL);
+  ASSERT(req.statbuf.st_mode != 0);  /* The read failed, not the open. */
+  uv_fs_req_cleanup(&req);
+
+  unlink("test_file");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
 TEST_IMPL(fs_symlink) {
   int r;
   uv_fs_t req;
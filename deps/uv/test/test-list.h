@@ -30,6 +30,7 @@ TEST_DECLARE   (loop_stop)
 TEST_DECLARE   (loop_update_time)
 TEST_DECLARE   (loop_backend_timeout)
 TEST_DECLARE   (loop_configure)
+TEST_DECLARE   (loop_independent)
 TEST_DECLARE   (default_loop_close)
 TEST_DECLARE   (barrier_1)
 TEST_DECLARE   (barrier_2)
@@ -57,6 +58,8 @@ TEST_DECLARE   (tcp_ping_pong)
 TEST_DECLARE   (tcp_ping_pong_v6)
 TEST_DECLARE   (pipe_ping_pong)
 TEST_DECLARE   (delayed_accept)
+TEST_DECLARE   (tcp_accept_batch)
+TEST_DECLARE   (tcp_accept_batch_shuffle)
 TEST_DECLARE   (multiple_listen)
 #ifndef _WIN32
 TEST_DECLARE   (tcp_write_after_connect)
@@ -65,6 +68,7 @@ TEST_DECLARE   (tcp_writealot)
 TEST_DECLARE   (tcp_write_fail)
 TEST_DECLARE   (tcp_try_write)
 TEST_DECLARE   (tcp_write_queue_order)
+TEST_DECLARE   (tcp_write_coalesce)
 TEST_DECLARE   (tcp_open)
 TEST_DECLARE   (tcp_open_twice)
 TEST_DECLARE   (tcp_connect_error_after_write)
@@ -105,6 +109,7 @@ TEST_DECLARE   (udp_create_early_bad_bind)
 TEST_DECLARE   (udp_create_early_bad_domain)
 TEST_DECLARE   (udp_send_and_recv)
 TEST_DECLARE   (udp_send_immediate)
+TEST_DECLARE   (udp_send_batch)
 TEST_DECLARE   (udp_send_unreachable)
 TEST_DECLARE   (udp_multicast_join)
 TEST_DECLARE   (udp_multicast_join6)
@@ -252,6 +257,7 @@ TEST_DECLARE   (fs_unlink_readonly)
 TEST_DECLARE   (fs_chown)
 TEST_DECLARE   (fs_link)
 TEST_DECLARE   (fs_readlink)
+TEST_DECLARE   (fs_readfile)
 TEST_DECLARE   (fs_symlink)
 TEST_DECLARE   (fs_symlink_dir)
 TEST_DECLARE   (fs_utime)
@@ -282,6 +288,13 @@ TEST_DECLARE   (fs_write_alotof_bufs)
 TEST_DECLARE   (fs_write_alotof_bufs_with_offset)
 TEST_DECLARE   (threadpool_queue_work_simple)
 TEST_DECLARE   (threadpool_queue_work_einval)
+TEST_DECLARE   (threadpool_work_should_inline)
+TEST_DECLARE   (threadpool_work_unserialized)
+TEST_DECLARE   (threadpool_tp_freedom_adaptive)
+#ifndef _WIN32
+TEST_DECLARE   (threadpool_pct_reproducible)
+TEST_DECLARE   (threadpool_systematic_exhaustive)
+#endif
 TEST_DECLARE   (threadpool_multiple_event_loops)
 TEST_DECLARE   (threadpool_cancel_getaddrinfo)
 TEST_DECLARE   (threadpool_cancel_getnameinfo)
@@ -324,6 +337,9 @@ TEST_DECLARE   (we_get_signals)
 TEST_DECLARE   (signal_multiple_loops)
 TEST_DECLARE   (closed_fd_events)
 #endif
+#ifdef __linux__
+TEST_DECLARE   (fork_server)
+#endif
 #ifdef __APPLE__
 TEST_DECLARE   (osx_select)
 TEST_DECLARE   (osx_select_many_fds)
@@ -349,6 +365,7 @@ TASK_LIST_START
   TEST_ENTRY  (loop_update_time)
   TEST_ENTRY  (loop_backend_timeout)
   TEST_ENTRY  (loop_configure)
+  TEST_ENTRY  (loop_independent)
   TEST_ENTRY  (default_loop_close)
   TEST_ENTRY  (barrier_1)
   TEST_ENTRY  (barrier_2)
@@ -393,6 +410,8 @@ TASK_LIST_START
   TEST_HELPER (pipe_ping_pong, pipe_echo_server)
 
   TEST_ENTRY  (delayed_accept)
+  TEST_ENTRY  (tcp_accept_batch)
+  TEST_ENTRY  (tcp_accept_batch_shuffle)
   TEST_ENTRY  (multiple_listen)
 
 #ifndef _WIN32
@@ -408,6 +427,7 @@ TASK_LIST_START
   TEST_ENTRY  (tcp_try_write)
 
   TEST_ENTRY  (tcp_write_queue_order)
+  TEST_ENTRY  (tcp_write_coalesce)
 
   TEST_ENTRY  (tcp_open)
   TEST_HELPER (tcp_open, tcp4_echo_server)
@@ -457,6 +477,7 @@ TASK_LIST_START
   TEST_ENTRY  (udp_create_early_bad_domain)
   TEST_ENTRY  (udp_send_and_recv)
   TEST_ENTRY  (udp_send_immediate)
+  TEST_ENTRY  (udp_send_batch)
   TEST_ENTRY  (udp_send_unreachable)
   TEST_ENTRY  (udp_dgram_too_big)
   TEST_ENTRY  (udp_dual_stack)
@@ -648,6 +669,10 @@ TASK_LIST_START
   TEST_ENTRY  (closed_fd_events)
 #endif
 
+#ifdef __linux__
+  TEST_ENTRY  (fork_server)
+#endif
+
 #ifdef __APPLE__
   TEST_ENTRY (osx_select)
   TEST_ENTRY (osx_select_many_fds)
@@ -670,6 +695,7 @@ TASK_LIST_START
   TEST_ENTRY  (fs_utime)
   TEST_ENTRY  (fs_futime)
   TEST_ENTRY  (fs_readlink)
+  TEST_ENTRY  (fs_readfile)
   TEST_ENTRY  (fs_symlink)
   TEST_ENTRY  (fs_symlink_dir)
   TEST_ENTRY  (fs_stat_missing_path)
@@ -698,6 +724,13 @@ TASK_LIST_START
   TEST_ENTRY  (fs_read_write_null_arguments)
   TEST_ENTRY  (threadpool_queue_work_simple)
   TEST_ENTRY  (threadpool_queue_work_einval)
+  TEST_ENTRY  (threadpool_work_should_inline)
+  TEST_ENTRY  (threadpool_work_unserialized)
+  TEST_ENTRY  (threadpool_tp_freedom_adaptive)
+#ifndef _WIN32
+  TEST_ENTRY  (threadpool_pct_reproducible)
+  TEST_ENTRY_CUSTOM (threadpool_systematic_exhaustive, 0, 0, 30000)
+#endif
   TEST_ENTRY  (threadpool_multiple_event_loops)
   TEST_ENTRY  (threadpool_cancel_getaddrinfo)
   TEST_ENTRY  (threadpool_cancel_getnameinfo)
@@ -0,0 +1,133 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* A callback on one loop must not wait for the callbacks of another loop.
+ * The main loop's timer callback blocks until the other loop, running on
+ * its own thread, has run an async callback and a piece of threadpool work.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#define WAIT_TIMEOUT ((uint64_t) 5 * 1000 * 1000 * 1000)
+
+static uv_loop_t other_loop;
+static uv_async_t other_async;
+static uv_timer_t other_keepalive;
+static uv_work_t other_work;
+static uv_thread_t other_thread;
+
+static uv_mutex_t mutex;
+static uv_cond_t cond;
+static int other_done;
+
+static int timer_cb_called;
+static int async_cb_called;
+static int work_cb_called;
+static int after_work_cb_called;
+
+
+static void work_cb(uv_work_t* req) {
+  work_cb_called++;
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  after_work_cb_called++;
+
+  uv_close((uv_handle_t*) &other_async, NULL);
+  uv_close((uv_handle_t*) &other_keepalive, NULL);
+
+  uv_mutex_lock(&mutex);
+  other_done = 1;
+  uv_cond_signal(&cond);
+  uv_mutex_unlock(&mutex);
+}
+
+
+static void async_cb(uv_async_t* handle) {
+  ASSERT(handle == &other_async);
+  async_cb_called++;
+  ASSERT(0 == uv_queue_work(&other_loop, &other_work, work_cb, after_work_cb));
+}
+
+
+static void keepalive_cb(uv_timer_t* handle) {
+}
+
+
+static void other_thread_cb(void* arg) {
+  ASSERT(0 == uv_run(&other_loop, UV_RUN_DEFAULT));
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  int r;
+
+  timer_cb_called++;
+
+  /* Still inside our callback. */
+  ASSERT(0 == uv_async_send(&other_async));
+
+  r = 0;
+  uv_mutex_lock(&mutex);
+  while (!other_done && r == 0)
+    r = uv_cond_timedwait(&cond, &mutex, WAIT_TIMEOUT);
+  uv_mutex_unlock(&mutex);
+  ASSERT(r == 0);
+  ASSERT(other_done);
+
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+TEST_IMPL(loop_independent) {
+  uv_timer_t timer;
+
+  ASSERT(0 == uv_mutex_init(&mutex));
+  ASSERT(0 == uv_cond_init(&cond));
+
+  ASSERT(0 == uv_loop_init(&other_loop));
+  ASSERT(0 == uv_async_init(&other_loop, &other_async, async_cb));
+  /* An async handle alone does not keep the loop alive. */
+  ASSERT(0 == uv_timer_init(&other_loop, &other_keepalive));
+  ASSERT(0 == uv_timer_start(&other_keepalive, keepalive_cb, 1000, 1000));
+  ASSERT(0 == uv_thread_create(&other_thread, other_thread_cb, NULL));
+
+  ASSERT(0 == uv_timer_init(uv_default_loop(), &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, 1, 0));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(0 == uv_thread_join(&other_thread));
+  ASSERT(0 == uv_loop_close(&other_loop));
+
+  ASSERT(timer_cb_called == 1);
+  ASSERT(async_cb_called == 1);
+  ASSERT(work_cb_called == 1);
+  ASSERT(after_work_cb_called == 1);
+
+  uv_cond_destroy(&cond);
+  uv_mutex_destroy(&mutex);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,201 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_CLIENTS 16
+
+static uv_tcp_t server;
+static uv_tcp_t clients[NUM_CLIENTS];
+static uv_connect_t connect_reqs[NUM_CLIENTS];
+static uv_tcp_t accepted[NUM_CLIENTS];
+static uv_timer_t timers[NUM_CLIENTS];
+
+static int connection_cb_called = 0;
+static int accept_called = 0;
+static int connect_cb_called = 0;
+static int close_cb_called = 0;
+
+/* Announcements made while more of the batch was still queued, i.e. while
+ * the server had drained more than one connection in a single wakeup. */
+static int batched_connection_cb_called = 0;
+
+/* Local port of clients[i], and peer port of the n'th announced connection. */
+static int client_ports[NUM_CLIENTS];
+static int accepted_ports[NUM_CLIENTS];
+
+
+static int tcp_port(uv_tcp_t* handle, int peer) {
+  struct sockaddr_in sa;
+  int len;
+
+  len = sizeof sa;
+  if (peer)
+    ASSERT(0 == uv_tcp_getpeername(handle, (struct sockaddr*) &sa, &len));
+  else
+    ASSERT(0 == uv_tcp_getsockname(handle, (struct sockaddr*) &sa, &len));
+  ASSERT(sa.sin_family == AF_INET);
+  return ntohs(sa.sin_port);
+}
+
+
+/* Number of connections announced in a different order than they connected. */
+static int out_of_order(void) {
+  int n;
+  int i;
+
+  n = 0;
+  for (i = 0; i < NUM_CLIENTS; i++)
+    if (accepted_ports[i] != client_ports[i])
+      n++;
+  return n;
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void do_accept(uv_tcp_t* handle) {
+  int r;
+
+  r = uv_tcp_init(uv_default_loop(), handle);
+  ASSERT(r == 0);
+  r = uv_accept((uv_stream_t*) &server, (uv_stream_t*) handle);
+  ASSERT(r == 0);
+  accepted_ports[handle - accepted] = tcp_port(handle, 1);
+  accept_called++;
+
+  uv_close((uv_handle_t*) handle, close_cb);
+
+  if (accept_called == NUM_CLIENTS)
+    uv_close((uv_handle_t*) &server, close_cb);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  do_accept((uv_tcp_t*) handle->data);
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+static void connection_cb(uv_stream_t* tcp, int status) {
+  int n;
+
+  ASSERT(tcp == (uv_stream_t*) &server);
+  ASSERT(status == 0);
+  ASSERT(connection_cb_called < NUM_CLIENTS);
+
+  n = connection_cb_called++;
+  if (server.queued_fds != NULL)
+    batched_connection_cb_called++;
+
+  /* Only one connection is announced at a time, so each must be accepted
+   * before the next one is. Accept half of them later, from a timer. */
+  if (n % 2 == 0) {
+    do_accept(&accepted[n]);
+  } else {
+    ASSERT(0 == uv_timer_init(uv_default_loop(), &timers[n]));
+    timers[n].data = &accepted[n];
+    ASSERT(0 == uv_timer_start(&timers[n], timer_cb, 10, 0));
+  }
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  connect_cb_called++;
+  uv_close((uv_handle_t*) req->handle, close_cb);
+}
+
+
+static void run_accept_batch(void) {
+  struct sockaddr_in addr;
+  int i;
+
+  /* Must be set before libuv reads its runtime parameters. */
+  ASSERT(0 == setenv("UV_ACCEPT_BATCH_SIZE", "8", 1));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  /* Loopback connects complete in order, so the listen backlog holds the
+   * connections in client order by the time the server wakes up. */
+  for (i = 0; i < NUM_CLIENTS; i++) {
+    ASSERT(0 == uv_tcp_init(uv_default_loop(), &clients[i]));
+    ASSERT(0 == uv_tcp_connect(&connect_reqs[i],
+                               &clients[i],
+                               (const struct sockaddr*) &addr,
+                               connect_cb));
+    client_ports[i] = tcp_port(&clients[i], 0);
+  }
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == NUM_CLIENTS);
+  ASSERT(connection_cb_called == NUM_CLIENTS);
+  ASSERT(accept_called == NUM_CLIENTS);
+  ASSERT(close_cb_called == NUM_CLIENTS * 2 + NUM_CLIENTS / 2 + 1);
+
+  /* More than one connection was drained per wakeup. */
+  ASSERT(batched_connection_cb_called > 0);
+}
+
+
+TEST_IMPL(tcp_accept_batch) {
+  run_accept_batch();
+
+  /* The default scheduler announces a batch in backlog order. */
+  ASSERT(out_of_order() == 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(tcp_accept_batch_shuffle) {
+  /* Unlimited iopoll freedom, nothing deferred, fixed seed. */
+  ASSERT(0 == setenv("UV_SCHEDULER_TYPE", "TP_FREEDOM", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_SEED", "1", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_DEG_FREEDOM", "1", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_MAX_DELAY", "0", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_EPOLL_THRESHOLD", "0", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_IOPOLL_DEG_FREEDOM", "-1", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_IOPOLL_DEFER_PERC", "0", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_RUN_CLOSING_DEFER_PERC", "0", 1));
+  ASSERT(0 == setenv("UV_THREADPOOL_SIZE", "1", 1));
+
+  run_accept_batch();
+
+  /* TP_FREEDOM shuffles each batch before announcing it. */
+  ASSERT(out_of_order() > 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,160 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uv.h"
+#include "task.h"
+
+/* Small writes queued while connecting, so uv__write sees all of them at
+ * once and gathers them into a single writev().
+ */
+#define REQ_COUNT 500
+#define CHUNK_SIZE 8
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_connect_t connect_req;
+static int connect_cb_called;
+static int connection_cb_called;
+static int close_cb_called;
+static int write_callbacks;
+
+static uv_write_t write_requests[REQ_COUNT];
+static char chunks[REQ_COUNT][CHUNK_SIZE];
+
+static char received[REQ_COUNT * CHUNK_SIZE];
+static size_t nreceived;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+
+  /* One callback per request, in submission order. */
+  ASSERT(req == &write_requests[write_callbacks]);
+  write_callbacks++;
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(req == &connect_req);
+  connect_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  int i;
+
+  ASSERT(nread >= 0);
+  ASSERT(nreceived + nread <= sizeof(received));
+  memcpy(received + nreceived, buf->base, nread);
+  nreceived += nread;
+
+  if (nreceived < sizeof(received))
+    return;
+
+  for (i = 0; i < REQ_COUNT; i++)
+    ASSERT(memcmp(received + i * CHUNK_SIZE, chunks[i], CHUNK_SIZE) == 0);
+
+  uv_close((uv_handle_t*) &client, close_cb);
+  uv_close((uv_handle_t*) &server, close_cb);
+  uv_close((uv_handle_t*) &incoming, close_cb);
+}
+
+
+static void connection_cb(uv_stream_t* tcp, int status) {
+  ASSERT(status == 0);
+
+  ASSERT(0 == uv_tcp_init(tcp->loop, &incoming));
+  ASSERT(0 == uv_accept(tcp, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+
+  connection_cb_called++;
+}
+
+
+static void start_server(void) {
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+}
+
+
+TEST_IMPL(tcp_write_coalesce) {
+  struct sockaddr_in addr;
+  uv_buf_t bufs[2];
+  int i;
+
+  start_server();
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (struct sockaddr*) &addr,
+                             connect_cb));
+
+  /* Two bufs per request so the gathered iovecs straddle request bounds. */
+  for (i = 0; i < REQ_COUNT; i++) {
+    snprintf(chunks[i], CHUNK_SIZE, "%07d", i);
+    bufs[0] = uv_buf_init(chunks[i], CHUNK_SIZE / 2);
+    bufs[1] = uv_buf_init(chunks[i] + CHUNK_SIZE / 2, CHUNK_SIZE / 2);
+    ASSERT(0 == uv_write(&write_requests[i],
+                         (uv_stream_t*) &client,
+                         bufs,
+                         2,
+                         write_cb));
+  }
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == 1);
+  ASSERT(connection_cb_called == 1);
+  ASSERT(write_callbacks == REQ_COUNT);
+  ASSERT(nreceived == sizeof(received));
+  ASSERT(close_cb_called == 3);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -21,6 +21,14 @@
 
 #include "uv.h"
 #include "task.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+# include <signal.h>
+# include <unistd.h>
+# include <sys/wait.h>
+#endif
 
 static int work_cb_count;
 static int after_work_cb_count;
@@ -74,3 +82,426 @@ TEST_IMPL(threadpool_queue_work_einval) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+/* The vanilla scheduler takes every offer to run small work inline. */
+TEST_IMPL(threadpool_work_should_inline) {
+  ASSERT(uv_work_should_inline(uv_default_loop(), 0) == 1);
+  ASSERT(uv_work_should_inline(uv_default_loop(), 1024) == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* The TP's work CBs are not serialized with the looper's CBs by default,
+ * so a looper CB can wait for one.
+ */
+#define WAIT_TIMEOUT ((uint64_t) 5 * 1000 * 1000 * 1000)
+
+static uv_mutex_t unserialized_mutex;
+static uv_cond_t unserialized_cond;
+static int unserialized_work_done;
+
+
+static void unserialized_work_cb(uv_work_t* req) {
+  ASSERT(req == &work_req);
+  work_cb_count++;
+
+  uv_mutex_lock(&unserialized_mutex);
+  unserialized_work_done = 1;
+  uv_cond_signal(&unserialized_cond);
+  uv_mutex_unlock(&unserialized_mutex);
+}
+
+
+static void unserialized_timer_cb(uv_timer_t* handle) {
+  int r;
+
+  work_req.data = &data;
+  ASSERT(0 == uv_queue_work(handle->loop,
+                            &work_req,
+                            unserialized_work_cb,
+                            after_work_cb));
+
+  /* Still inside our callback. */
+  r = 0;
+  uv_mutex_lock(&unserialized_mutex);
+  while (!unserialized_work_done && r == 0)
+    r = uv_cond_timedwait(&unserialized_cond, &unserialized_mutex, WAIT_TIMEOUT);
+  uv_mutex_unlock(&unserialized_mutex);
+  ASSERT(r == 0);
+  ASSERT(work_cb_count == 1);
+
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+TEST_IMPL(threadpool_work_unserialized) {
+  uv_timer_t timer;
+
+  ASSERT(0 == uv_mutex_init(&unserialized_mutex));
+  ASSERT(0 == uv_cond_init(&unserialized_cond));
+
+  ASSERT(0 == uv_timer_init(uv_default_loop(), &timer));
+  ASSERT(0 == uv_timer_start(&timer, unserialized_timer_cb, 1, 0));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(work_cb_count == 1);
+  ASSERT(after_work_cb_count == 1);
+
+  uv_cond_destroy(&unserialized_cond);
+  uv_mutex_destroy(&unserialized_mutex);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* TP_FREEDOM in adaptive mode. Work arrives one item at a time, so waiting
+ * for the queue to fill never pays off and tp_max_delay_us should back off
+ * well below its bound.
+ */
+#define ADAPTIVE_MAX_DELAY_US 20000
+#define ADAPTIVE_TIMEOUT_MS 5000
+
+static uint64_t adaptive_start;
+static uint64_t adaptive_queued;
+static uint64_t adaptive_first_wait_us;
+static uint64_t adaptive_last_wait_us;
+
+
+static void adaptive_work_cb(uv_work_t* req) {
+  uint64_t wait_us;
+
+  wait_us = (uv_hrtime() - adaptive_queued) / 1000;
+  if (work_cb_count == 0)
+    adaptive_first_wait_us = wait_us;
+  adaptive_last_wait_us = wait_us;
+  work_cb_count++;
+}
+
+
+static void adaptive_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  after_work_cb_count++;
+
+  if (adaptive_last_wait_us < ADAPTIVE_MAX_DELAY_US / 4)
+    return;  /* Backed off. */
+  if ((uv_hrtime() - adaptive_start) / 1000000 > ADAPTIVE_TIMEOUT_MS)
+    return;  /* Never backed off. */
+
+  adaptive_queued = uv_hrtime();
+  ASSERT(0 == uv_queue_work(req->loop,
+                            req,
+                            adaptive_work_cb,
+                            adaptive_after_work_cb));
+}
+
+
+TEST_IMPL(threadpool_tp_freedom_adaptive) {
+  /* Wait for 8 items or 20 ms. The looper never blocks long enough to cut
+   * the wait short. */
+  ASSERT(0 == setenv("UV_SCHEDULER_TYPE", "TP_FREEDOM", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_DEG_FREEDOM", "8", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_MAX_DELAY", "20000", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_EPOLL_THRESHOLD", "100000000", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_IOPOLL_DEG_FREEDOM", "1", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_IOPOLL_DEFER_PERC", "0", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_RUN_CLOSING_DEFER_PERC", "0", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_ADAPTIVE_OVERHEAD_PERC", "10", 1));
+  ASSERT(0 == setenv("UV_THREADPOOL_SIZE", "1", 1));
+
+  adaptive_start = uv_hrtime();
+  adaptive_queued = uv_hrtime();
+  ASSERT(0 == uv_queue_work(uv_default_loop(),
+                            &work_req,
+                            adaptive_work_cb,
+                            adaptive_after_work_cb));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(work_cb_count == after_work_cb_count);
+  ASSERT(work_cb_count > 1);
+
+  /* The first item waited out the bound. A later one didn't. */
+  ASSERT(adaptive_first_wait_us >= ADAPTIVE_MAX_DELAY_US);
+  ASSERT(adaptive_last_wait_us < ADAPTIVE_MAX_DELAY_US / 4);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#ifndef _WIN32
+/* PCT with a fixed seed. Repeated rounds of simultaneous timers, then a batch
+ * of work. Each run is a fresh process, so the scheduler starts from scratch.
+ */
+#define PCT_TIMERS 4
+#define PCT_ROUNDS 8
+#define PCT_WORK 8
+
+struct pct_run {
+  int timer_order[PCT_ROUNDS][PCT_TIMERS];
+  int work_order[PCT_WORK];
+};
+
+static struct pct_run pct_run;
+static uv_timer_t pct_timers[PCT_TIMERS];
+static uv_work_t pct_work[PCT_WORK];
+static int pct_round;
+static int pct_timer_cb_count;
+static int pct_work_cb_count;
+
+
+static void pct_timer_cb(uv_timer_t* handle) {
+  pct_run.timer_order[pct_round][pct_timer_cb_count++] = handle - pct_timers;
+}
+
+
+static void pct_work_cb(uv_work_t* req) {
+  /* One TP thread. */
+  pct_run.work_order[pct_work_cb_count++] = req - pct_work;
+}
+
+
+static void pct_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  after_work_cb_count++;
+}
+
+
+static void pct_child(int fd, const char* depth) {
+  uv_loop_t* loop;
+  int i;
+
+  ASSERT(0 == setenv("UV_SCHEDULER_TYPE", "PCT", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_SEED", "1", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_PCT_DEPTH", depth, 1));
+  /* Every change point falls in the first half of the timer CBs. */
+  ASSERT(0 == setenv("UV_SCHEDULER_PCT_MAX_CBS", "16", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TIMER_DEG_FREEDOM", "-1", 1));
+  /* Let the whole batch of work queue up before each pick. */
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_DEG_FREEDOM", "-1", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_MAX_DELAY", "20000", 1));
+  ASSERT(0 == setenv("UV_THREADPOOL_SIZE", "1", 1));
+
+  loop = uv_default_loop();
+  for (i = 0; i < PCT_TIMERS; i++)
+    ASSERT(0 == uv_timer_init(loop, &pct_timers[i]));
+
+  for (pct_round = 0; pct_round < PCT_ROUNDS; pct_round++) {
+    pct_timer_cb_count = 0;
+    for (i = 0; i < PCT_TIMERS; i++)
+      ASSERT(0 == uv_timer_start(&pct_timers[i], pct_timer_cb, 0, 0));
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    ASSERT(pct_timer_cb_count == PCT_TIMERS);
+  }
+
+  for (i = 0; i < PCT_WORK; i++)
+    ASSERT(0 == uv_queue_work(loop, &pct_work[i], pct_work_cb, pct_after_work_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(after_work_cb_count == PCT_WORK);
+  ASSERT(pct_work_cb_count == PCT_WORK);
+
+  ASSERT(sizeof(pct_run) == write(fd, &pct_run, sizeof(pct_run)));
+  exit(0);
+}
+
+
+static void pct_fork_run(const char* depth, struct pct_run* run) {
+  char* buf;
+  size_t nread;
+  ssize_t n;
+  int status;
+  int fd[2];
+  pid_t pid;
+
+  ASSERT(0 == pipe(fd));
+  pid = fork();
+  ASSERT(pid != -1);
+  if (pid == 0) {
+    close(fd[0]);
+    pct_child(fd[1], depth);
+  }
+  close(fd[1]);
+
+  buf = (char*) run;
+  for (nread = 0; nread < sizeof(*run); nread += n) {
+    do
+      n = read(fd[0], buf + nread, sizeof(*run) - nread);
+    while (n == -1 && errno == EINTR);
+    ASSERT(n > 0);
+  }
+  close(fd[0]);
+
+  ASSERT(pid == waitpid(pid, &status, 0));
+  ASSERT(WIFEXITED(status));
+  ASSERT(WEXITSTATUS(status) == 0);
+}
+
+
+TEST_IMPL(threadpool_pct_reproducible) {
+  struct pct_run run1;
+  struct pct_run run2;
+  struct pct_run flat;
+  int r;
+
+  /* Same seed, same orders. */
+  pct_fork_run("3", &run1);
+  pct_fork_run("3", &run2);
+  ASSERT(0 == memcmp(&run1, &run2, sizeof(run1)));
+
+  /* Without change points, priorities never change. */
+  pct_fork_run("1", &flat);
+  for (r = 1; r < PCT_ROUNDS; r++)
+    ASSERT(0 == memcmp(flat.timer_order[r],
+                       flat.timer_order[0],
+                       sizeof(flat.timer_order[0])));
+
+  /* A change point demoted the timer that went first. */
+  ASSERT(0 != memcmp(run1.timer_order[PCT_ROUNDS - 1],
+                     run1.timer_order[0],
+                     sizeof(run1.timer_order[0])));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* SYSTEMATIC over three queued work items, one fresh process per run, until
+ * the frontier file says "done". The TP takes the items in one of 6 orders.
+ * The looper gets the three done events in one poll and, within the bound of 4
+ * decisions, makes two binary epoll-order decisions and two binary closing
+ * decisions: 16 vectors.
+ */
+#define SYS_FRONTIER "systematic_frontier"
+#define SYS_WORK 3
+#define SYS_MAX_RUNS 200
+#define SYS_RUNS (6 * 16)
+
+static uv_work_t sys_work[SYS_WORK];
+static char sys_vectors[SYS_MAX_RUNS][256];
+
+
+static void sys_work_cb(uv_work_t* req) {
+}
+
+
+static void sys_child(int crash) {
+  uv_loop_t* loop;
+  int i;
+
+  ASSERT(0 == setenv("UV_SCHEDULER_TYPE", "SYSTEMATIC", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_SYSTEMATIC_FRONTIER_FILE", SYS_FRONTIER, 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_SYSTEMATIC_MAX_DECISIONS", "4", 1));
+  /* Pick the first item once all three are queued. */
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_DEG_FREEDOM", "3", 1));
+  ASSERT(0 == setenv("UV_SCHEDULER_TP_MAX_DELAY", "2000", 1));
+  ASSERT(0 == setenv("UV_THREADPOOL_SIZE", "1", 1));
+
+  loop = uv_default_loop();
+  for (i = 0; i < SYS_WORK; i++)
+    ASSERT(0 == uv_queue_work(loop, &sys_work[i], sys_work_cb, pct_after_work_cb));
+  /* Let the TP finish, so the looper sees every done event at once. */
+  uv_sleep(20);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(after_work_cb_count == SYS_WORK);
+
+  /* Die without running the atexit handlers. */
+  if (crash)
+    raise(SIGKILL);
+  exit(0);
+}
+
+
+/* Read the frontier file: the vector the next run will follow, without the
+ * "runs" line. Returns the number of runs so far.
+ */
+static int sys_read_frontier(char* vector, size_t size, int* done) {
+  char line[256];
+  FILE* fp;
+  int runs;
+
+  vector[0] = '\0';
+  runs = 0;
+  *done = 0;
+  fp = fopen(SYS_FRONTIER, "r");
+  ASSERT(fp != NULL);
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (strcmp(line, "done\n") == 0)
+      *done = 1;
+    else if (strncmp(line, "runs ", 5) == 0)
+      runs = atoi(line + 5);
+    else if (line[0] != '#')
+      strncat(vector, line, size - strlen(vector) - 1);
+  }
+  fclose(fp);
+  return runs;
+}
+
+
+static void sys_cleanup(void) {
+  unlink(SYS_FRONTIER);
+  unlink(SYS_FRONTIER ".tmp");
+  unlink(SYS_FRONTIER ".journal");
+}
+
+
+/* Returns the number of runs it took. Run CRASH_RUN dies before exit. */
+static int sys_search(int crash_run) {
+  int status;
+  int done;
+  int nvectors;
+  int n;
+  int i;
+  int j;
+  pid_t pid;
+
+  sys_cleanup();
+
+  done = 0;
+  nvectors = 0;
+  for (n = 0; n < SYS_MAX_RUNS && !done; n++) {
+    pid = fork();
+    ASSERT(pid != -1);
+    if (pid == 0)
+      sys_child(n == crash_run);
+    ASSERT(pid == waitpid(pid, &status, 0));
+
+    /* A run that dies leaves the frontier file alone. The next run accounts
+     * for it. */
+    if (n == crash_run) {
+      ASSERT(WIFSIGNALED(status));
+      ASSERT(WTERMSIG(status) == SIGKILL);
+      continue;
+    }
+    ASSERT(WIFEXITED(status));
+    ASSERT(WEXITSTATUS(status) == 0);
+
+    ASSERT(n + 1 == sys_read_frontier(sys_vectors[nvectors],
+                                      sizeof(sys_vectors[nvectors]),
+                                      &done));
+    nvectors++;
+  }
+  ASSERT(done);
+
+  /* No vector was explored twice. */
+  for (i = 0; i < nvectors; i++)
+    for (j = i + 1; j < nvectors; j++)
+      ASSERT(0 != strcmp(sys_vectors[i], sys_vectors[j]));
+
+  sys_cleanup();
+  return n;
+}
+
+
+TEST_IMPL(threadpool_systematic_exhaustive) {
+  ASSERT(SYS_RUNS == sys_search(-1));
+
+  /* A run that dies is skipped past, not replayed. */
+  ASSERT(SYS_RUNS == sys_search(5));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+#endif  /* !_WIN32 */
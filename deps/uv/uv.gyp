@@ -60,12 +60,17 @@
         'src/scheduler_Vanilla.c',
         'src/scheduler_Fuzzing_Timer.c',
         'src/scheduler_TP_Freedom.c',
+        'src/scheduler_PCT.c',
+        'src/scheduler_Systematic.c',
         'src/logical-callback-node.c',
         'src/unified-callback-enums.c',
         'src/uv-random.c',
         'src/synchronization.c',
         'src/statistics.c',
         'src/runtime.c',
+        'src/trace.c',
+        'src/causal.c',
+        'src/logfile.c',
         'include/uv-errno.h',
         'include/uv-threadpool.h',
         'include/uv-version.h',
@@ -142,6 +147,8 @@
             '-DENABLE_SCHEDULER_VANILLA',
             '-DENABLE_SCHEDULER_FUZZING_TIME',
             '-DENABLE_SCHEDULER_TP_FREEDOM',
+            '-DENABLE_SCHEDULER_PCT',
+            '-DENABLE_SCHEDULER_SYSTEMATIC',
             #'-fstack-protector-strong', # Not portable, Ubuntu ships with older gcc
             #'-DJD_DEBUG_FULL',
             #'-DJD_UT',
@@ -159,6 +166,7 @@
             'src/unix/atomic-ops.h',
             'src/unix/core.c',
             'src/unix/dl.c',
+            'src/unix/fork-server.c',
             'src/unix/fs.c',
             'src/unix/getaddrinfo.c',
             'src/unix/getnameinfo.c',
@@ -292,6 +300,68 @@
         ['uv_library=="shared_library"', {
           'defines': [ 'BUILDING_UV_SHARED=1' ]
         }],
+        [ 'uv_use_dtrace=="true" and OS in "linux mac"', {
+          'defines': [ 'HAVE_DTRACE=1' ],
+          'dependencies': [ 'uv_dtrace_header' ],
+          'include_dirs': [ '<(SHARED_INTERMEDIATE_DIR)' ],
+          'conditions': [
+            # "dtrace -G" is not used on OS X.
+            [ 'OS=="linux"', {
+              'dependencies': [ 'uv_dtrace_provider' ],
+              'sources': [ '<(SHARED_INTERMEDIATE_DIR)/uv_dtrace_provider.o' ],
+            }],
+          ],
+        }],
+      ]
+    },
+
+    {
+      'target_name': 'uv_dtrace_header',
+      'type': 'none',
+      'conditions': [
+        [ 'uv_use_dtrace=="true" and OS=="mac"', {
+          'actions': [
+            {
+              'action_name': 'uv_dtrace_header',
+              'inputs': [ 'src/unix/uv-dtrace.d' ],
+              'outputs': [ '<(SHARED_INTERMEDIATE_DIR)/uv-dtrace.h' ],
+              'action': [ 'dtrace', '-h', '-xnolibs', '-s', '<@(_inputs)',
+                '-o', '<@(_outputs)' ]
+            }
+          ]
+        }],
+        [ 'uv_use_dtrace=="true" and OS=="linux"', {
+          'actions': [
+            {
+              'action_name': 'uv_dtrace_header',
+              'inputs': [ 'src/unix/uv-dtrace.d' ],
+              'outputs': [ '<(SHARED_INTERMEDIATE_DIR)/uv-dtrace.h' ],
+              'action': [ 'dtrace', '-h', '-s', '<@(_inputs)',
+                '-o', '<@(_outputs)' ]
+            }
+          ]
+        }],
+      ]
+    },
+
+    {
+      'target_name': 'uv_dtrace_provider',
+      'type': 'none',
+      'conditions': [
+        [ 'uv_use_dtrace=="true" and OS=="linux"', {
+          'actions': [
+            {
+              'action_name': 'uv_dtrace_provider_o',
+              'inputs': [ 'src/unix/uv-dtrace.d' ],
+              'outputs': [
+                '<(SHARED_INTERMEDIATE_DIR)/uv_dtrace_provider.o'
+              ],
+              'action': [
+                'dtrace', '-C', '-G', '-s', '<@(_inputs)', '-o', '<@(_outputs)'
+              ],
+            }
+          ],
+        }],
       ]
     },
 
@@ -322,6 +392,7 @@
         'test/test-embed.c',
         'test/test-emfile.c',
         'test/test-fail-always.c',
+        'test/test-fork-server.c',
         'test/test-fs.c',
         'test/test-fs-event.c',
         'test/test-get-currentexe.c',
@@ -343,6 +414,7 @@
         'test/test-loop-stop.c',
         'test/test-loop-time.c',
         'test/test-loop-configure.c',
+        'test/test-loop-independent.c',
         'test/test-walk-handles.c',
         'test/test-watcher-cross-stop.c',
         'test/test-multiple-listen.c',
@@ -378,6 +450,7 @@
         'test/test-spawn.c',
         'test/test-fs-poll.c',
         'test/test-stdio-over-pipes.c',
+        'test/test-tcp-accept-batch.c',
         'test/test-tcp-bind-error.c',
         'test/test-tcp-bind6-error.c',
         'test/test-tcp-close.c',
@@ -399,6 +472,7 @@
         'test/test-tcp-unexpected-read.c',
         'test/test-tcp-oob.c',
         'test/test-tcp-read-stop.c',
+        'test/test-tcp-write-coalesce.c',
         'test/test-tcp-write-queue-order.c',
         'test/test-threadpool.c',
         'test/test-threadpool-cancel.c',
@@ -418,6 +492,7 @@
         'test/test-udp-open.c',
         'test/test-udp-options.c',
         'test/test-udp-send-and-recv.c',
+        'test/test-udp-send-batch.c',
         'test/test-udp-send-immediate.c',
         'test/test-udp-send-unreachable.c',
         'test/test-udp-multicast-join.c',
@@ -484,6 +559,7 @@
         'test/benchmark-ping-pongs.c',
         'test/benchmark-pound.c',
         'test/benchmark-pump.c',
+        'test/benchmark-scheduler.c',
         'test/benchmark-sizes.c',
         'test/benchmark-spawn.c',
         'test/benchmark-thread.c',
@@ -242,8 +242,25 @@ fs.readFile = function(path, options, callback_) {
   if (!nullCheck(path, callback))
     return;
 
-  var context = new ReadFileContext(callback, encoding);
   var req = new FSReqWrap();
+
+  if (!isWindows) {
+    // The whole read is one threadpool job, and one callback.
+    req.oncomplete = function(err, buffer) {
+      if (err)
+        return callback(err);
+      if (encoding)
+        buffer = buffer.toString(encoding);
+      callback(null, buffer);
+    };
+    binding.readFile(pathModule._makeLong(path),
+                     stringToFlags(flag),
+                     0o666,
+                     req);
+    return;
+  }
+
+  var context = new ReadFileContext(callback, encoding);
   req.context = context;
   req.oncomplete = readFileAfterOpen;
 
@@ -394,6 +411,17 @@ fs.readFileSync = function(path, options) {
   assertEncoding(encoding);
 
   var flag = options.flag || 'r';
+  var buffer; // single buffer with file data
+
+  if (!isWindows) {
+    nullCheck(path);
+    buffer = binding.readFile(pathModule._makeLong(path),
+                              stringToFlags(flag),
+                              0o666);
+    if (encoding) buffer = buffer.toString(encoding);
+    return buffer;
+  }
+
   var fd = fs.openSync(path, flag, 0o666);
 
   var st;
@@ -408,7 +436,6 @@ fs.readFileSync = function(path, options) {
   }
 
   var pos = 0;
-  var buffer; // single buffer with file data
   var buffers; // list for when size is unknown
 
   if (size === 0) {
@@ -849,6 +876,117 @@ fs.statSync = function(path) {
   return binding.stat(pathModule._makeLong(path));
 };
 
+// binding.statMany() writes this many numbers per path: the error code, then
+// the arguments for fs.Stats in order. Keep in sync with src/node_file.cc.
+const kStatManyFields = 15;
+
+// The results of fs.statMany() and friends: one entry per path, in order.
+// fs.Stats objects and errors are only created when asked for.
+function StatManyResults(paths, lstat, values) {
+  this.length = paths.length;
+  this._paths = paths;
+  this._lstat = lstat;
+  this._values = values;
+}
+
+StatManyResults.prototype._field = function(i, field) {
+  return this._values[i * kStatManyFields + field];
+};
+
+// Returns the error for the i-th path, or null if it was stat'd.
+StatManyResults.prototype.error = function(i) {
+  var err = this._field(i, 0);
+  if (err === 0)
+    return null;
+  // The same error fs.stat() or fs.lstat() gives.
+  return binding.statManyError(err, this._lstat, this._paths[i]);
+};
+
+// Returns an fs.Stats for the i-th path, or null if it could not be stat'd.
+StatManyResults.prototype.get = function(i) {
+  if (this._field(i, 0) !== 0)
+    return null;
+  var blksize = this._field(i, 7);
+  var blocks = this._field(i, 10);
+  return new fs.Stats(this._field(i, 1),  // dev
+                      this._field(i, 2),  // mode
+                      this._field(i, 3),  // nlink
+                      this._field(i, 4),  // uid
+                      this._field(i, 5),  // gid
+                      this._field(i, 6),  // rdev
+                      isNaN(blksize) ? undefined : blksize,  // Windows
+                      this._field(i, 8),  // ino
+                      this._field(i, 9),  // size
+                      isNaN(blocks) ? undefined : blocks,  // Windows
+                      this._field(i, 11),  // atime
+                      this._field(i, 12),  // mtime
+                      this._field(i, 13),  // ctime
+                      this._field(i, 14));  // birthtime
+};
+
+StatManyResults.prototype._isType = function(i, type) {
+  return this._field(i, 0) === 0 &&
+         (this._field(i, 2) & constants.S_IFMT) === type;
+};
+
+StatManyResults.prototype.isFile = function(i) {
+  return this._isType(i, constants.S_IFREG);
+};
+
+StatManyResults.prototype.isDirectory = function(i) {
+  return this._isType(i, constants.S_IFDIR);
+};
+
+StatManyResults.prototype.isSymbolicLink = function(i) {
+  return this._isType(i, constants.S_IFLNK);
+};
+
+function statMany(paths, lstat, callback) {
+  if (!Array.isArray(paths))
+    throw new TypeError('paths must be an array');
+
+  var longPaths = new Array(paths.length);
+  for (var i = 0; i < paths.length; i++) {
+    if (!nullCheck(paths[i], callback))
+      return;
+    longPaths[i] = pathModule._makeLong(paths[i]);
+  }
+
+  var values = new Float64Array(paths.length * kStatManyFields);
+  var results = new StatManyResults(paths.slice(), lstat, values);
+
+  if (!callback) {
+    binding.statMany(longPaths, lstat, values);
+    return results;
+  }
+
+  var req = new FSReqWrap();
+  req.oncomplete = function(err) {
+    if (err)
+      return callback(err);
+    callback(null, results);
+  };
+  binding.statMany(longPaths, lstat, values, req);
+}
+
+// Stats all of |paths| in a single threadpool job. Errors for single paths
+// are in the results, see StatManyResults.
+fs.statMany = function(paths, callback) {
+  statMany(paths, false, makeCallback(callback));
+};
+
+fs.lstatMany = function(paths, callback) {
+  statMany(paths, true, makeCallback(callback));
+};
+
+fs.statManySync = function(paths) {
+  return statMany(paths, false);
+};
+
+fs.lstatManySync = function(paths) {
+  return statMany(paths, true);
+};
+
 fs.readlink = function(path, callback) {
   callback = makeCallback(callback);
   if (!nullCheck(path, callback)) return;
@@ -288,12 +288,33 @@ function Unzip(opts) {
 // true or false if there is anything in the queue when
 // you call the .write() method.
 
+// NODE_ZLIB_COALESCE_WRITES=1 turns on opts.coalesceWrites for every stream.
+const coalesceWritesDefault = !!+process.env.NODE_ZLIB_COALESCE_WRITES;
+
+// With opts.coalesceWrites, the writes that queue up while a chunk is being
+// processed are joined and go through zlib (and the threadpool) as one chunk.
+function coalescedWritev(chunks, cb) {
+  var buffers = new Array(chunks.length);
+  for (var i = 0; i < chunks.length; i++) {
+    if (!(chunks[i].chunk instanceof Buffer))
+      return cb(new Error('invalid input'));
+    buffers[i] = chunks[i].chunk;
+  }
+  this._write(Buffer.concat(buffers), '', cb);
+}
+
 function Zlib(opts, mode) {
   this._opts = opts = opts || {};
   this._chunkSize = opts.chunkSize || exports.Z_DEFAULT_CHUNK;
 
   Transform.call(this, opts);
 
+  var coalesce = opts.coalesceWrites;
+  if (coalesce === undefined)
+    coalesce = coalesceWritesDefault;
+  if (coalesce)
+    this._writev = coalescedWritev;
+
   if (opts.flush) {
     if (opts.flush !== binding.Z_NO_FLUSH &&
         opts.flush !== binding.Z_PARTIAL_FLUSH &&
@@ -468,6 +489,10 @@ Zlib.prototype.close = function(callback) {
   process.nextTick(emitCloseNT, this);
 };
 
+function inlineErrorNT(handle, message, errno) {
+  handle.onerror(message, errno);
+}
+
 function emitCloseNT(self) {
   self.emit('close');
 }
@@ -547,16 +572,29 @@ Zlib.prototype._processChunk = function(chunk, flushFlag, cb) {
   }
 
   assert(!this._closed, 'zlib binding closed');
-  var req = this._handle.write(flushFlag,
-                               chunk, // in
-                               inOff, // in_off
-                               availInBefore, // in_len
-                               this._buffer, // out
-                               this._offset, //out_off
-                               availOutBefore); // out_len
-
-  req.buffer = chunk;
-  req.callback = callback;
+  write();
+
+  function write() {
+    var req = self._handle.write(flushFlag,
+                                 chunk, // in
+                                 inOff, // in_off
+                                 availInBefore, // in_len
+                                 self._buffer, // out
+                                 self._offset, //out_off
+                                 availOutBefore); // out_len
+    if (req === self._handle) {
+      req.buffer = chunk;
+      req.callback = callback;
+      return;
+    }
+    // Small enough that the binding ran it right away. It returned what
+    // writeSync() would have, or the error for onerror, which is not called
+    // from inside write().
+    if (Array.isArray(req))
+      callback(req[0], req[1]);
+    else
+      process.nextTick(inlineErrorNT, self._handle, req.message, req.errno);
+  }
 
   function callback(availInAfter, availOutAfter) {
     if (self._hadError)
@@ -595,15 +633,7 @@ Zlib.prototype._processChunk = function(chunk, flushFlag, cb) {
       if (!async)
         return true;
 
-      var newReq = self._handle.write(flushFlag,
-                                      chunk,
-                                      inOff,
-                                      availInBefore,
-                                      self._buffer,
-                                      self._offset,
-                                      self._chunkSize);
-      newReq.callback = callback; // this same function
-      newReq.buffer = chunk;
+      write();
       return;
     }
 
@@ -107,6 +107,7 @@
         'src/js_stream.cc',
         'src/node.cc',
         'src/node_buffer.cc',
+        'src/node_code_cache.cc',
         'src/node_constants.cc',
         'src/node_contextify.cc',
         'src/node_file.cc',
@@ -121,6 +122,7 @@
         'src/node_i18n.cc',
         'src/pipe_wrap.cc',
         'src/signal_wrap.cc',
+        'src/slab_allocator.cc',
         'src/spawn_sync.cc',
         'src/string_bytes.cc',
         'src/stream_base.cc',
@@ -143,6 +145,7 @@
         'src/js_stream.h',
         'src/node.h',
         'src/node_buffer.h',
+        'src/node_code_cache.h',
         'src/node_constants.h',
         'src/node_file.h',
         'src/node_http_parser.h',
@@ -159,6 +162,7 @@
         'src/udp_wrap.h',
         'src/req-wrap.h',
         'src/req-wrap-inl.h',
+        'src/slab_allocator.h',
         'src/string_bytes.h',
         'src/stream_base.h',
         'src/stream_base-inl.h',
@@ -17,7 +17,9 @@ inline AsyncWrap::AsyncWrap(Environment* env,
                             v8::Local<v8::Object> object,
                             ProviderType provider,
                             AsyncWrap* parent)
-    : BaseObject(env, object), bits_(static_cast<uint32_t>(provider) << 1) {
+    : BaseObject(env, object),
+      bits_(static_cast<uint32_t>(provider) << 1),
+      uid_(env->get_async_wrap_uid()) {
   // Only set wrapper class id if object will be Wrap'd.
   if (object->InternalFieldCount() > 0)
     // Shift provider value over to prevent id collision.
@@ -58,6 +60,11 @@ inline AsyncWrap::ProviderType AsyncWrap::provider_type() const {
 }
 
 
+inline int64_t AsyncWrap::get_uid() const {
+  return uid_;
+}
+
+
 inline v8::Local<v8::Value> AsyncWrap::MakeCallback(
     const v8::Local<v8::String> symbol,
     int argc,
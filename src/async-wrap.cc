@@ -203,18 +203,21 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
 
   Local<Value> ret;
 
-  if (has_abort_on_uncaught_and_domains) {
-    Local<Value> fn = process->Get(env()->domain_abort_uncaught_exc_string());
-    if (fn->IsFunction()) {
-      Local<Array> special_context = Array::New(env()->isolate(), 2);
-      special_context->Set(0, context);
-      special_context->Set(1, cb);
-      ret = fn.As<Function>()->Call(special_context, argc, argv);
+  {
+    FuzzTraceScope trace_scope("MakeCallback", FUZZ_PHASE_CALLBACK, get_uid());
+    if (has_abort_on_uncaught_and_domains) {
+      Local<Value> fn = process->Get(env()->domain_abort_uncaught_exc_string());
+      if (fn->IsFunction()) {
+        Local<Array> special_context = Array::New(env()->isolate(), 2);
+        special_context->Set(0, context);
+        special_context->Set(1, cb);
+        ret = fn.As<Function>()->Call(special_context, argc, argv);
+      } else {
+        ret = cb->Call(context, argc, argv);
+      }
     } else {
       ret = cb->Call(context, argc, argv);
     }
-  } else {
-    ret = cb->Call(context, argc, argv);
   }
 
   if (try_catch.HasCaught()) {
@@ -245,6 +248,7 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
   }
 
   if (tick_info->length() == 0) {
+    FuzzTraceScope trace_scope("microtasks", FUZZ_PHASE_MICROTASKS, get_uid());
     env()->isolate()->RunMicrotasks();
   }
 
@@ -255,7 +259,10 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
 
   tick_info->set_in_tick(true);
 
-  env()->tick_callback_function()->Call(process, 0, nullptr);
+  {
+    FuzzTraceScope trace_scope("nextTick", FUZZ_PHASE_NEXT_TICK, get_uid());
+    env()->tick_callback_function()->Call(process, 0, nullptr);
+  }
 
   tick_info->set_in_tick(false);
 
@@ -55,6 +55,8 @@ class AsyncWrap : public BaseObject {
 
   inline ProviderType provider_type() const;
 
+  inline int64_t get_uid() const;
+
   // Only call these within a valid HandleScope.
   v8::Local<v8::Value> MakeCallback(const v8::Local<v8::Function> cb,
                                      int argc,
@@ -76,6 +78,7 @@ class AsyncWrap : public BaseObject {
   // expected the context object will receive a _asyncQueue object property
   // that will be used to call pre/post in MakeCallback.
   uint32_t bits_;
+  const int64_t uid_;
 };
 
 void LoadAsyncWrapperInfo(Environment* env);
@@ -198,6 +198,7 @@ inline Environment::Environment(v8::Local<v8::Context> context,
       using_asyncwrap_(false),
       printed_error_(false),
       trace_sync_io_(false),
+      async_wrap_uid_(0),
       debugger_agent_(this),
       http_parser_buffer_(nullptr),
       context_(context->GetIsolate(), context) {
@@ -311,6 +312,10 @@ inline Environment::TickInfo* Environment::tick_info() {
   return &tick_info_;
 }
 
+inline int64_t Environment::get_async_wrap_uid() {
+  return ++async_wrap_uid_;
+}
+
 inline Environment::ArrayBufferAllocatorInfo*
     Environment::array_buffer_allocator_info() {
   return &array_buffer_allocator_info_;
@@ -375,6 +380,10 @@ inline void Environment::set_http_parser_buffer(char* buffer) {
   http_parser_buffer_ = buffer;
 }
 
+inline SlabAllocator* Environment::read_slab_allocator() {
+  return &read_slab_allocator_;
+}
+
 inline Environment* Environment::from_cares_timer_handle(uv_timer_t* handle) {
   return ContainerOf(&Environment::cares_timer_handle_, handle);
 }
@@ -1,5 +1,6 @@
 #include "env.h"
 #include "env-inl.h"
+#include "node_internals.h"
 #include "v8.h"
 #include <stdio.h>
 
@@ -56,13 +57,6 @@ void Environment::PrintSyncTrace() const {
   fflush(stderr);
 }
 
-static void mylog_0 (char *fmt)
-{
-#ifndef JD_SILENT_NODE
-  fprintf(stderr, fmt);
-#endif
-}
-
 bool Environment::KickNextTick() {
   TickInfo* info = tick_info();
 
@@ -81,14 +75,17 @@ bool Environment::KickNextTick() {
 
   info->set_in_tick(true);
 
-  mylog_0("Environment::KickNextTick: Calling tick_callback_function\n");
+  NODE_FUZZ_LOG(7, "Environment::KickNextTick: Calling tick_callback_function\n");
 
   // process nextTicks after call
   TryCatch try_catch;
   try_catch.SetVerbose(true);
-  tick_callback_function()->Call(process_object(), 0, nullptr);
+  {
+    FuzzTraceScope trace_scope("nextTick", FUZZ_PHASE_NEXT_TICK);
+    tick_callback_function()->Call(process_object(), 0, nullptr);
+  }
 
-  mylog_0("Environment::KickNextTick: Done calling tick_callback_function\n");
+  NODE_FUZZ_LOG(7, "Environment::KickNextTick: Done calling tick_callback_function\n");
 
   info->set_in_tick(false);
 
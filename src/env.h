@@ -5,6 +5,7 @@
 #include "debug-agent.h"
 #include "handle_wrap.h"
 #include "req-wrap.h"
+#include "slab_allocator.h"
 #include "tree.h"
 #include "util.h"
 #include "uv.h"
@@ -424,6 +425,8 @@ class Environment {
   inline TickInfo* tick_info();
   inline ArrayBufferAllocatorInfo* array_buffer_allocator_info();
   inline uint64_t timer_base() const;
+  // The next async id, for an AsyncWrap. Unique within the Environment.
+  inline int64_t get_async_wrap_uid();
 
   static inline Environment* from_cares_timer_handle(uv_timer_t* handle);
   inline uv_timer_t* cares_timer_handle();
@@ -454,6 +457,9 @@ class Environment {
   inline char* http_parser_buffer() const;
   inline void set_http_parser_buffer(char* buffer);
 
+  // Backs the Buffers of StreamWrap and UDPWrap reads.
+  inline SlabAllocator* read_slab_allocator();
+
   inline void ThrowError(const char* errmsg);
   inline void ThrowTypeError(const char* errmsg);
   inline void ThrowRangeError(const char* errmsg);
@@ -542,6 +548,7 @@ class Environment {
   bool using_asyncwrap_;
   bool printed_error_;
   bool trace_sync_io_;
+  int64_t async_wrap_uid_;
   debugger::Agent debugger_agent_;
 
   HandleWrapQueue handle_wrap_queue_;
@@ -553,6 +560,7 @@ class Environment {
   uint32_t* heap_statistics_buffer_ = nullptr;
 
   char* http_parser_buffer_;
+  SlabAllocator read_slab_allocator_;
 
 #define V(PropertyName, TypeName)                                             \
   v8::Persistent<TypeName> PropertyName ## _;
@@ -6,6 +6,7 @@
 #include "util.h"
 #include "util-inl.h"
 #include "node.h"
+#include "node_internals.h"
 
 namespace node {
 
@@ -66,6 +67,8 @@ HandleWrap::HandleWrap(Environment* env,
       flags_(0),
       handle__(handle) {
   handle__->data = this;
+  if (fuzz_causal_enabled)
+    uv_causal_tag(handle__, provider, get_uid());
   HandleScope scope(env->isolate());
   Wrap(object, this);
   env->handle_wrap_queue()->PushBack(this);
@@ -1,5 +1,6 @@
 #include "node.h"
 #include "node_buffer.h"
+#include "node_code_cache.h"
 #include "node_constants.h"
 #include "node_file.h"
 #include "node_http_parser.h"
@@ -99,6 +100,7 @@ using v8::Integer;
 using v8::Isolate;
 using v8::Local;
 using v8::Locker;
+using v8::MaybeLocal;
 using v8::Message;
 using v8::Number;
 using v8::Object;
@@ -106,6 +108,7 @@ using v8::ObjectTemplate;
 using v8::Promise;
 using v8::PromiseRejectMessage;
 using v8::PropertyCallbackInfo;
+using v8::ScriptOrigin;
 using v8::SealHandleScope;
 using v8::StackFrame;
 using v8::StackTrace;
@@ -113,6 +116,7 @@ using v8::String;
 using v8::TryCatch;
 using v8::Uint32;
 using v8::Uint32Array;
+using v8::UnboundScript;
 using v8::V8;
 using v8::Value;
 
@@ -141,9 +145,17 @@ static node_module* modlist_addon;
 static const char* icu_data_dir = nullptr;
 #endif
 
+// Directory of the on-disk code cache (see node_code_cache.h), or nullptr.
+static const char* code_cache_dir = nullptr;
+
 // used by C++ modules as well
 bool no_deprecation = false;
 
+// See node_internals.h. Nothing is logged until InitFuzzLog() sets them.
+int fuzz_log_verbosity = -1;
+bool fuzz_trace_enabled = false;
+bool fuzz_causal_enabled = false;
+
 // process-relative uptime base, initialized at start-up
 static double prog_start_time;
 static bool debugger_running;
@@ -152,27 +164,16 @@ static uv_async_t dispatch_debug_messages_async;
 static Isolate* node_isolate = nullptr;
 static v8::Platform* default_platform;
 
-static void mylog_0 (char *fmt)
-{
-#ifndef JD_SILENT_NODE
-  fprintf(stderr, fmt);
-#endif
-}
-
-static void mylog_1 (char *fmt, int arg1)
-{
-#ifndef JD_SILENT_NODE
-  fprintf(stderr, fmt, arg1);
-#endif
-}
-
 static void CheckImmediate(uv_check_t* handle) {
   Environment* env = Environment::from_immediate_check_handle(handle);
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
-  mylog_0("node::CheckImmediate: MakeCallback\n");
-  MakeCallback(env, env->process_object(), env->immediate_callback_string());
-  mylog_0("node::CheckImmediate: MakeCallback done\n");
+  NODE_FUZZ_LOG(7, "node::CheckImmediate: MakeCallback\n");
+  {
+    FuzzTraceScope trace_scope("setImmediate", FUZZ_PHASE_IMMEDIATE);
+    MakeCallback(env, env->process_object(), env->immediate_callback_string());
+  }
+  NODE_FUZZ_LOG(7, "node::CheckImmediate: MakeCallback done\n");
 }
 
 
@@ -957,9 +958,12 @@ void SetupDomainUse(const FunctionCallbackInfo<Value>& args) {
 }
 
 void RunMicrotasks(const FunctionCallbackInfo<Value>& args) {
-  mylog_0("node::RunMicrotasks: Running tasks\n");
-  args.GetIsolate()->RunMicrotasks();
-  mylog_0("node::RunMicrotasks: Done running tasks\n");
+  NODE_FUZZ_LOG(7, "node::RunMicrotasks: Running tasks\n");
+  {
+    FuzzTraceScope trace_scope("microtasks", FUZZ_PHASE_MICROTASKS);
+    args.GetIsolate()->RunMicrotasks();
+  }
+  NODE_FUZZ_LOG(7, "node::RunMicrotasks: Done running tasks\n");
 }
 
 
@@ -1477,13 +1481,17 @@ static Local<Value> ExecuteString(Environment* env,
   // we will handle exceptions ourself.
   try_catch.SetVerbose(false);
 
-  Local<v8::Script> script = v8::Script::Compile(source, filename);
-  if (script.IsEmpty()) {
+  ScriptOrigin origin(filename);
+  MaybeLocal<UnboundScript> unbound_script =
+      code_cache::CompileUnboundScript(env->isolate(), source, origin);
+  if (unbound_script.IsEmpty()) {
     ReportException(env, try_catch);
     /* TODO Need to uv_mark_exit_end() ? */
     exit(3);
   }
 
+  Local<v8::Script> script =
+      unbound_script.ToLocalChecked()->BindToCurrentContext();
   Local<Value> result = script->Run();
   if (result.IsEmpty()) {
     ReportException(env, try_catch);
@@ -1949,7 +1957,7 @@ static int _EmitExit(Environment *env, int code) {
     Integer::New(env->isolate(), code)
   };
 
-  mylog_1("_EmitExit: process.emit('exit', %i)\n", code);
+  NODE_FUZZ_LOG(1, "_EmitExit: process.emit('exit', %i)\n", code);
   uv_mark_exit_begin();
   MakeCallback(env, process_object, "emit", ARRAY_SIZE(args), args);
 
@@ -2011,6 +2019,31 @@ void MemoryUsage(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// uv_fork_server() returns in a forked child, but process.pid was set in
+// the server. Safe to call when no fork happened.
+static void RefreshPid(Environment* env) {
+  HandleScope handle_scope(env->isolate());
+  env->process_object()->ForceSet(OneByteString(env->isolate(), "pid"),
+                                  Integer::New(env->isolate(), getpid()),
+                                  v8::ReadOnly);
+}
+
+
+// Become a fork server if UV_FORK_SERVER_FD is set. Returns in each child.
+// Lets a script pick a fork point later than the default one, e.g. after
+// its own setup; run it with NODE_FORK_SERVER_POINT=explicit. src/node.js
+// calls it for NODE_FORK_SERVER_POINT=bootstrap.
+static void ForkServer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  int err = uv_fork_server(env->event_loop());
+  if (err) {
+    return env->ThrowUVException(err, "uv_fork_server");
+  }
+  RefreshPid(env);
+}
+
+
 void Kill(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -2977,6 +3010,7 @@ void SetupProcessObject(Environment* env,
 
   env->SetMethod(process, "uptime", Uptime);
   env->SetMethod(process, "memoryUsage", MemoryUsage);
+  env->SetMethod(process, "_forkServer", ForkServer);
 
   env->SetMethod(process, "binding", Binding);
   env->SetMethod(process, "_linkedBinding", LinkedBinding);
@@ -3088,9 +3122,9 @@ void LoadEnvironment(Environment* env) {
   env->SetMethod(env->process_object(), "_rawDebug", RawDebug);
 
   Local<Value> arg = env->process_object();
-  mylog_0("node::LoadEnvironment: f->Call\n");
+  NODE_FUZZ_LOG(1, "node::LoadEnvironment: f->Call\n");
   f->Call(global, 1, &arg);
-  mylog_0("node::LoadEnvironment: Done with f\n");
+  NODE_FUZZ_LOG(1, "node::LoadEnvironment: Done with f\n");
 }
 
 static void PrintHelp();
@@ -3148,6 +3182,8 @@ static void PrintHelp() {
          "  --track-heap-objects  track heap object allocations for heap "
          "snapshots\n"
          "  --v8-options          print v8 command line options\n"
+         "  --code-cache-dir=dir  cache compiled code in dir, which must\n"
+         "                        exist (overrides NODE_CODE_CACHE_DIR)\n"
 #if HAVE_OPENSSL
          "  --tls-cipher-list=val use an alternative default TLS cipher list\n"
 #endif
@@ -3175,6 +3211,7 @@ static void PrintHelp() {
 #endif
 #endif
          "NODE_REPL_HISTORY       path to the persistent REPL history file\n"
+         "NODE_CODE_CACHE_DIR     directory in which to cache compiled code\n"
          "\n"
          "Documentation can be found at https://nodejs.org/\n");
 }
@@ -3291,6 +3328,8 @@ static void ParseArgs(int* argc,
     } else if (strncmp(arg, "--icu-data-dir=", 15) == 0) {
       icu_data_dir = arg + 15;
 #endif
+    } else if (strncmp(arg, "--code-cache-dir=", 17) == 0) {
+      code_cache_dir = arg + 17;
     } else if (strcmp(arg, "--expose-internals") == 0 ||
                strcmp(arg, "--expose_internals") == 0) {
       // consumed in js
@@ -3735,6 +3774,12 @@ void Init(int* argc,
                      "(check NODE_ICU_DATA or --icu-data-dir parameters)");
   }
 #endif
+  if (code_cache_dir == nullptr) {
+    // if the parameter isn't given, use the env variable.
+    code_cache_dir = secure_getenv("NODE_CODE_CACHE_DIR");
+  }
+  code_cache::Initialize(code_cache_dir);
+
   // The const_cast doesn't violate conceptual const-ness.  V8 doesn't modify
   // the argv array or the elements it points to.
   if (v8_argc > 1)
@@ -3762,6 +3807,14 @@ void Init(int* argc,
   const char no_typed_array_heap[] = "--typed_array_max_size_in_heap=0";
   V8::SetFlagsFromString(no_typed_array_heap, sizeof(no_typed_array_heap) - 1);
 
+  // In fork-server mode (see uv_fork_server) the children inherit none of the
+  // platform's worker threads, so keep V8 from handing them work.
+  if (getenv("UV_FORK_SERVER_FD") != nullptr) {
+    const char no_concurrency[] =
+        "--noconcurrent_recompilation --noconcurrent_osr --noconcurrent_sweeping";
+    V8::SetFlagsFromString(no_concurrency, sizeof(no_concurrency) - 1);
+  }
+
   if (!use_debug_agent) {
     RegisterDebugSignalHandler();
   }
@@ -3979,9 +4032,9 @@ static void StartNodeInstance(void* arg) {
     if (instance_data->use_debug_agent())
       StartDebug(env, debug_wait_connect);
 
-    mylog_0("node::StartNodeInstance: Loading the environment\n");
+    NODE_FUZZ_LOG(1, "node::StartNodeInstance: Loading the environment\n");
     LoadEnvironment(env);
-    mylog_0("node::StartNodeInstance: Done loading the environment\n");
+    NODE_FUZZ_LOG(1, "node::StartNodeInstance: Done loading the environment\n");
 
     env->set_trace_sync_io(trace_sync_io);
 
@@ -3994,19 +4047,35 @@ static void StartNodeInstance(void* arg) {
       bool more;
 
       uv_mark_init_stack_end();
-      mylog_0("node::StartNodeInstance: Initial stack is definitely over now\n");
+      NODE_FUZZ_LOG(1, "node::StartNodeInstance: Initial stack is definitely over now\n");
+
+      // Fork once the main script has been loaded, so every run skips
+      // startup. Scripts that want a later fork point call
+      // process._forkServer() themselves; with "bootstrap", src/node.js
+      // forked before the main script.
+      const char* fork_point = getenv("NODE_FORK_SERVER_POINT");
+      if (instance_data->is_main() &&
+          (fork_point == nullptr ||
+           (strcmp(fork_point, "explicit") != 0 &&
+            strcmp(fork_point, "bootstrap") != 0))) {
+        int err = uv_fork_server(env->event_loop());
+        if (err)
+          fprintf(stderr, "node: uv_fork_server: %s\n", uv_strerror(err));
+        else
+          RefreshPid(env);
+      }
       do {
-        mylog_0("node::StartNodeInstance: beginning of loop\n");
+        NODE_FUZZ_LOG(5, "node::StartNodeInstance: beginning of loop\n");
 
-        mylog_0("node::StartNodeInstance: pumping message loop\n");
+        NODE_FUZZ_LOG(5, "node::StartNodeInstance: pumping message loop\n");
         v8::platform::PumpMessageLoop(default_platform, isolate);
-        mylog_0("node::StartNodeInstance: done pumping message loop\n");
+        NODE_FUZZ_LOG(5, "node::StartNodeInstance: done pumping message loop\n");
 
-        mylog_0("node::StartNodeInstance: uv_run\n");
+        NODE_FUZZ_LOG(5, "node::StartNodeInstance: uv_run\n");
         uv_mark_main_uv_run_begin();
         more = uv_run(env->event_loop(), UV_RUN_ONCE);
         uv_mark_main_uv_run_end();
-        mylog_1("node::StartNodeInstance: uv_run done (more %i)\n", more ? 1 : 0);
+        NODE_FUZZ_LOG(5, "node::StartNodeInstance: uv_run done (more %i)\n", more ? 1 : 0);
 
         if (more == false) {
           v8::platform::PumpMessageLoop(default_platform, isolate);
@@ -4015,14 +4084,14 @@ static void StartNodeInstance(void* arg) {
           // Emit `beforeExit` if the loop became alive either after emitting
           // event, or after running some callbacks.
           more = uv_loop_alive(env->event_loop());
-          mylog_0("node::StartNodeInstance: uv_run after EmitBeforeExit\n");
+          NODE_FUZZ_LOG(5, "node::StartNodeInstance: uv_run after EmitBeforeExit\n");
           uv_mark_main_uv_run_begin();
           if (uv_run(env->event_loop(), UV_RUN_NOWAIT) != 0)
             more = true;
           uv_mark_main_uv_run_end();
-          mylog_1("node::StartNodeInstance: uv_run after EmitBeforeExit done (more %i)\n", more ? 1 : 0);
+          NODE_FUZZ_LOG(5, "node::StartNodeInstance: uv_run after EmitBeforeExit done (more %i)\n", more ? 1 : 0);
         }
-        mylog_0("node::StartNodeInstance: end of loop\n");
+        NODE_FUZZ_LOG(5, "node::StartNodeInstance: end of loop\n");
       } while (more == true);
     }
 
@@ -4050,8 +4119,19 @@ static void StartNodeInstance(void* arg) {
     node_isolate = nullptr;
 }
 
+// libuv drops log messages until it is initialized, which would otherwise
+// happen in uv_default_loop(), after node has started logging.
+static void InitFuzzLog() {
+  initialize_fuzzy_libuv();
+  fuzz_log_verbosity = uv_log_verbosity();
+  fuzz_trace_enabled = uv_trace_enabled() != 0;
+  fuzz_causal_enabled = uv_causal_enabled() != 0;
+}
+
+
 int Start(int argc, char** argv) {
-  mylog_0("node::Start: Initial stack code will run soon\n");
+  InitFuzzLog();
+  NODE_FUZZ_LOG(1, "node::Start: Initial stack code will run soon\n");
   uv_mark_init_stack_begin();
   PlatformInit();
 
@@ -4072,7 +4152,7 @@ int Start(int argc, char** argv) {
   V8::SetEntropySource(crypto::EntropySource);
 #endif
 
-  mylog_0("node::Start: Initializing V8\n");
+  NODE_FUZZ_LOG(1, "node::Start: Initializing V8\n");
   const int thread_pool_size = 4;
   default_platform = v8::platform::CreateDefaultPlatform(thread_pool_size);
   V8::InitializePlatform(default_platform);
@@ -4087,10 +4167,10 @@ int Start(int argc, char** argv) {
                                    exec_argc,
                                    exec_argv,
                                    use_debug_agent);
-    mylog_0("node::Start: Calling StartNodeInstance\n");
+    NODE_FUZZ_LOG(1, "node::Start: Calling StartNodeInstance\n");
     StartNodeInstance(&instance_data);
     exit_code = instance_data.exit_code();
-    mylog_1("node::Start: node instance exited with %i\n", exit_code);
+    NODE_FUZZ_LOG(1, "node::Start: node instance exited with %i\n", exit_code);
   }
   V8::Dispose();
 
@@ -45,6 +45,12 @@
 
     process.argv[0] = process.execPath;
 
+    // With NODE_FORK_SERVER_POINT=bootstrap, become a fork server here, so
+    // every run starts from a bootstrapped process but runs all of the user
+    // code, the main module included. See uv_fork_server() in deps/uv.
+    if (process.env.NODE_FORK_SERVER_POINT === 'bootstrap')
+      process._forkServer();
+
     // There are various modes that Node can run in. The most common two
     // are running from a script and running the REPL - but there are a few
     // others like the debugger or running --eval arguments. Here we decide
@@ -800,12 +800,19 @@ int32_t IndexOf(const char* haystack,
                 const char* needle,
                 size_t n_length) {
   CHECK_GE(h_length, n_length);
+  CHECK_GT(n_length, 0);
   // TODO(trevnorris): Implement Boyer-Moore string search algorithm.
-  for (size_t i = 0; i < h_length - n_length + 1; i++) {
-    if (haystack[i] == needle[0]) {
-      if (memcmp(haystack + i, needle, n_length) == 0)
-        return i;
+  // Until then, memchr() finds the candidates; the C library's version
+  // looks at a vector's worth of bytes at a time.
+  const char* const end = haystack + h_length - n_length + 1;
+  for (const char* p = haystack; p < end; p++) {
+    if (*p != needle[0]) {
+      p = static_cast<const char*>(memchr(p, needle[0], end - p));
+      if (p == nullptr)
+        break;
     }
+    if (memcmp(p, needle, n_length) == 0)
+      return p - haystack;
   }
   return -1;
 }
@@ -0,0 +1,171 @@
+#include "node_code_cache.h"
+#include "node_internals.h"
+#include "util.h"
+#include "util-inl.h"
+#include "v8.h"
+
+#include <limits.h>  // PATH_MAX
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>  // memcmp, memcpy
+
+#if defined(_MSC_VER)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>  // getpid
+#endif
+
+namespace node {
+namespace code_cache {
+
+using v8::Isolate;
+using v8::Local;
+using v8::MaybeLocal;
+using v8::ScriptCompiler;
+using v8::ScriptOrigin;
+using v8::String;
+using v8::UnboundScript;
+using v8::V8;
+
+// Below this many characters, compiling is cheaper than the file system.
+// Also keeps one-off scripts (vm.runInThisContext('1 + 1')) out of the cache.
+static const int kMinSourceLength = 4 * 1024;
+
+static const char* cache_dir = nullptr;
+
+// Each entry starts with this. V8 trusts the length of the data it is given,
+// so a truncated or foreign file must not get that far.
+struct EntryHeader {
+  char magic[8];
+  uint32_t length;  // Of the data that follows.
+  uint32_t reserved;
+};
+
+static const char kEntryMagic[8] = { 'N', 'O', 'D', 'E', 'C', 'C', '0', '1' };
+
+
+// FNV-1a, over the V8 version and the source's UTF-16 code units.
+static uint64_t Hash(const String::Value& source) {
+  uint64_t hash = 14695981039346656037ULL;
+  const char* version = V8::GetVersion();
+  for (size_t i = 0; version[i] != '\0'; i++)
+    hash = (hash ^ static_cast<uint8_t>(version[i])) * 1099511628211ULL;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(*source);
+  const size_t size = source.length() * sizeof(**source);
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ data[i]) * 1099511628211ULL;
+  return hash;
+}
+
+
+// Returns the entry in |path|, or nullptr if there is none. Sets |*corrupt|
+// if there is a file that is not a whole entry.
+static ScriptCompiler::CachedData* Read(const char* path, bool* corrupt) {
+  *corrupt = false;
+  FILE* fp = fopen(path, "rb");
+  if (fp == nullptr)
+    return nullptr;
+
+  ScriptCompiler::CachedData* cached_data = nullptr;
+  EntryHeader header;
+  long size;  // NOLINT(runtime/int)
+  if (fseek(fp, 0, SEEK_END) == 0 &&
+      (size = ftell(fp)) > static_cast<long>(sizeof(header)) &&  // NOLINT
+      fseek(fp, 0, SEEK_SET) == 0 &&
+      fread(&header, sizeof(header), 1, fp) == 1 &&
+      memcmp(header.magic, kEntryMagic, sizeof(kEntryMagic)) == 0 &&
+      header.length == size - sizeof(header)) {
+    uint8_t* data = new uint8_t[header.length];
+    if (fread(data, 1, header.length, fp) == header.length) {
+      cached_data = new ScriptCompiler::CachedData(
+          data,
+          static_cast<int>(header.length),
+          ScriptCompiler::CachedData::BufferOwned);
+    } else {
+      delete[] data;
+    }
+  }
+
+  fclose(fp);
+  *corrupt = cached_data == nullptr;
+  return cached_data;
+}
+
+
+static void Write(const char* path, const ScriptCompiler::CachedData* data) {
+  char tmp_path[PATH_MAX];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, getpid());
+
+  FILE* fp = fopen(tmp_path, "wb");
+  if (fp == nullptr)
+    return;
+  EntryHeader header;
+  memcpy(header.magic, kEntryMagic, sizeof(kEntryMagic));
+  header.length = static_cast<uint32_t>(data->length);
+  header.reserved = 0;
+  const bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                  fwrite(data->data, 1, header.length, fp) == header.length;
+  if (fclose(fp) == 0 && ok && rename(tmp_path, path) == 0)
+    return;
+  remove(tmp_path);
+}
+
+
+void Initialize(const char* dir) {
+  cache_dir = dir;
+  if (cache_dir != nullptr && cache_dir[0] == '\0')
+    cache_dir = nullptr;
+}
+
+
+MaybeLocal<UnboundScript> CompileUnboundScript(Isolate* isolate,
+                                               Local<String> code,
+                                               const ScriptOrigin& origin) {
+  if (cache_dir == nullptr || code->Length() < kMinSourceLength) {
+    ScriptCompiler::Source source(code, origin);
+    return ScriptCompiler::CompileUnboundScript(isolate, &source);
+  }
+
+  char path[PATH_MAX];
+  {
+    String::Value value(code);
+    snprintf(path, sizeof(path), "%s/%016llx.v8cache",
+             cache_dir,
+             static_cast<unsigned long long>(Hash(value)));  // NOLINT
+  }
+
+  bool corrupt;
+  ScriptCompiler::CachedData* cached_data = Read(path, &corrupt);
+  if (corrupt) {
+    NODE_FUZZ_LOG(3, "code_cache: corrupt %s\n", path);
+    remove(path);
+  }
+  if (cached_data != nullptr) {
+    // |source| owns |cached_data| from here on.
+    ScriptCompiler::Source source(code, origin, cached_data);
+    MaybeLocal<UnboundScript> script = ScriptCompiler::CompileUnboundScript(
+        isolate, &source, ScriptCompiler::kConsumeCodeCache);
+    if (!cached_data->rejected) {
+      NODE_FUZZ_LOG(3, "code_cache: hit %s\n", path);
+      return script;
+    }
+    // Stale: another V8 build or other flags. V8 compiled it from source.
+    NODE_FUZZ_LOG(3, "code_cache: rejected %s\n", path);
+    remove(path);
+    return script;
+  }
+
+  ScriptCompiler::Source source(code, origin);
+  MaybeLocal<UnboundScript> script = ScriptCompiler::CompileUnboundScript(
+      isolate, &source, ScriptCompiler::kProduceCodeCache);
+  const ScriptCompiler::CachedData* produced = source.GetCachedData();
+  if (!script.IsEmpty() && produced != nullptr && produced->length > 0) {
+    NODE_FUZZ_LOG(3, "code_cache: miss %s\n", path);
+    Write(path, produced);
+  }
+  return script;
+}
+
+}  // namespace code_cache
+}  // namespace node
@@ -0,0 +1,32 @@
+#ifndef SRC_NODE_CODE_CACHE_H_
+#define SRC_NODE_CODE_CACHE_H_
+
+#include "v8.h"
+
+namespace node {
+namespace code_cache {
+
+// An opt-in on-disk cache of V8's compiled code, for processes that load the
+// same JS over and over, such as the runs of a fuzzing campaign.
+//
+// Entries are keyed by a hash of the source and the V8 version, one file per
+// script in |dir|, which must exist. Concurrent processes may share |dir|:
+// entries are written to a temporary file and renamed into place. V8 rejects
+// an entry produced under different flags; we then delete it, so the next
+// run produces a fresh one.
+//
+// Scripts shorter than a few KB are compiled as usual; they are not worth a
+// file. With |dir| nullptr, CompileUnboundScript() is a plain compile.
+void Initialize(const char* dir);
+
+// Like v8::ScriptCompiler::CompileUnboundScript(), consuming or producing
+// a cache entry for |code|.
+v8::MaybeLocal<v8::UnboundScript> CompileUnboundScript(
+    v8::Isolate* isolate,
+    v8::Local<v8::String> code,
+    const v8::ScriptOrigin& origin);
+
+}  // namespace code_cache
+}  // namespace node
+
+#endif  // SRC_NODE_CODE_CACHE_H_
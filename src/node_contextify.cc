@@ -1,4 +1,5 @@
 #include "node.h"
+#include "node_code_cache.h"
 #include "node_internals.h"
 #include "node_watchdog.h"
 #include "base-object.h"
@@ -510,9 +511,8 @@ class ContextifyScript : public BaseObject {
     }
 
     ScriptOrigin origin(filename);
-    ScriptCompiler::Source source(code, origin);
-    Local<UnboundScript> v8_script =
-        ScriptCompiler::CompileUnbound(env->isolate(), &source);
+    MaybeLocal<UnboundScript> v8_script =
+        code_cache::CompileUnboundScript(env->isolate(), code, origin);
 
     if (v8_script.IsEmpty()) {
       if (display_errors) {
@@ -521,7 +521,8 @@ class ContextifyScript : public BaseObject {
       try_catch.ReThrow();
       return;
     }
-    contextify_script->script_.Reset(env->isolate(), v8_script);
+    contextify_script->script_.Reset(env->isolate(),
+                                     v8_script.ToLocalChecked());
   }
 
 
@@ -4600,6 +4600,133 @@ void ECDH::SetPublicKey(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Async PBKDF2 and randomBytes requests that produce a lot of output are
+// split into up to kMaxWorkParts threadpool requests. As many parts as there
+// are threads are queued at once; each part that finishes queues the next one
+// at the back of the queue. One big job then spreads across the pool, and
+// with a one-thread pool it takes turns with the other requests instead of
+// holding the thread for its whole duration.
+static const size_t kMaxWorkParts = 4;
+
+// randomBytes() output is not split into parts smaller than this.
+static const size_t kRandomBytesMinPart = 64 * 1024;
+
+// The number of threads in libuv's pool, worked out the way libuv does.
+static size_t ThreadPoolSize() {
+  static size_t size = 0;
+  if (size == 0) {
+    unsigned int nthreads = 4;
+    const char* val = getenv("UV_THREADPOOL_SIZE");
+    if (val != nullptr)
+      nthreads = atoi(val);
+    if (nthreads == 0)
+      nthreads = 1;
+    if (nthreads > 128)
+      nthreads = 128;
+    size = nthreads;
+  }
+  return size;
+}
+
+template <typename Request>
+struct WorkPart {
+  uv_work_t work_req;
+  Request* req;
+  size_t offset;
+  size_t length;
+  unsigned long error;
+};
+
+template <typename Request>
+class WorkParts {
+ public:
+  WorkParts() : count_(0), next_(0), in_flight_(0) {}
+
+  // Cuts |length| bytes of output into parts that are multiples of |unit|
+  // bytes, except for the last, and no shorter than |min_length| bytes.
+  void Split(Request* req, size_t length, size_t unit, size_t min_length) {
+    CHECK_GT(unit, 0);
+    const size_t units = (length + unit - 1) / unit;
+    size_t min_units = (min_length + unit - 1) / unit;
+    if (min_units == 0)
+      min_units = 1;
+    size_t count = units / min_units;
+    if (count == 0)
+      count = 1;
+    if (count > kMaxWorkParts)
+      count = kMaxWorkParts;
+    const size_t part_length = (units + count - 1) / count * unit;
+
+    size_t offset = 0;
+    count_ = 0;
+    do {
+      WorkPart<Request>* part = &parts_[count_++];
+      part->req = req;
+      part->offset = offset;
+      part->length = length - offset;
+      if (part->length > part_length)
+        part->length = part_length;
+      part->error = 0;
+      offset += part->length;
+    } while (offset < length);
+  }
+
+  // Queues as many parts as there are threads in the pool.
+  void Start(uv_loop_t* loop, uv_work_cb work, uv_after_work_cb after) {
+    loop_ = loop;
+    work_ = work;
+    after_ = after;
+    next_ = 0;
+    in_flight_ = 0;
+    const size_t concurrency = ThreadPoolSize();
+    while (next_ < count_ && in_flight_ < concurrency)
+      QueueNext();
+  }
+
+  // Called from each part's after callback. Queues the next part, unless
+  // they have all been queued or a part failed. Returns true once no part
+  // is left in flight.
+  bool Finish() {
+    CHECK_GT(in_flight_, 0);
+    in_flight_--;
+    if (next_ < count_ && error() == 0)
+      QueueNext();
+    return in_flight_ == 0;
+  }
+
+  size_t count() const {
+    return count_;
+  }
+
+  // The first error any part ran into, or 0.
+  unsigned long error() const {
+    for (size_t i = 0; i < count_; i++)
+      if (parts_[i].error != 0)
+        return parts_[i].error;
+    return 0;
+  }
+
+  static WorkPart<Request>* From(uv_work_t* work_req) {
+    return ContainerOf(&WorkPart<Request>::work_req, work_req);
+  }
+
+ private:
+  void QueueNext() {
+    CHECK_LT(next_, count_);
+    in_flight_++;
+    uv_queue_work(loop_, &parts_[next_++].work_req, work_, after_);
+  }
+
+  WorkPart<Request> parts_[kMaxWorkParts];
+  size_t count_;
+  size_t next_;
+  size_t in_flight_;
+  uv_loop_t* loop_;
+  uv_work_cb work_;
+  uv_after_work_cb after_;
+};
+
+
 class PBKDF2Request : public AsyncWrap {
  public:
   PBKDF2Request(Environment* env,
@@ -4630,8 +4757,8 @@ class PBKDF2Request : public AsyncWrap {
     persistent().Reset();
   }
 
-  uv_work_t* work_req() {
-    return &work_req_;
+  inline WorkParts<PBKDF2Request>* parts() {
+    return &parts_;
   }
 
   inline const EVP_MD* digest() const {
@@ -4690,9 +4817,8 @@ class PBKDF2Request : public AsyncWrap {
 
   size_t self_size() const override { return sizeof(*this); }
 
-  uv_work_t work_req_;
-
  private:
+  WorkParts<PBKDF2Request> parts_;
   const EVP_MD* digest_;
   int error_;
   ssize_t passlen_;
@@ -4720,9 +4846,85 @@ void EIO_PBKDF2(PBKDF2Request* req) {
 }
 
 
-void EIO_PBKDF2(uv_work_t* work_req) {
-  PBKDF2Request* req = ContainerOf(&PBKDF2Request::work_req_, work_req);
-  EIO_PBKDF2(req);
+// HMAC of |data| followed by |data2|, keyed the way |tpl| is.
+static bool PBKDF2Hmac(HMAC_CTX* tpl,
+                       const unsigned char* data,
+                       size_t len,
+                       const unsigned char* data2,
+                       size_t len2,
+                       unsigned char* md) {
+  HMAC_CTX hctx;
+  HMAC_CTX_init(&hctx);
+  const bool ok = HMAC_CTX_copy(&hctx, tpl) &&
+                  HMAC_Update(&hctx, data, len) &&
+                  HMAC_Update(&hctx, data2, len2) &&
+                  HMAC_Final(&hctx, md, nullptr);
+  HMAC_CTX_cleanup(&hctx);
+  return ok;
+}
+
+
+// Same as PKCS5_PBKDF2_HMAC(), except it derives the |length| bytes of the
+// key that start at |offset|, a multiple of the digest size, rather than at
+// the start. Every digest-sized block of the key can be computed separately.
+static bool PBKDF2Part(PBKDF2Request* req, size_t offset, size_t length) {
+  const size_t mdlen = EVP_MD_size(req->digest());
+  unsigned char* out = reinterpret_cast<unsigned char*>(req->key()) + offset;
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned char counter[4];
+  uint32_t block = offset / mdlen + 1;
+  HMAC_CTX tpl;
+  bool ok;
+
+  HMAC_CTX_init(&tpl);
+  ok = HMAC_Init_ex(&tpl, req->pass(), req->passlen(), req->digest(), nullptr);
+  while (ok && length > 0) {
+    const size_t cplen = length < mdlen ? length : mdlen;
+    counter[0] = (block >> 24) & 0xff;
+    counter[1] = (block >> 16) & 0xff;
+    counter[2] = (block >> 8) & 0xff;
+    counter[3] = block & 0xff;
+    ok = PBKDF2Hmac(&tpl,
+                    reinterpret_cast<unsigned char*>(req->salt()),
+                    req->saltlen(),
+                    counter,
+                    sizeof(counter),
+                    md);
+    memcpy(out, md, cplen);
+    for (ssize_t i = 1; ok && i < req->iter(); i++) {
+      ok = PBKDF2Hmac(&tpl, md, mdlen, nullptr, 0, md);
+      for (size_t k = 0; k < cplen; k++)
+        out[k] ^= md[k];
+    }
+    out += cplen;
+    length -= cplen;
+    block++;
+  }
+  HMAC_CTX_cleanup(&tpl);
+  OPENSSL_cleanse(md, sizeof(md));
+  return ok;
+}
+
+
+void EIO_PBKDF2Part(uv_work_t* work_req) {
+  WorkPart<PBKDF2Request>* part = WorkParts<PBKDF2Request>::From(work_req);
+  PBKDF2Request* req = part->req;
+  bool ok;
+  if (req->parts()->count() == 1) {
+    // Not split: the key fits in one digest block.
+    ok = PKCS5_PBKDF2_HMAC(req->pass(),
+                           req->passlen(),
+                           reinterpret_cast<unsigned char*>(req->salt()),
+                           req->saltlen(),
+                           req->iter(),
+                           req->digest(),
+                           req->keylen(),
+                           reinterpret_cast<unsigned char*>(req->key()));
+  } else {
+    ok = PBKDF2Part(req, part->offset, part->length);
+  }
+  if (!ok)
+    part->error = 1;
 }
 
 
@@ -4740,7 +4942,13 @@ void EIO_PBKDF2After(PBKDF2Request* req, Local<Value> argv[2]) {
 
 void EIO_PBKDF2After(uv_work_t* work_req, int status) {
   CHECK_EQ(status, 0);
-  PBKDF2Request* req = ContainerOf(&PBKDF2Request::work_req_, work_req);
+  PBKDF2Request* req = WorkParts<PBKDF2Request>::From(work_req)->req;
+  if (!req->parts()->Finish())
+    return;
+  // Like PKCS5_PBKDF2_HMAC(), error() is 1 on success.
+  req->set_error(req->parts()->error() == 0);
+  OPENSSL_cleanse(req->pass(), req->passlen());
+  OPENSSL_cleanse(req->salt(), req->saltlen());
   Environment* env = req->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -4848,10 +5056,11 @@ void PBKDF2(const FunctionCallbackInfo<Value>& args) {
     // XXX(trevnorris): This will need to go with the rest of domains.
     if (env->in_domain())
       obj->Set(env->domain_string(), env->domain_array()->Get(0));
-    uv_queue_work(env->event_loop(),
-                  req->work_req(),
-                  EIO_PBKDF2,
-                  EIO_PBKDF2After);
+    // Keys longer than one digest block are derived a range of blocks per
+    // part.
+    const size_t mdlen = EVP_MD_size(digest);
+    req->parts()->Split(req, keylen, mdlen, mdlen);
+    req->parts()->Start(env->event_loop(), EIO_PBKDF2Part, EIO_PBKDF2After);
   } else {
     env->PrintSyncTrace();
     Local<Value> argv[2];
@@ -4890,8 +5099,8 @@ class RandomBytesRequest : public AsyncWrap {
     persistent().Reset();
   }
 
-  uv_work_t* work_req() {
-    return &work_req_;
+  inline WorkParts<RandomBytesRequest>* parts() {
+    return &parts_;
   }
 
   inline size_t size() const {
@@ -4924,31 +5133,39 @@ class RandomBytesRequest : public AsyncWrap {
 
   size_t self_size() const override { return sizeof(*this); }
 
-  uv_work_t work_req_;
-
  private:
+  WorkParts<RandomBytesRequest> parts_;
   unsigned long error_;
   size_t size_;
   char* data_;
 };
 
 
-void RandomBytesWork(uv_work_t* work_req) {
-  RandomBytesRequest* req =
-      ContainerOf(&RandomBytesRequest::work_req_, work_req);
-
+unsigned long RandomBytesFill(char* data, size_t size) {
   // Ensure that OpenSSL's PRNG is properly seeded.
   CheckEntropy();
 
-  const int r = RAND_bytes(reinterpret_cast<unsigned char*>(req->data()),
-                           req->size());
+  const int r = RAND_bytes(reinterpret_cast<unsigned char*>(data), size);
 
   // RAND_bytes() returns 0 on error.
-  if (r == 0) {
-    req->set_error(ERR_get_error());
-  } else if (r == -1) {
-    req->set_error(static_cast<unsigned long>(-1));
-  }
+  if (r == 0)
+    return ERR_get_error();
+  if (r == -1)
+    return static_cast<unsigned long>(-1);
+  return 0;
+}
+
+
+void RandomBytesWork(RandomBytesRequest* req) {
+  req->set_error(RandomBytesFill(req->data(), req->size()));
+}
+
+
+void RandomBytesPart(uv_work_t* work_req) {
+  WorkPart<RandomBytesRequest>* part =
+      WorkParts<RandomBytesRequest>::From(work_req);
+  part->error = RandomBytesFill(part->req->data() + part->offset,
+                                part->length);
 }
 
 
@@ -4975,8 +5192,10 @@ void RandomBytesCheck(RandomBytesRequest* req, Local<Value> argv[2]) {
 
 void RandomBytesAfter(uv_work_t* work_req, int status) {
   CHECK_EQ(status, 0);
-  RandomBytesRequest* req =
-      ContainerOf(&RandomBytesRequest::work_req_, work_req);
+  RandomBytesRequest* req = WorkParts<RandomBytesRequest>::From(work_req)->req;
+  if (!req->parts()->Finish())
+    return;
+  req->set_error(req->parts()->error());
   Environment* env = req->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -5008,15 +5227,13 @@ void RandomBytes(const FunctionCallbackInfo<Value>& args) {
     // XXX(trevnorris): This will need to go with the rest of domains.
     if (env->in_domain())
       obj->Set(env->domain_string(), env->domain_array()->Get(0));
-    uv_queue_work(env->event_loop(),
-                  req->work_req(),
-                  RandomBytesWork,
-                  RandomBytesAfter);
+    req->parts()->Split(req, size, 1, kRandomBytesMinPart);
+    req->parts()->Start(env->event_loop(), RandomBytesPart, RandomBytesAfter);
     args.GetReturnValue().Set(obj);
   } else {
     env->PrintSyncTrace();
     Local<Value> argv[2];
-    RandomBytesWork(req->work_req());
+    RandomBytesWork(req);
     RandomBytesCheck(req, argv);
     delete req;
 
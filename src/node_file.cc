@@ -17,11 +17,14 @@
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <math.h>  // NAN
+#include <stdio.h>
 
 #if defined(__MINGW32__) || defined(_MSC_VER)
 # include <io.h>
 #endif
 
+#include <string>
 #include <vector>
 
 namespace node {
@@ -29,12 +32,15 @@ namespace node {
 using v8::Array;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::Exception;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
+using v8::MaybeLocal;
 using v8::Number;
 using v8::Object;
 using v8::String;
@@ -128,6 +134,39 @@ static inline bool IsInt64(double x) {
 }
 
 
+// Same message as the RangeError from fs.readFile()'s fallback path.
+static Local<Value> ReadFileTooLargeError(Environment* env) {
+  char message[64];
+  snprintf(message, sizeof(message),
+           "File size is greater than possible Buffer: 0x%x bytes",
+           Buffer::kMaxLength);
+  return Exception::RangeError(OneByteString(env->isolate(), message));
+}
+
+
+// Turns a failed uv_fs_readfile() into the error that open() or read() would
+// have thrown. It fills in statbuf once the file is open.
+static Local<Value> ReadFileError(Environment* env,
+                                  const uv_fs_t* req,
+                                  int err,
+                                  const char* path) {
+  if (err == UV_EFBIG)
+    return ReadFileTooLargeError(env);
+  const char* syscall = req->statbuf.st_mode == 0 ? "open" : "read";
+  return UVException(env->isolate(), err, syscall, nullptr, path);
+}
+
+
+// Hands the data uv_fs_readfile() read over to a new Buffer, which frees it.
+// uv_fs_readfile() was given Buffer::kMaxLength, so the data fits.
+static Local<Object> TakeReadFileBuffer(Environment* env, uv_fs_t* req) {
+  const size_t length = static_cast<size_t>(req->result);
+  char* data = static_cast<char*>(req->ptr);
+  req->ptr = nullptr;
+  return Buffer::New(env, data, length).ToLocalChecked();
+}
+
+
 static void After(uv_fs_t *req) {
   FSReqWrap* req_wrap = static_cast<FSReqWrap*>(req->data);
   CHECK_EQ(&req_wrap->req_, req);
@@ -144,7 +183,9 @@ static void After(uv_fs_t *req) {
   // (Feel free to increase this if you need more)
   Local<Value> argv[2];
 
-  if (req->result < 0) {
+  if (req->result < 0 && req->fs_type == UV_FS_READFILE) {
+    argv[0] = ReadFileError(env, req, req->result, req->path);
+  } else if (req->result < 0) {
     // An error happened.
     argv[0] = UVException(env->isolate(),
                           req->result,
@@ -210,6 +251,10 @@ static void After(uv_fs_t *req) {
         argv[1] = Integer::New(env->isolate(), req->result);
         break;
 
+      case UV_FS_READFILE:
+        argv[1] = TakeReadFileBuffer(env, req);
+        break;
+
       case UV_FS_SCANDIR:
         {
           int r;
@@ -573,6 +618,206 @@ static void FStat(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// statMany() writes this many doubles per path: the error code (0 or a
+// negative errno), then the fields BuildStatsObject() passes to fs.Stats, in
+// the same order. Keep in sync with kStatManyFields in lib/fs.js.
+static const size_t kStatManyFields = 15;
+
+
+// Stats every path into |values|. Safe to call off the main thread.
+static void StatPaths(uv_loop_t* loop,
+                      bool lstat,
+                      const std::vector<std::string>& paths,
+                      std::vector<double>* values) {
+  values->assign(paths.size() * kStatManyFields, 0);
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    double* v = &(*values)[i * kStatManyFields];
+    uv_fs_t req;
+    int err;
+    if (lstat)
+      err = uv_fs_lstat(loop, &req, paths[i].c_str(), nullptr);
+    else
+      err = uv_fs_stat(loop, &req, paths[i].c_str(), nullptr);
+
+    if (err < 0) {
+      v[0] = err;
+      uv_fs_req_cleanup(&req);
+      continue;
+    }
+
+    const uv_stat_t* s = static_cast<const uv_stat_t*>(req.ptr);
+    v[1] = static_cast<double>(s->st_dev);
+    v[2] = static_cast<double>(s->st_mode);
+    v[3] = static_cast<double>(s->st_nlink);
+    v[4] = static_cast<double>(s->st_uid);
+    v[5] = static_cast<double>(s->st_gid);
+    v[6] = static_cast<double>(s->st_rdev);
+# if defined(__POSIX__)
+    v[7] = static_cast<double>(s->st_blksize);
+# else
+    v[7] = NAN;  // undefined in fs.Stats, as with BuildStatsObject().
+# endif
+    v[8] = static_cast<double>(s->st_ino);
+    v[9] = static_cast<double>(s->st_size);
+# if defined(__POSIX__)
+    v[10] = static_cast<double>(s->st_blocks);
+# else
+    v[10] = NAN;
+# endif
+#define X(index, name)                                                        \
+    v[index] = (static_cast<double>(s->st_##name.tv_sec) * 1000) +            \
+               (static_cast<double>(s->st_##name.tv_nsec / 1000000));         \
+
+    X(11, atim)
+    X(12, mtim)
+    X(13, ctim)
+    X(14, birthtim)
+#undef X
+    uv_fs_req_cleanup(&req);
+  }
+}
+
+
+static void CopyStatValues(Local<Float64Array> results,
+                           const std::vector<double>& values) {
+  // The array may have been neutered in the meantime.
+  const size_t length = MIN(results->Length(), values.size());
+  if (length == 0)
+    return;
+  char* data = static_cast<char*>(results->Buffer()->GetContents().Data());
+  memcpy(data + results->ByteOffset(), values.data(),
+         length * sizeof(values[0]));
+}
+
+
+// One threadpool job for a whole statMany() call.
+class StatManyReqWrap: public ReqWrap<uv_work_t> {
+ public:
+  StatManyReqWrap(Environment* env,
+                  Local<Object> req,
+                  bool lstat,
+                  Local<Float64Array> results,
+                  std::vector<std::string>* paths)
+      : ReqWrap(env, req, AsyncWrap::PROVIDER_FSREQWRAP),
+        lstat_(lstat),
+        results_(env->isolate(), results) {
+    paths_.swap(*paths);
+    Wrap(object(), this);
+  }
+
+  ~StatManyReqWrap() { results_.Reset(); }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+  static void Work(uv_work_t* work_req) {
+    StatManyReqWrap* req_wrap = static_cast<StatManyReqWrap*>(work_req->data);
+    StatPaths(req_wrap->env()->event_loop(),
+              req_wrap->lstat_,
+              req_wrap->paths_,
+              &req_wrap->values_);
+  }
+
+  static void After(uv_work_t* work_req, int status) {
+    StatManyReqWrap* req_wrap = static_cast<StatManyReqWrap*>(work_req->data);
+    Environment* env = req_wrap->env();
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+
+    Local<Value> argv[1];
+    if (status < 0) {
+      argv[0] = UVException(env->isolate(), status, "statMany");
+    } else {
+      CopyStatValues(
+          Local<Float64Array>::New(env->isolate(), req_wrap->results_),
+          req_wrap->values_);
+      argv[0] = Null(env->isolate());
+    }
+
+    req_wrap->MakeCallback(env->oncomplete_string(), ARRAY_SIZE(argv), argv);
+    delete req_wrap;
+  }
+
+ private:
+  const bool lstat_;
+  v8::Persistent<Float64Array> results_;
+  std::vector<std::string> paths_;
+  std::vector<double> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(StatManyReqWrap);
+};
+
+
+// Wrapper for stat(2) or lstat(2) on many paths at once. Per-path errors go
+// into |results|, which is filled in by the time oncomplete is called.
+//
+// statMany(paths, lstat, results[, req])
+// 0 paths    array of strings
+// 1 lstat    if true, lstat(2) instead of stat(2)
+// 2 results  Float64Array with room for kStatManyFields per path
+// 3 req      if an FSReqWrap, run in the threadpool, else synchronously
+static void StatMany(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (!args[0]->IsArray())
+    return TYPE_ERROR("paths must be an array");
+  if (!args[2]->IsFloat64Array())
+    return TYPE_ERROR("results must be a Float64Array");
+
+  Local<Array> array = args[0].As<Array>();
+  Local<Float64Array> results = args[2].As<Float64Array>();
+  const bool lstat = args[1]->IsTrue();
+  const size_t count = array->Length();
+
+  if (results->Length() < count * kStatManyFields)
+    return env->ThrowRangeError("results is too small");
+
+  std::vector<std::string> paths;
+  paths.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    Local<Value> path = array->Get(i);
+    if (!path->IsString())
+      return TYPE_ERROR("path must be a string");
+    node::Utf8Value value(env->isolate(), path);
+    paths.push_back(std::string(*value, value.length()));
+  }
+
+  if (args[3]->IsObject()) {
+    StatManyReqWrap* req_wrap =
+        new StatManyReqWrap(env, args[3].As<Object>(), lstat, results, &paths);
+    req_wrap->Dispatched();  // Work() looks the wrap up through req_.data.
+    uv_queue_work(env->event_loop(),
+                  &req_wrap->req_,
+                  StatManyReqWrap::Work,
+                  StatManyReqWrap::After);
+    args.GetReturnValue().Set(req_wrap->persistent());
+  } else {
+    std::vector<double> values;
+    env->PrintSyncTrace();
+    StatPaths(env->event_loop(), lstat, paths, &values);
+    CopyStatValues(results, values);
+  }
+}
+
+
+// The error stat() or lstat() throws for |path|, for a path statMany() could
+// not stat.
+//
+// error = statManyError(err, lstat, path)
+static void StatManyError(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsInt32());
+  CHECK(args[2]->IsString());
+
+  const int err = args[0]->Int32Value();
+  const char* syscall = args[1]->IsTrue() ? "lstat" : "stat";
+  node::Utf8Value path(env->isolate(), args[2]);
+  args.GetReturnValue().Set(
+      UVException(env->isolate(), err, syscall, nullptr, *path));
+}
+
+
 static void Symlink(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -651,6 +896,52 @@ static void ReadLink(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// Reads a whole file in one threadpool job: open, fstat, read and close.
+//
+// buffer = readFile(path, flags, mode[, req])
+static void ReadFile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  int len = args.Length();
+  if (len < 1)
+    return TYPE_ERROR("path required");
+  if (len < 2)
+    return TYPE_ERROR("flags required");
+  if (len < 3)
+    return TYPE_ERROR("mode required");
+  if (!args[0]->IsString())
+    return TYPE_ERROR("path must be a string");
+  if (!args[1]->IsInt32())
+    return TYPE_ERROR("flags must be an int");
+  if (!args[2]->IsInt32())
+    return TYPE_ERROR("mode must be an int");
+
+  node::Utf8Value path(env->isolate(), args[0]);
+  int flags = args[1]->Int32Value();
+  int mode = static_cast<int>(args[2]->Int32Value());
+
+  if (args[3]->IsObject()) {
+    ASYNC_CALL(readfile, args[3], *path, flags, mode, Buffer::kMaxLength)
+  } else {
+    // Not SYNC_CALL: errors name the step that failed, not "readfile".
+    fs_req_wrap req_wrap;
+    env->PrintSyncTrace();
+    int err = uv_fs_readfile(env->event_loop(),
+                             &SYNC_REQ,
+                             *path,
+                             flags,
+                             mode,
+                             Buffer::kMaxLength,
+                             nullptr);
+    if (err < 0) {
+      env->isolate()->ThrowException(
+          ReadFileError(env, &SYNC_REQ, err, *path));
+      return;
+    }
+    args.GetReturnValue().Set(TakeReadFileBuffer(env, &SYNC_REQ));
+  }
+}
+
 static void Rename(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -1292,11 +1583,14 @@ void InitFs(Local<Object> target,
   env->SetMethod(target, "rmdir", RMDir);
   env->SetMethod(target, "mkdir", MKDir);
   env->SetMethod(target, "readdir", ReadDir);
+  env->SetMethod(target, "readFile", ReadFile);
   env->SetMethod(target, "internalModuleReadFile", InternalModuleReadFile);
   env->SetMethod(target, "internalModuleStat", InternalModuleStat);
   env->SetMethod(target, "stat", Stat);
   env->SetMethod(target, "lstat", LStat);
   env->SetMethod(target, "fstat", FStat);
+  env->SetMethod(target, "statMany", StatMany);
+  env->SetMethod(target, "statManyError", StatManyError);
   env->SetMethod(target, "link", Link);
   env->SetMethod(target, "symlink", Symlink);
   env->SetMethod(target, "readlink", ReadLink);
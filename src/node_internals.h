@@ -28,11 +28,80 @@ struct sockaddr;
                      constant_attributes);                                    \
   } while (0)
 
+// Log to the fuzzing layer's LOG_NODE class (UV_LOG_NODE_VERBOSITY).
+// The arguments are only evaluated if |level| is enabled.
+// Compiled out with JD_SILENT_NODE.
+#ifdef JD_SILENT_NODE
+#define NODE_FUZZ_LOG(level, ...) do {} while (0)
+#else
+#define NODE_FUZZ_LOG(level, ...)                                             \
+  do {                                                                        \
+    if ((level) <= ::node::fuzz_log_verbosity)                                \
+      uv_log(level, __VA_ARGS__);                                             \
+  } while (0)
+#endif
+
 namespace node {
 
+// libuv's logging settings, cached by node::Start() before it logs anything,
+// so the checks in NODE_FUZZ_LOG and FuzzTraceScope are inline. They do not
+// change once libuv is initialized.
+extern int fuzz_log_verbosity;  // uv_log_verbosity()
+extern bool fuzz_trace_enabled;  // uv_trace_enabled()
+extern bool fuzz_causal_enabled;  // uv_causal_enabled()
+
 // Forward declaration
 class Environment;
 
+// JS that runs outside the JS of the libuv CB that caused it. Recorded in
+// libuv's causal log (UV_CAUSAL_FILE); deps/uv/causal-graph.py reads the
+// names from this list, so only append to it.
+#define NODE_FUZZ_PHASES(V)                                                   \
+  V(NONE)                                                                     \
+  V(IMMEDIATE)                                                                \
+  V(MICROTASKS)                                                               \
+  V(NEXT_TICK)                                                                \
+  V(CALLBACK)
+
+enum FuzzPhase {
+#define V(PHASE) FUZZ_PHASE_ ## PHASE,
+  NODE_FUZZ_PHASES(V)
+#undef V
+};
+
+// Marks the scope as a slice called |name| in libuv's CB timeline
+// (UV_TRACE_FILE), so JS that runs outside a libuv CB shows up there too,
+// and as |phase| in its causal log. |async_id| is the AsyncWrap on whose
+// behalf the JS runs, or 0 if none.
+// Compiled out with JD_SILENT_NODE.
+class FuzzTraceScope {
+ public:
+#ifdef JD_SILENT_NODE
+  FuzzTraceScope(const char* name, FuzzPhase phase, int64_t async_id = 0) {}
+#else
+  FuzzTraceScope(const char* name, FuzzPhase phase, int64_t async_id = 0)
+      : name_(name), phase_(phase), async_id_(async_id) {
+    if (fuzz_trace_enabled)
+      uv_trace_begin(name_);
+    if (fuzz_causal_enabled)
+      uv_causal_phase_begin(phase_, async_id_);
+  }
+  ~FuzzTraceScope() {
+    if (fuzz_causal_enabled)
+      uv_causal_phase_end(phase_, async_id_);
+    if (fuzz_trace_enabled)
+      uv_trace_end(name_);
+  }
+
+ private:
+  const char* const name_;
+  const FuzzPhase phase_;
+  const int64_t async_id_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(FuzzTraceScope);
+};
+
 // If persistent.IsWeak() == false, then do not call persistent.Reset()
 // while the returned Local<T> is still in scope, it will destroy the
 // reference to the object.
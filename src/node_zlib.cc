@@ -44,6 +44,11 @@ enum node_zlib_mode {
 
 void InitZlib(v8::Local<v8::Object> target);
 
+// Async writes with at most this many bytes of input may run on the loop
+// thread instead of the threadpool, when uv_work_should_inline() agrees.
+// NODE_ZLIB_INLINE_THRESHOLD overrides it; 0 always uses the threadpool.
+static size_t inline_threshold = 1024;
+
 
 /**
  * Deflate/Inflate
@@ -188,6 +193,28 @@ class ZCtx : public AsyncWrap {
       return;
     }
 
+    // Too small to be worth a trip through the threadpool. Returns the
+    // [avail_in, avail_out] pair instead of the handle, the way writeSync()
+    // does, and the caller goes on from there.
+    if (inline_threshold > 0 && in_len <= inline_threshold &&
+        uv_work_should_inline(env->event_loop(), in_len)) {
+      Process(work_req);
+      const char* message = ErrorMessage(ctx);
+      if (message == nullptr)
+        return AfterSync(ctx, args);
+      // Not onerror: MakeCallback() would drain the tick and microtask
+      // queues inside stream.write(). Returns { message, errno } instead,
+      // and lib/zlib.js emits the error on the next tick.
+      ctx->write_in_progress_ = false;
+      ctx->Unref();
+      Local<Object> error = Object::New(env->isolate());
+      error->Set(env->message_string(),
+                 OneByteString(env->isolate(), message));
+      error->Set(env->errno_string(), Number::New(env->isolate(), ctx->err_));
+      args.GetReturnValue().Set(error);
+      return;
+    }
+
     // async version
     uv_queue_work(ctx->env()->event_loop(),
                   work_req,
@@ -267,27 +294,42 @@ class ZCtx : public AsyncWrap {
   }
 
 
-  static bool CheckError(ZCtx* ctx) {
+  // The message for a fatal ctx->err_, or nullptr if there is none.
+  // Error() prefers zlib's own message, so this does too.
+  static const char* ErrorMessage(ZCtx* ctx) {
+    const char* message;
+
     // Acceptable error states depend on the type of zlib stream.
     switch (ctx->err_) {
     case Z_OK:
     case Z_STREAM_END:
     case Z_BUF_ERROR:
       // normal statuses, not fatal
-      break;
+      return nullptr;
     case Z_NEED_DICT:
       if (ctx->dictionary_ == nullptr)
-        ZCtx::Error(ctx, "Missing dictionary");
+        message = "Missing dictionary";
       else
-        ZCtx::Error(ctx, "Bad dictionary");
-      return false;
+        message = "Bad dictionary";
+      break;
     default:
       // something else.
-      ZCtx::Error(ctx, "Zlib error");
-      return false;
+      message = "Zlib error";
+      break;
     }
 
-    return true;
+    if (ctx->strm_.msg != nullptr)
+      message = ctx->strm_.msg;
+    return message;
+  }
+
+
+  static bool CheckError(ZCtx* ctx) {
+    const char* message = ErrorMessage(ctx);
+    if (message == nullptr)
+      return true;
+    ZCtx::Error(ctx, message);
+    return false;
   }
 
 
@@ -580,6 +622,9 @@ void InitZlib(Local<Object> target,
   Environment* env = Environment::GetCurrent(context);
   Local<FunctionTemplate> z = env->NewFunctionTemplate(ZCtx::New);
 
+  if (const char* threshold = getenv("NODE_ZLIB_INLINE_THRESHOLD"))
+    inline_threshold = strtoul(threshold, nullptr, 10);
+
   z->InstanceTemplate()->SetInternalFieldCount(1);
 
   env->SetProtoMethod(z, "write", ZCtx::Write<true>);
@@ -6,6 +6,7 @@
 #include "async-wrap-inl.h"
 #include "env.h"
 #include "env-inl.h"
+#include "node_internals.h"
 #include "util.h"
 #include "util-inl.h"
 
@@ -16,6 +17,8 @@ ReqWrap<T>::ReqWrap(Environment* env,
                     v8::Local<v8::Object> object,
                     AsyncWrap::ProviderType provider)
     : AsyncWrap(env, object, provider) {
+  if (fuzz_causal_enabled)
+    uv_causal_tag(&req_, provider, get_uid());
   if (env->in_domain())
     object->Set(env->domain_string(), env->domain_array()->Get(0));
 
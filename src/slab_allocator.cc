@@ -0,0 +1,182 @@
+#include "slab_allocator.h"
+#include "env.h"
+#include "env-inl.h"
+#include "node_buffer.h"
+#include "node_internals.h"
+#include "util.h"
+#include "util-inl.h"
+
+#include <stdlib.h>  // malloc()
+
+namespace node {
+
+using v8::ArrayBuffer;
+using v8::ArrayBufferCreationMode;
+using v8::EscapableHandleScope;
+using v8::HandleScope;
+using v8::Local;
+using v8::Maybe;
+using v8::MaybeLocal;
+using v8::Object;
+using v8::Uint8Array;
+
+// Like lib/buffer.js's alignPool(), so typed arrays can view the data.
+static const size_t kAlignment = 8;
+
+
+static inline size_t RoundUp(size_t n) {
+  return (n + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+
+SlabAllocator::SlabAllocator(size_t slab_size)
+    : slab_size_(slab_size),
+      current_(nullptr),
+      retired_(nullptr) {
+}
+
+
+SlabAllocator::~SlabAllocator() {
+  // The memory belongs to the ArrayBuffers, the GC frees it.
+  if (current_ != nullptr) {
+    current_->array_buffer.Reset();
+    delete current_;
+  }
+  while (Slab* slab = retired_) {
+    retired_ = slab->next;
+    slab->array_buffer.Reset();
+    delete slab;
+  }
+}
+
+
+void SlabAllocator::Allocate(Environment* env, size_t size, uv_buf_t* buf) {
+  Slab* slab;
+
+  if (size > slab_size_) {
+    // Too big to share. Give it a slab of its own.
+    slab = NewSlab(env, size);
+    slab->next = retired_;
+    retired_ = slab;
+  } else {
+    if (current_ == nullptr || current_->size - current_->used < size) {
+      Slab* prev = current_;
+      current_ = NewSlab(env, slab_size_);
+      if (prev != nullptr && prev->pending > 0) {
+        prev->next = retired_;
+        retired_ = prev;
+      } else if (prev != nullptr) {
+        prev->array_buffer.Reset();
+        delete prev;
+      }
+    }
+    slab = current_;
+  }
+
+  buf->base = slab->data + slab->used;
+  buf->len = size;
+  slab->used = RoundUp(slab->used + size);
+  slab->pending++;
+}
+
+
+MaybeLocal<Object> SlabAllocator::Shrink(Environment* env,
+                                         const uv_buf_t* buf,
+                                         size_t nread) {
+  EscapableHandleScope scope(env->isolate());
+
+  CHECK_GT(nread, 0);
+  CHECK_LE(nread, buf->len);
+
+  if (nread < kMaxCopySize) {
+    MaybeLocal<Object> copy = Buffer::Copy(env, buf->base, nread);
+    MaybeDispose(Unreserve(buf, 0));
+    Local<Object> obj;
+    if (copy.ToLocal(&obj))
+      return scope.Escape(obj);
+    return Local<Object>();
+  }
+
+  Slab* slab = Unreserve(buf, nread);
+  Local<ArrayBuffer> ab = PersistentToLocal(env->isolate(),
+                                            slab->array_buffer);
+  Local<Uint8Array> ui = Uint8Array::New(ab, buf->base - slab->data, nread);
+  MaybeDispose(slab);
+
+  Maybe<bool> mb =
+      ui->SetPrototype(env->context(), env->buffer_prototype_object());
+  if (mb.FromMaybe(false))
+    return scope.Escape(ui);
+  return Local<Object>();
+}
+
+
+void SlabAllocator::Release(const uv_buf_t* buf) {
+  MaybeDispose(Unreserve(buf, 0));
+}
+
+
+SlabAllocator::Slab* SlabAllocator::NewSlab(Environment* env, size_t size) {
+  HandleScope scope(env->isolate());
+
+  // Allocated with malloc() because ArrayBufferAllocator::Free() releases
+  // internalized ArrayBuffers with free().
+  char* data = static_cast<char*>(malloc(size));
+  if (data == nullptr) {
+    FatalError("node::SlabAllocator::NewSlab(Environment*, size_t)",
+               "Out Of Memory");
+  }
+
+  Slab* slab = new Slab();
+  slab->array_buffer.Reset(
+      env->isolate(),
+      ArrayBuffer::New(env->isolate(),
+                       data,
+                       size,
+                       ArrayBufferCreationMode::kInternalized));
+  slab->data = data;
+  slab->size = size;
+  slab->used = 0;
+  slab->pending = 0;
+  slab->next = nullptr;
+  return slab;
+}
+
+
+SlabAllocator::Slab* SlabAllocator::Unreserve(const uv_buf_t* buf,
+                                              size_t keep) {
+  Slab* slab = current_;
+  if (slab == nullptr ||
+      buf->base < slab->data || buf->base >= slab->data + slab->size) {
+    for (slab = retired_; slab != nullptr; slab = slab->next) {
+      if (buf->base >= slab->data && buf->base < slab->data + slab->size)
+        break;
+    }
+  }
+  CHECK_NE(slab, nullptr);
+  CHECK_GT(slab->pending, 0);
+
+  // If this was the last reservation, the tail can be handed out again.
+  size_t offset = buf->base - slab->data;
+  if (RoundUp(offset + buf->len) == slab->used)
+    slab->used = RoundUp(offset + keep);
+
+  slab->pending--;
+  return slab;
+}
+
+
+void SlabAllocator::MaybeDispose(Slab* slab) {
+  if (slab == current_ || slab->pending > 0)
+    return;
+
+  Slab** prevp = &retired_;
+  while (*prevp != slab)
+    prevp = &(*prevp)->next;
+  *prevp = slab->next;
+
+  slab->array_buffer.Reset();
+  delete slab;
+}
+
+}  // namespace node
@@ -0,0 +1,76 @@
+#ifndef SRC_SLAB_ALLOCATOR_H_
+#define SRC_SLAB_ALLOCATOR_H_
+
+#include "util.h"
+#include "uv.h"
+#include "v8.h"
+
+#include <stddef.h>  // size_t
+
+namespace node {
+
+class Environment;
+
+// Hands out read buffers from large shared slabs, so a read costs no
+// malloc() and no realloc() to trim libuv's 64 KB suggestion down to size.
+//
+// Each slab is backed by one internalized ArrayBuffer. A read of fewer than
+// kMaxCopySize bytes is copied out into a Buffer of its own, so that keeping
+// a small Buffer around doesn't keep a whole slab alive. A larger read
+// becomes a Buffer that is a view on a slice of the slab, the same way
+// lib/buffer.js slices its allocPool. Its .buffer is the slab, and it keeps
+// the slab alive. A slab's memory is released by the garbage collector once
+// the allocator has moved on to the next slab and no Buffer refers to it.
+//
+// Not thread safe; use from the thread that owns the Environment.
+class SlabAllocator {
+ public:
+  static const size_t kDefaultSlabSize = 1024 * 1024;
+  // Like lib/buffer.js's Buffer.poolSize.
+  static const size_t kMaxCopySize = 8 * 1024;
+
+  explicit SlabAllocator(size_t slab_size = kDefaultSlabSize);
+  ~SlabAllocator();
+
+  // Reserve |size| bytes for a read. Call Shrink() or Release() on |buf|
+  // before the next turn of the event loop.
+  void Allocate(Environment* env, size_t size, uv_buf_t* buf);
+
+  // Returns a Buffer of the first |nread| bytes of |buf| and gives the rest
+  // of the reservation back. |nread| must be > 0. The Buffer is a copy if
+  // |nread| < kMaxCopySize and a view on the slab otherwise.
+  v8::MaybeLocal<v8::Object> Shrink(Environment* env,
+                                    const uv_buf_t* buf,
+                                    size_t nread);
+
+  // Give back a reservation that produced no data.
+  void Release(const uv_buf_t* buf);
+
+ private:
+  struct Slab {
+    v8::Persistent<v8::ArrayBuffer> array_buffer;
+    char* data;
+    size_t size;
+    size_t used;
+    size_t pending;  // Reservations not yet shrunk or released.
+    Slab* next;  // In retired_.
+  };
+
+  Slab* NewSlab(Environment* env, size_t size);
+  // Returns the slab |buf| was reserved from and drops its reservation.
+  Slab* Unreserve(const uv_buf_t* buf, size_t keep);
+  // Drops our reference to |slab| once it is retired and has no reservations.
+  void MaybeDispose(Slab* slab);
+
+  const size_t slab_size_;
+  Slab* current_;
+  // Slabs we have moved on from that still have reservations. Rare: libuv
+  // reads right after it allocates.
+  Slab* retired_;
+
+  DISALLOW_COPY_AND_ASSIGN(SlabAllocator);
+};
+
+}  // namespace node
+
+#endif  // SRC_SLAB_ALLOCATOR_H_
@@ -154,14 +154,8 @@ void StreamWrap::OnAlloc(uv_handle_t* handle,
 
 
 void StreamWrap::OnAllocImpl(size_t size, uv_buf_t* buf, void* ctx) {
-  buf->base = static_cast<char*>(malloc(size));
-  buf->len = size;
-
-  if (buf->base == nullptr && size > 0) {
-    FatalError(
-        "node::StreamWrap::DoAlloc(size_t, uv_buf_t*, void*)",
-        "Out Of Memory");
-  }
+  StreamWrap* wrap = static_cast<StreamWrap*>(ctx);
+  wrap->env()->read_slab_allocator()->Allocate(wrap->env(), size, buf);
 }
 
 
@@ -196,21 +190,23 @@ void StreamWrap::OnReadImpl(ssize_t nread,
 
   Local<Object> pending_obj;
 
+  SlabAllocator* allocator = env->read_slab_allocator();
+
   if (nread < 0)  {
     if (buf->base != nullptr)
-      free(buf->base);
+      allocator->Release(buf);
     wrap->EmitData(nread, Local<Object>(), pending_obj);
     return;
   }
 
   if (nread == 0) {
     if (buf->base != nullptr)
-      free(buf->base);
+      allocator->Release(buf);
     return;
   }
 
-  char* base = static_cast<char*>(realloc(buf->base, nread));
   CHECK_LE(static_cast<size_t>(nread), buf->len);
+  Local<Object> obj = allocator->Shrink(env, buf, nread).ToLocalChecked();
 
   if (pending == UV_TCP) {
     pending_obj = AcceptHandle<TCPWrap, uv_tcp_t>(env, wrap);
@@ -222,7 +218,6 @@ void StreamWrap::OnReadImpl(ssize_t nread,
     CHECK_EQ(pending, UV_UNKNOWN_HANDLE);
   }
 
-  Local<Object> obj = Buffer::New(env, base, nread).ToLocalChecked();
   wrap->EmitData(nread, obj, pending_obj);
 }
 
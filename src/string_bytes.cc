@@ -7,6 +7,21 @@
 #include <limits.h>
 #include <string.h>  // memcpy
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NODE_STRING_BYTES_SSE2 1
+#endif
+
+// SSSE3 is not part of the x86-64 baseline, so those kernels are built with
+// a target attribute and only used when the CPU turns out to support it.
+#if defined(NODE_STRING_BYTES_SSE2) && defined(__GNUC__) &&                    \
+    (defined(__clang__) || __GNUC__ > 4 ||                                     \
+     (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <tmmintrin.h>
+#define NODE_STRING_BYTES_SSSE3 1
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
 // When creating strings >= this length v8's gc spins up and consumes
 // most of the execution time. For these cases it's more performant to
 // use external string resources.
@@ -164,6 +179,86 @@ static const int8_t unbase64_table[] =
   static_cast<uint8_t>(unbase64_table[static_cast<uint8_t>(x)])
 
 
+#ifdef NODE_STRING_BYTES_SSE2
+// Sixteen characters, narrowed to one byte each. Two-byte characters that
+// don't fit come out as 0x00 or 0xFF, which no decoder accepts.
+static inline __m128i load_chars(const char* src) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+
+static inline __m128i load_chars(const uint16_t* src) {
+  const __m128i* p = reinterpret_cast<const __m128i*>(src);
+  return _mm_packus_epi16(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+}
+
+
+// All ones in the bytes that are in [lo, hi]. The comparison is signed, so
+// bytes >= 0x80 never are.
+static inline __m128i in_range(__m128i v, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+#endif  // NODE_STRING_BYTES_SSE2
+
+
+#ifdef NODE_STRING_BYTES_SSSE3
+static bool has_ssse3() {
+  static const bool has_it =
+      (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+  return has_it;
+}
+
+
+// Decodes blocks of 16 characters for as long as they are all valid base64
+// and there is room. Returns the number of characters consumed; every 4 of
+// them make 3 bytes of |dst|.
+template <typename TypeName>
+TARGET_SSSE3 size_t base64_decode_ssse3(char* const dst, const size_t dstlen,
+                                        const TypeName* const src,
+                                        const size_t srclen) {
+  size_t i = 0;
+  size_t k = 0;
+  for (; i + 16 <= srclen && k + 12 <= dstlen; i += 16, k += 12) {
+    const __m128i c = load_chars(src + i);
+    const __m128i upper = in_range(c, 'A', 'Z');
+    const __m128i lower = in_range(c, 'a', 'z');
+    const __m128i digit = in_range(c, '0', '9');
+    const __m128i plus = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('+')),
+                                      _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+    const __m128i slash = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('/')),
+                                       _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+    const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+                                       _mm_or_si128(digit,
+                                                    _mm_or_si128(plus, slash)));
+    // Whitespace, padding or garbage; the scalar code takes it from here.
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+      break;
+
+    __m128i v = _mm_and_si128(upper, _mm_sub_epi8(c, _mm_set1_epi8('A')));
+    v = _mm_or_si128(v, _mm_and_si128(lower,
+                                      _mm_sub_epi8(c, _mm_set1_epi8('a' - 26))));
+    v = _mm_or_si128(v, _mm_and_si128(digit,
+                                      _mm_sub_epi8(c, _mm_set1_epi8('0' - 52))));
+    v = _mm_or_si128(v, _mm_and_si128(plus, _mm_set1_epi8(62)));
+    v = _mm_or_si128(v, _mm_and_si128(slash, _mm_set1_epi8(63)));
+
+    // Pack the four 6-bit values of each 32-bit lane into 24 bits, then put
+    // those bytes in order with the fourth byte of every lane left out.
+    v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+    v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                          14, 13, 12, -1, -1, -1, -1));
+    // Exactly 12 bytes; what follows in |dst| is not ours to scribble on.
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + k), v);
+    const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+    memcpy(dst + k + 8, &tail, sizeof(tail));
+  }
+  return i;
+}
+#endif  // NODE_STRING_BYTES_SSSE3
+
+
 template <typename TypeName>
 size_t base64_decode_slow(char* dst, size_t dstlen,
                           const TypeName* src, size_t srclen) {
@@ -207,6 +302,12 @@ size_t base64_decode_fast(char* const dst, const size_t dstlen,
   const size_t max_k = available / 3 * 3;
   size_t i = 0;
   size_t k = 0;
+#ifdef NODE_STRING_BYTES_SSSE3
+  if (has_ssse3()) {
+    i = base64_decode_ssse3(dst, max_k, src, max_i);
+    k = i / 4 * 3;
+  }
+#endif
   while (i < max_i && k < max_k) {
     const uint32_t v =
         unbase64(src[i + 0]) << 24 |
@@ -250,13 +351,61 @@ unsigned hex2bin(TypeName c) {
 }
 
 
+#ifdef NODE_STRING_BYTES_SSE2
+// The values of sixteen hex digits, or false if any of them isn't one.
+static inline bool hex_values(const __m128i chars, __m128i* values) {
+  const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  const __m128i digit = in_range(chars, '0', '9');
+  const __m128i alpha = in_range(lower, 'a', 'f');
+  if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF)
+    return false;
+  *values = _mm_or_si128(
+      _mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+      _mm_and_si128(alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+  return true;
+}
+
+
+// Each 16-bit lane holds a (high, low) pair of digit values.
+static inline __m128i hex_pairs(const __m128i values) {
+  const __m128i high = _mm_and_si128(values, _mm_set1_epi16(0xFF));
+  return _mm_or_si128(_mm_slli_epi16(high, 4), _mm_srli_epi16(values, 8));
+}
+
+
+// Decodes blocks of 32 hex digits up to the first one with a bad digit in
+// it. Returns the number of bytes written.
+template <typename TypeName>
+size_t hex_decode_sse2(char* buf,
+                       size_t len,
+                       const TypeName* src,
+                       const size_t srcLen) {
+  size_t i;
+  for (i = 0; i + 16 <= len && i * 2 + 32 <= srcLen; i += 16) {
+    __m128i a;
+    __m128i b;
+    if (!hex_values(load_chars(src + i * 2), &a) ||
+        !hex_values(load_chars(src + i * 2 + 16), &b)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf + i),
+                     _mm_packus_epi16(hex_pairs(a), hex_pairs(b)));
+  }
+  return i;
+}
+#endif  // NODE_STRING_BYTES_SSE2
+
+
 template <typename TypeName>
 size_t hex_decode(char* buf,
                   size_t len,
                   const TypeName* src,
                   const size_t srcLen) {
-  size_t i;
-  for (i = 0; i < len && i * 2 + 1 < srcLen; ++i) {
+  size_t i = 0;
+#ifdef NODE_STRING_BYTES_SSE2
+  i = hex_decode_sse2(buf, len, src, srcLen);
+#endif
+  for (; i < len && i * 2 + 1 < srcLen; ++i) {
     unsigned a = hex2bin(src[i * 2 + 0]);
     unsigned b = hex2bin(src[i * 2 + 1]);
     if (!~a || !~b)
@@ -670,6 +819,47 @@ static void force_ascii(const char* src, char* dst, size_t len) {
 }
 
 
+#ifdef NODE_STRING_BYTES_SSSE3
+// Encodes blocks of 12 bytes into 16 characters, reading 16 bytes at a time.
+// Returns the number of bytes consumed.
+TARGET_SSSE3 static size_t base64_encode_ssse3(const char* src,
+                                               size_t slen,
+                                               char* dst) {
+  size_t i = 0;
+  size_t k = 0;
+  for (; i + 16 <= slen; i += 12, k += 16) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Spread every 3 bytes over a 32-bit lane and cut them into 6-bit
+    // indices, one per byte.
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i hi = _mm_mulhi_epu16(
+        _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)),
+        _mm_set1_epi32(0x04000040));
+    const __m128i lo = _mm_mullo_epi16(
+        _mm_and_si128(in, _mm_set1_epi32(0x003F03F0)),
+        _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(hi, lo);
+
+    // Every range of the alphabet is a fixed offset from its indices.
+    // Number the ranges 0 (a-z), 1-10 (0-9), 11 (+), 12 (/) and 13 (A-Z)
+    // and look the offset up.
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k),
+                     _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range)));
+  }
+  return i;
+}
+#endif  // NODE_STRING_BYTES_SSSE3
+
+
 static size_t base64_encode(const char* src,
                             size_t slen,
                             char* dst,
@@ -695,6 +885,13 @@ static size_t base64_encode(const char* src,
   k = 0;
   n = slen / 3 * 3;
 
+#ifdef NODE_STRING_BYTES_SSSE3
+  if (has_ssse3()) {
+    i = base64_encode_ssse3(src, slen, dst);
+    k = i / 3 * 4;
+  }
+#endif
+
   while (i < n) {
     a = src[i + 0] & 0xff;
     b = src[i + 1] & 0xff;
@@ -734,13 +931,36 @@ static size_t base64_encode(const char* src,
 }
 
 
+#ifdef NODE_STRING_BYTES_SSE2
+// '0'-'9' or 'a'-'f' for each nibble.
+static inline __m128i hex_digits(const __m128i nibbles) {
+  const __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                      _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+}
+#endif  // NODE_STRING_BYTES_SSE2
+
+
 static size_t hex_encode(const char* src, size_t slen, char* dst, size_t dlen) {
   // We know how much we'll write, just make sure that there's space.
   CHECK(dlen >= slen * 2 &&
       "not enough space provided for hex encode");
 
   dlen = slen * 2;
-  for (uint32_t i = 0, k = 0; k < dlen; i += 1, k += 2) {
+  size_t i = 0;
+#ifdef NODE_STRING_BYTES_SSE2
+  const __m128i low4 = _mm_set1_epi8(0x0F);
+  for (; i + 16 <= slen; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i hi = hex_digits(_mm_and_si128(_mm_srli_epi16(v, 4), low4));
+    const __m128i lo = hex_digits(_mm_and_si128(v, low4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2),
+                     _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+#endif
+  for (size_t k = i * 2; k < dlen; i += 1, k += 2) {
     static const char hex[] = "0123456789abcdef";
     uint8_t val = static_cast<uint8_t>(src[i]);
     dst[k + 0] = hex[val >> 4];
@@ -342,13 +342,9 @@ void UDPWrap::OnSend(uv_udp_send_t* req, int status) {
 void UDPWrap::OnAlloc(uv_handle_t* handle,
                       size_t suggested_size,
                       uv_buf_t* buf) {
-  buf->base = static_cast<char*>(malloc(suggested_size));
-  buf->len = suggested_size;
-
-  if (buf->base == nullptr && suggested_size > 0) {
-    FatalError("node::UDPWrap::OnAlloc(uv_handle_t*, size_t, uv_buf_t*)",
-               "Out Of Memory");
-  }
+  UDPWrap* wrap = static_cast<UDPWrap*>(handle->data);
+  Environment* env = wrap->env();
+  env->read_slab_allocator()->Allocate(env, suggested_size, buf);
 }
 
 
@@ -357,15 +353,16 @@ void UDPWrap::OnRecv(uv_udp_t* handle,
                      const uv_buf_t* buf,
                      const struct sockaddr* addr,
                      unsigned int flags) {
+  UDPWrap* wrap = static_cast<UDPWrap*>(handle->data);
+  Environment* env = wrap->env();
+  SlabAllocator* allocator = env->read_slab_allocator();
+
   if (nread == 0 && addr == nullptr) {
     if (buf->base != nullptr)
-      free(buf->base);
+      allocator->Release(buf);
     return;
   }
 
-  UDPWrap* wrap = static_cast<UDPWrap*>(handle->data);
-  Environment* env = wrap->env();
-
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -379,13 +376,18 @@ void UDPWrap::OnRecv(uv_udp_t* handle,
 
   if (nread < 0) {
     if (buf->base != nullptr)
-      free(buf->base);
+      allocator->Release(buf);
     wrap->MakeCallback(env->onmessage_string(), ARRAY_SIZE(argv), argv);
     return;
   }
 
-  char* base = static_cast<char*>(realloc(buf->base, nread));
-  argv[2] = Buffer::New(env, base, nread).ToLocalChecked();
+  if (nread == 0) {
+    // An empty datagram.
+    allocator->Release(buf);
+    argv[2] = Buffer::New(env, 0).ToLocalChecked();
+  } else {
+    argv[2] = allocator->Shrink(env, buf, nread).ToLocalChecked();
+  }
   argv[3] = AddressToJS(env, addr);
   wrap->MakeCallback(env->onmessage_string(), ARRAY_SIZE(argv), argv);
 }
@@ -0,0 +1,85 @@
+'use strict';
+// hex and base64 over buffers long enough for the vectorized loops, with
+// the odd bytes at every position a block boundary could fall on.
+require('../common');
+const assert = require('assert');
+
+const table = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+
+function base64(buf) {
+  var out = '';
+  for (var i = 0; i < buf.length; i += 3) {
+    const n = buf[i] << 16 | (buf[i + 1] | 0) << 8 | (buf[i + 2] | 0);
+    out += table[n >> 18] + table[n >> 12 & 63] +
+           (i + 1 < buf.length ? table[n >> 6 & 63] : '=') +
+           (i + 2 < buf.length ? table[n & 63] : '=');
+  }
+  return out;
+}
+
+function hex(buf) {
+  var out = '';
+  for (var i = 0; i < buf.length; i++)
+    out += (buf[i] < 16 ? '0' : '') + buf[i].toString(16);
+  return out;
+}
+
+const sizes = [0, 1, 11, 12, 13, 15, 16, 17, 31, 32, 33, 47, 48, 49, 100, 1024,
+               4099];
+sizes.forEach(function(size) {
+  const buf = new Buffer(size);
+  for (var i = 0; i < size; i++)
+    buf[i] = (i * 131 + (i >> 3)) & 255;
+
+  const b64 = base64(buf);
+  assert.strictEqual(buf.toString('base64'), b64);
+  assert.deepStrictEqual(new Buffer(b64, 'base64'), buf);
+  const urlsafe = b64.replace(/\+/g, '-').replace(/\//g, '_');
+  assert.deepStrictEqual(new Buffer(urlsafe, 'base64'), buf);
+  // A string that can't be stored one byte per character.
+  assert.deepStrictEqual(new Buffer(b64 + '☃', 'base64'), buf);
+
+  const h = hex(buf);
+  assert.strictEqual(buf.toString('hex'), h);
+  assert.deepStrictEqual(new Buffer(h, 'hex'), buf);
+  assert.deepStrictEqual(new Buffer(h.toUpperCase(), 'hex'), buf);
+});
+
+const big = new Buffer(4096);
+for (var i = 0; i < big.length; i++)
+  big[i] = i & 255;
+const b64 = big.toString('base64');
+const h = big.toString('hex');
+[0, 1, 15, 16, 17, 31, 32, 33, 1000, 2047].forEach(function(pos) {
+  // Whitespace in base64 is skipped.
+  const spaced = b64.slice(0, pos) + ' \n' + b64.slice(pos);
+  assert.deepStrictEqual(new Buffer(spaced, 'base64'), big);
+
+  // Hex decoding stops at the first pair with a bad digit.
+  const bad = h.slice(0, pos * 2) + 'zz' + h.slice(pos * 2 + 2);
+  assert.deepStrictEqual(new Buffer(bad, 'hex'), big.slice(0, pos));
+  const wide = h.slice(0, pos * 2) + 'İ' + h.slice(pos * 2 + 1);
+  assert.deepStrictEqual(new Buffer(wide, 'hex'), big.slice(0, pos));
+
+  // Decoding into a short window leaves the bytes after it alone.
+  const chunk = b64.substr(pos * 4 % 4096, 64);
+  const target = new Buffer(64).fill(0xAA);
+  assert.strictEqual(target.write(chunk, 0, 20, 'base64'), 20);
+  assert.deepStrictEqual(target.slice(0, 20),
+                         new Buffer(chunk, 'base64').slice(0, 20));
+  assert.deepStrictEqual(target.slice(20), new Buffer(44).fill(0xAA));
+});
+
+// indexOf() on large buffers, with many near misses before the match.
+const haystack = new Buffer(1 << 16).fill('a');
+haystack.write('ab', 40000);
+assert.strictEqual(haystack.indexOf('ab'), 40000);
+assert.strictEqual(haystack.indexOf(new Buffer('ab')), 40000);
+assert.strictEqual(haystack.indexOf('ab', 40001), -1);
+assert.strictEqual(haystack.indexOf('b'), 40001);
+assert.strictEqual(haystack.indexOf('aaab'), 39998);
+assert.strictEqual(haystack.indexOf('ba'), 40001);
+assert.strictEqual(haystack.indexOf('aaa', haystack.length - 3),
+                   haystack.length - 3);
+assert.strictEqual(haystack.indexOf('aaa', haystack.length - 2), -1);
+assert.strictEqual(haystack.indexOf('c'), -1);
@@ -0,0 +1,51 @@
+'use strict';
+// The on-disk code cache (--code-cache-dir) is filled on the first run,
+// used on the next, and survives a corrupt entry.
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const spawnSync = require('child_process').spawnSync;
+
+common.refreshTmpDir();
+const cacheDir = path.join(common.tmpDir, 'code-cache');
+fs.mkdirSync(cacheDir);
+
+const script = 'require("http"); require("util"); console.log("ok");';
+
+function run(args, env) {
+  const child = spawnSync(process.execPath,
+                          args.concat('-e', script),
+                          { env: Object.assign({}, process.env, env) });
+  assert.strictEqual(child.status, 0, child.stderr.toString());
+  assert.strictEqual(child.stdout.toString(), 'ok\n');
+}
+
+function entries() {
+  return fs.readdirSync(cacheDir).filter(function(name) {
+    return /^[0-9a-f]{16}\.v8cache$/.test(name);
+  }).sort();
+}
+
+const flag = ['--code-cache-dir=' + cacheDir];
+
+run(flag);
+const filled = entries();
+assert(filled.length > 0, 'expected cache entries in ' + cacheDir);
+
+run(flag);
+assert.deepStrictEqual(entries(), filled);
+
+// A corrupt entry is replaced, and the code still runs.
+const corrupt = path.join(cacheDir, filled[0]);
+fs.writeFileSync(corrupt, 'garbage');
+run(flag);
+assert.deepStrictEqual(entries(), filled);
+assert.notStrictEqual(fs.readFileSync(corrupt, 'binary'), 'garbage');
+
+// NODE_CODE_CACHE_DIR does the same as the flag.
+filled.forEach(function(name) {
+  fs.unlinkSync(path.join(cacheDir, name));
+});
+run([], { NODE_CODE_CACHE_DIR: cacheDir });
+assert.deepStrictEqual(entries(), filled);
@@ -55,6 +55,27 @@ function ondone(err, key) {
   assert.equal(key.toString('hex'), expected);
 }
 
+// Async keys longer than one digest block are derived in several threadpool
+// requests, a range of blocks each. They match the single pass of the sync
+// version, including when the last block is only partly used.
+[['sha1', 20 * 9 + 7], ['sha256', 32 * 4], ['sha512', 64 * 3 + 1]].forEach(
+  function(args) {
+    var digest = args[0];
+    var keylen = args[1];
+    var sync = crypto.pbkdf2Sync('secret', 'salt', 10, keylen, digest);
+    assert.equal(sync.length, keylen);
+    crypto.pbkdf2('secret', 'salt', 10, keylen, digest,
+                  common.mustCall(function(err, key) {
+                    if (err) throw err;
+                    assert.equal(key.toString('hex'), sync.toString('hex'));
+                  }));
+  });
+
+crypto.pbkdf2('password', 'salt', 1, 0, common.mustCall(function(err, key) {
+  if (err) throw err;
+  assert.equal(key.length, 0);
+}));
+
 // Error path should not leak memory (check with valgrind).
 assert.throws(function() {
   crypto.pbkdf2('password', 'salt', 1, 20, null);
@@ -37,6 +37,21 @@ process.setMaxListeners(256);
   });
 });
 
+// Large requests are filled in several threadpool requests, as many at a
+// time as there are threads in the pool.
+crypto.randomBytes(1024 * 1024 + 3, common.mustCall(function(ex, buf) {
+  assert.equal(null, ex);
+  assert.equal(buf.length, 1024 * 1024 + 3);
+  // Each part got filled, not just the first.
+  for (var i = 1; i <= 4; i++) {
+    var zeros = 0;
+    var end = buf.length * i / 4 | 0;
+    for (var j = end - 64; j < end; j++)
+      if (buf[j] === 0) zeros++;
+    assert(zeros < 64);
+  }
+}));
+
 // assert that the callback is indeed called
 function checkCall(cb, desc) {
   var called_ = false;
@@ -0,0 +1,46 @@
+'use strict';
+// Large datagrams are slices of a shared slab. Check that a message from an
+// earlier read is not overwritten by later reads, including once the slab
+// is full. Small datagrams are copied out, so they don't keep the slab alive.
+var common = require('../common');
+var assert = require('assert');
+var dgram = require('dgram');
+
+var N = 500;
+var SMALL = 1000;
+var LARGE = 20000;  // Every other message. N * LARGE / 2 spans several slabs.
+var messages = [];
+
+function size(i) {
+  return i % 2 ? SMALL : LARGE;
+}
+
+var client = dgram.createSocket('udp4');
+var server = dgram.createSocket('udp4', function(msg, rinfo) {
+  messages.push(msg);
+  if (messages.length < N)
+    send();
+  else {
+    server.close();
+    client.close();
+  }
+});
+
+function send() {
+  var buf = new Buffer(size(messages.length));
+  buf.fill(messages.length % 256);
+  client.send(buf, 0, buf.length, common.PORT, common.localhostIPv4);
+}
+
+server.bind(common.PORT, common.localhostIPv4, send);
+
+process.on('exit', function() {
+  assert.strictEqual(messages.length, N);
+  messages.forEach(function(msg, i) {
+    assert.strictEqual(msg.length, size(i));
+    for (var j = 0; j < size(i); j++)
+      assert.strictEqual(msg[j], i % 256);
+    if (msg.length === SMALL)
+      assert.strictEqual(msg.buffer.byteLength, msg.length);
+  });
+});
@@ -0,0 +1,74 @@
+'use strict';
+// With NODE_FORK_SERVER_POINT=bootstrap, every run forked from the fork
+// server runs the main script.
+const common = require('../common');
+const assert = require('assert');
+const spawn = require('child_process').spawn;
+
+if (process.platform !== 'linux') {
+  console.log('1..0 # Skipped: the fork server is Linux only');
+  return;
+}
+
+const RUNS = 3;
+
+const env = Object.assign({}, process.env, {
+  UV_SILENT: '1',
+  UV_FORK_SERVER_FD: '3',
+  NODE_FORK_SERVER_POINT: 'bootstrap'
+});
+const server = spawn(process.execPath,
+                     ['-e', 'console.log("run " + process.pid)'],
+                     { env: env, stdio: ['ignore', 'pipe', 'inherit',
+                                         'pipe', 'pipe'] });
+const control = server.stdio[3];
+const status = server.stdio[4];
+
+let output = '';
+server.stdout.setEncoding('utf8');
+server.stdout.on('data', function(data) {
+  output += data;
+});
+
+let pending = new Buffer(0);
+let ready = false;
+const pids = [];
+
+function request() {
+  const seed = new Buffer(4);
+  seed.writeUInt32LE(pids.length + 1, 0);
+  control.write(seed);
+}
+
+status.on('data', function(data) {
+  pending = Buffer.concat([pending, data]);
+
+  if (!ready) {
+    if (pending.length < 4)
+      return;
+    assert.strictEqual(pending.readInt32LE(0), 0);
+    pending = pending.slice(4);
+    ready = true;
+    return request();
+  }
+
+  if (pending.length < 16)
+    return;
+  pids.push(pending.readInt32LE(0));
+  assert.strictEqual(pending.readInt32LE(4), 0, 'run exited with an error');
+  pending = pending.slice(16);
+
+  if (pids.length < RUNS)
+    request();
+  else
+    control.end();
+});
+
+server.on('close', common.mustCall(function(code) {
+  assert.strictEqual(code, 0);
+  assert.strictEqual(pids.length, RUNS);
+  const ran = output.trim().split('\n').sort();
+  assert.deepStrictEqual(ran, pids.map(function(pid) {
+    return 'run ' + pid;
+  }).sort());
+}));
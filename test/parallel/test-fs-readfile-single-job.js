@@ -0,0 +1,69 @@
+'use strict';
+// fs.readFile() and fs.readFileSync() read through binding.readFile(), in one
+// threadpool job, everywhere but Windows.
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+
+if (common.isWindows) {
+  console.log('1..0 # Skipped: binding.readFile() is not used on Windows');
+  return;
+}
+
+common.refreshTmpDir();
+
+const big = path.join(common.tmpDir, 'big.txt');
+const expected = new Buffer(256 * 1024);
+for (var i = 0; i < expected.length; i++)
+  expected[i] = 'a'.charCodeAt(0) + i % 26;
+fs.writeFileSync(big, expected);
+
+assert.deepStrictEqual(fs.readFileSync(big), expected);
+assert.strictEqual(fs.readFileSync(big, 'utf8'), expected.toString());
+
+fs.readFile(big, common.mustCall(function(err, data) {
+  assert.ifError(err);
+  assert.deepStrictEqual(data, expected);
+}));
+
+fs.readFile(big, 'hex', common.mustCall(function(err, data) {
+  assert.ifError(err);
+  assert.strictEqual(data, expected.toString('hex'));
+}));
+
+// The size fstat() reports is zero, the contents are not.
+if (process.platform === 'linux') {
+  assert(/^Name:/.test(fs.readFileSync('/proc/self/status', 'utf8')));
+  fs.readFile('/proc/self/status', 'utf8', common.mustCall(function(err, d) {
+    assert.ifError(err);
+    assert(/^Name:/.test(d));
+  }));
+}
+
+// Flags are honoured: 'a+' creates the file.
+const created = path.join(common.tmpDir, 'created.txt');
+assert.strictEqual(fs.readFileSync(created, { flag: 'a+' }).length, 0);
+assert(fs.existsSync(created));
+
+const missing = path.join(common.tmpDir, 'missing.txt');
+// Errors name the step that failed, as the open/read path did.
+assert.throws(function() {
+  fs.readFileSync(missing);
+}, /^Error: ENOENT: no such file or directory, open '.*missing\.txt'$/);
+fs.readFile(missing, common.mustCall(function(err, data) {
+  assert.strictEqual(err.code, 'ENOENT');
+  assert.strictEqual(err.syscall, 'open');
+  assert.strictEqual(err.path, missing);
+  assert.strictEqual(data, undefined);
+}));
+
+if (process.platform !== 'freebsd') {
+  assert.throws(function() {
+    fs.readFileSync(common.tmpDir);
+  }, /EISDIR: illegal operation on a directory, read/);
+  fs.readFile(common.tmpDir, common.mustCall(function(err) {
+    assert.strictEqual(err.code, 'EISDIR');
+    assert.strictEqual(err.syscall, 'read');
+  }));
+}
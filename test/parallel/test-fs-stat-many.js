@@ -0,0 +1,88 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+
+common.refreshTmpDir();
+
+const file = path.join(common.tmpDir, 'file');
+const dir = path.join(common.tmpDir, 'dir');
+const missing = path.join(common.tmpDir, 'missing');
+fs.writeFileSync(file, 'abc');
+fs.mkdirSync(dir);
+
+const paths = [file, dir, missing, __filename];
+
+function check(results, stat) {
+  assert.strictEqual(results.length, paths.length);
+
+  assert.strictEqual(results.error(0), null);
+  assert(results.isFile(0));
+  assert(!results.isDirectory(0));
+  assert.strictEqual(results.get(0).size, 3);
+
+  assert(results.isDirectory(1));
+  assert(results.get(1).isDirectory());
+
+  // Same error as fs.statSync() throws.
+  const err = results.error(2);
+  assert.throws(function() {
+    stat(missing);
+  }, function(expected) {
+    return expected.message === err.message &&
+           expected.errno === err.errno &&
+           expected.code === err.code &&
+           expected.syscall === err.syscall &&
+           expected.path === err.path;
+  });
+  assert.strictEqual(err.code, 'ENOENT');
+  assert.strictEqual(err.path, missing);
+  assert.strictEqual(results.get(2), null);
+  assert(!results.isFile(2));
+
+  // Same as what fs.statSync() returns, field for field.
+  const expected = stat(__filename);
+  const actual = results.get(3);
+  assert(actual instanceof fs.Stats);
+  Object.keys(expected).forEach(function(key) {
+    if (expected[key] instanceof Date)
+      assert.strictEqual(actual[key].getTime(), expected[key].getTime(), key);
+    else
+      assert.strictEqual(actual[key], expected[key], key);
+  });
+}
+
+check(fs.statManySync(paths), fs.statSync);
+check(fs.lstatManySync(paths), fs.lstatSync);
+
+fs.statMany(paths, common.mustCall(function(err, results) {
+  assert.ifError(err);
+  check(results, fs.statSync);
+}));
+
+fs.statMany([], common.mustCall(function(err, results) {
+  assert.ifError(err);
+  assert.strictEqual(results.length, 0);
+}));
+
+if (!common.isWindows) {
+  const link = path.join(common.tmpDir, 'link');
+  fs.symlinkSync(file, link);
+  assert(fs.lstatManySync([link]).isSymbolicLink(0));
+  assert(fs.statManySync([link]).isFile(0));
+  fs.lstatMany([link], common.mustCall(function(err, results) {
+    assert.ifError(err);
+    assert(results.isSymbolicLink(0));
+  }));
+}
+
+assert.throws(function() {
+  fs.statManySync('not an array');
+}, TypeError);
+assert.throws(function() {
+  fs.statManySync([file, 42]);
+}, TypeError);
+fs.statMany(['a\u0000b'], common.mustCall(function(err) {
+  assert.strictEqual(err.code, 'ENOENT');
+}));
@@ -0,0 +1,77 @@
+'use strict';
+// Large reads are slices of a shared slab. Check that a Buffer from an
+// earlier read is not overwritten by later reads, including once the slab is
+// full. Small reads are copied out, so they don't keep the slab alive.
+var common = require('../common');
+var assert = require('assert');
+var net = require('net');
+
+var N = 200;
+var SMALL = 1000;
+var LARGE = 20000;  // Every other message. N * LARGE / 2 spans several slabs.
+var chunks = [];
+
+function size(i) {
+  return i % 2 ? SMALL : LARGE;
+}
+
+var server = net.createServer(function(socket) {
+  var sent = 0;
+
+  function send() {
+    var buf = new Buffer(size(sent));
+    buf.fill(sent % 256);
+    socket.write(buf);
+    sent++;
+  }
+
+  // One write in flight at a time, so a small one arrives as a read of its
+  // own.
+  socket.on('data', function() {
+    if (sent < N)
+      send();
+    else
+      socket.end();
+  });
+  send();
+});
+
+server.listen(common.PORT, function() {
+  var received = 0;
+  var acked = 0;
+  var end = size(0);
+  var conn = net.connect(common.PORT);
+
+  conn.on('data', function(buf) {
+    chunks.push(buf);
+    received += buf.length;
+    while (received >= end && acked < N) {
+      conn.write('x');
+      acked++;
+      end += size(acked);
+    }
+  });
+
+  conn.on('end', function() {
+    server.close();
+  });
+});
+
+process.on('exit', function() {
+  var all = Buffer.concat(chunks);
+  var offset = 0;
+  for (var i = 0; i < N; i++) {
+    for (var j = 0; j < size(i); j++)
+      assert.strictEqual(all[offset + j], i % 256);
+    offset += size(i);
+  }
+  assert.strictEqual(all.length, offset);
+
+  var small = chunks.filter(function(buf) {
+    return buf.length === SMALL;
+  });
+  assert(small.length >= N / 2);
+  small.forEach(function(buf) {
+    assert.strictEqual(buf.buffer.byteLength, buf.length);
+  });
+});
@@ -0,0 +1,90 @@
+'use strict';
+// Small writes run on the main thread (NODE_ZLIB_INLINE_THRESHOLD), and with
+// coalesceWrites the writes queued behind a busy stream go through as one.
+const common = require('../common');
+const assert = require('assert');
+const spawnSync = require('child_process').spawnSync;
+const zlib = require('zlib');
+
+const small = new Buffer('hello zlib '.repeat(8));
+const big = new Buffer(256 * 1024);
+for (var i = 0; i < big.length; i++)
+  big[i] = i % 251;
+
+function roundTrip(opts, pieces, cb) {
+  const gzip = zlib.createGzip(opts);
+  const gunzip = zlib.createGunzip();
+  const chunks = [];
+  var transforms = 0;
+  const transform = gzip._transform;
+  gzip._transform = function(chunk, encoding, done) {
+    transforms++;
+    return transform.call(this, chunk, encoding, done);
+  };
+  gunzip.on('data', function(chunk) {
+    chunks.push(chunk);
+  });
+  gunzip.on('end', common.mustCall(function() {
+    assert.deepStrictEqual(Buffer.concat(chunks), Buffer.concat(pieces));
+    cb(transforms);
+  }));
+  gzip.pipe(gunzip);
+  pieces.forEach(function(piece) {
+    gzip.write(piece);
+  });
+  gzip.end();
+}
+
+const many = [];
+for (var j = 0; j < 100; j++)
+  many.push(small);
+
+if (process.argv[2] === 'child') {
+  // Everything goes through the threadpool here, so the writes queue up.
+  roundTrip({ coalesceWrites: true }, many, function(transforms) {
+    assert(transforms < many.length, transforms + ' transforms');
+  });
+  roundTrip({ coalesceWrites: false }, many, function(transforms) {
+    // One per write, plus the Z_FINISH for end().
+    assert.strictEqual(transforms, many.length + 1);
+  });
+  roundTrip({}, many, function(transforms) {
+    // NODE_ZLIB_COALESCE_WRITES=1 is in the environment.
+    assert(transforms < many.length, transforms + ' transforms');
+  });
+  return;
+}
+
+[{}, { coalesceWrites: true }].forEach(function(opts) {
+  roundTrip(opts, many, common.mustCall(function() {}));
+  roundTrip(opts, [small], common.mustCall(function() {}));
+  roundTrip(opts, [big, small, big], common.mustCall(function() {}));
+});
+
+zlib.gzip(small, common.mustCall(function(err, compressed) {
+  assert.ifError(err);
+  assert.deepStrictEqual(zlib.gunzipSync(compressed), small);
+}));
+
+// Bad input found inline is reported the same way as from the threadpool.
+zlib.gunzip(new Buffer('not gzip data'), common.mustCall(function(err) {
+  assert(err instanceof Error);
+  assert.strictEqual(err.code, 'Z_DATA_ERROR');
+}));
+
+// ...but never from inside write(), where no tick may run yet.
+const gunzip = zlib.createGunzip();
+var wrote = false;
+gunzip.on('error', common.mustCall(function(err) {
+  assert(wrote);
+  assert.strictEqual(err.code, 'Z_DATA_ERROR');
+}));
+gunzip.write(new Buffer('not gzip data'));
+wrote = true;
+
+const env = Object.assign({}, process.env, {
+  NODE_ZLIB_INLINE_THRESHOLD: '0',
+  NODE_ZLIB_COALESCE_WRITES: '1'
+});
+const child = spawnSync(process.execPath, [__filename, 'child'], { env: env });
+assert.strictEqual(child.status, 0, child.stderr.toString());